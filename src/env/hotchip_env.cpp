@@ -0,0 +1,185 @@
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include "hotchip_env.h"
+#include "../interpreter/Chip8.h"
+#include "../interpreter/SaveState.h"
+#include "../interpreter/batch/Chip8Batch.h"
+
+static_assert(HC_ENV_WIDTH == Chip8::kScreenWidth && HC_ENV_HEIGHT == Chip8::kScreenHeight);
+
+namespace {
+    constexpr std::size_t kLanes = Chip8Batch::kMaxLanes;
+    constexpr std::size_t kPackedSize = SaveState::kFrameBufferSize;
+    constexpr std::uint8_t kKeyCount = 16;
+
+    // The 8 pixels of a packed byte (most significant bit first), one byte of 0 or 1 each
+    constexpr std::array<std::uint64_t, 256> kPixels = [] {
+        std::array<std::uint64_t, 256> pixels{};
+
+        for (std::size_t bits{0}; bits < 256; ++bits) {
+            for (std::size_t pixel{0}; pixel < 8; ++pixel) {
+                if (bits >> (7 - pixel) & 1)
+                    pixels[bits] |= std::uint64_t{1} << pixel * 8;
+            }
+        }
+
+        return pixels;
+    }();
+
+    thread_local std::string lastError;
+
+    int fail(const std::string& error) {
+        lastError = error;
+        return -1;
+    }
+}
+
+/*
+ * Instances run in groups of up to 32 lanes of a Chip8Batch, instance i
+ * being lane i % 32 of batch i / 32.
+ */
+struct hc_env {
+    std::uint32_t instances{0};
+    std::vector<std::unique_ptr<Chip8Batch>> batches;
+
+    // By instance: keys held, resets so far (for seeds) and packed screen last observed
+    std::vector<std::uint16_t> keys;
+    std::vector<std::uint32_t> episodes;
+    std::vector<std::uint8_t> packed;
+
+    std::vector<std::uint8_t> observations;
+
+    Chip8Batch& batchOf(std::uint32_t instance) {
+        return *batches[instance / kLanes];
+    }
+
+    static std::size_t laneOf(std::uint32_t instance) {
+        return instance % kLanes;
+    }
+
+    // Start every reset of every instance from a different seed
+    std::uint32_t seedOf(std::uint32_t instance) const {
+        return static_cast<std::uint32_t>(instance + 1 + std::uint64_t{episodes[instance]} * instances);
+    }
+
+    // Unpack an instance's screen into its observation, if it changed since the last one
+    void observe(std::uint32_t instance, bool force) {
+        const std::span<const std::uint8_t> frameBuffer = batchOf(instance).getFrameBuffer(laneOf(instance));
+        std::uint8_t* last = &packed[instance * kPackedSize];
+
+        if (!force && std::memcmp(last, frameBuffer.data(), kPackedSize) == 0)
+            return;
+
+        std::memcpy(last, frameBuffer.data(), kPackedSize);
+        std::uint8_t* observation = &observations[std::size_t{instance} * HC_ENV_OBSERVATION_SIZE];
+
+        for (std::size_t byte{0}; byte < kPackedSize; ++byte)
+            std::memcpy(observation + byte * 8, &kPixels[frameBuffer[byte]], 8);
+    }
+
+    void reset(std::uint32_t instance) {
+        Chip8Batch& batch = batchOf(instance);
+        const std::size_t lane = laneOf(instance);
+
+        batch.reset(lane);
+        batch.setRandomSeed(lane, seedOf(instance));
+        ++episodes[instance];
+
+        keys[instance] = 0;
+        observe(instance, false);
+    }
+};
+
+hc_env* hc_env_create(std::uint32_t n, const char* rom_path) {
+    if (n == 0 || rom_path == nullptr) {
+        fail("An environment needs at least one instance and a ROM");
+        return nullptr;
+    }
+
+    try {
+        auto env = std::make_unique<hc_env>();
+        env->instances = n;
+
+        const Chip8 chip8{rom_path};
+
+        for (std::uint32_t first{0}; first < n; first += kLanes)
+            env->batches.push_back(std::make_unique<Chip8Batch>(chip8, std::min<std::size_t>(n - first, kLanes)));
+
+        env->keys.assign(n, 0);
+        env->episodes.assign(n, 0);
+        env->packed.assign(std::size_t{n} * kPackedSize, 0);
+        env->observations.assign(std::size_t{n} * HC_ENV_OBSERVATION_SIZE, 0);
+
+        for (std::uint32_t instance{0}; instance < n; ++instance) {
+            env->batchOf(instance).setRandomSeed(hc_env::laneOf(instance), env->seedOf(instance));
+            ++env->episodes[instance];
+            env->observe(instance, true);
+        }
+
+        return env.release();
+    } catch (const std::exception& e) {
+        fail(e.what());
+        return nullptr;
+    }
+}
+
+void hc_env_destroy(hc_env* env) {
+    delete env;
+}
+
+int hc_env_step(hc_env* env, const std::uint16_t* keys, std::uint32_t frames) {
+    if (env == nullptr)
+        return fail("No environment");
+
+    // Press and release only the keys which changed, as a keyboard would
+    if (keys != nullptr) {
+        for (std::uint32_t instance{0}; instance < env->instances; ++instance) {
+            const std::uint16_t changed = env->keys[instance] ^ keys[instance];
+
+            if (changed == 0)
+                continue;
+
+            Chip8Batch& batch = env->batchOf(instance);
+
+            for (std::uint8_t key{0}; key < kKeyCount; ++key) {
+                if (changed >> key & 1)
+                    batch.setKeyState(hc_env::laneOf(instance), key, keys[instance] >> key & 1);
+            }
+
+            env->keys[instance] = keys[instance];
+        }
+    }
+
+    for (const std::unique_ptr<Chip8Batch>& batch : env->batches)
+        batch->step(frames);
+
+    for (std::uint32_t instance{0}; instance < env->instances; ++instance)
+        env->observe(instance, false);
+
+    return 0;
+}
+
+int hc_env_reset(hc_env* env, const std::uint8_t* mask) {
+    if (env == nullptr)
+        return fail("No environment");
+
+    for (std::uint32_t instance{0}; instance < env->instances; ++instance) {
+        if (mask == nullptr || mask[instance] != 0)
+            env->reset(instance);
+    }
+
+    return 0;
+}
+
+const std::uint8_t* hc_env_observations(const hc_env* env) {
+    return env != nullptr ? env->observations.data() : nullptr;
+}
+
+const char* hc_env_last_error() {
+    return lastError.c_str();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * C ABI of a batch of headless CHIP-8 instances, for training frameworks
+ * (e.g. Python through ctypes or cffi), built as the hotchip_env shared library.
+ *
+ * Every instance runs the same ROM. One call steps every instance, and the
+ * screens of all of them are kept in one contiguous buffer owned by the
+ * environment, which a caller can view (e.g. as a numpy array of shape
+ * (n, 32, 64)) once, without a copy per step or per instance.
+ *
+ * Functions returning int return 0 on success and -1 on failure, the reason
+ * given by hc_env_last_error(). An environment must be used by one thread at
+ * a time, separate environments may be stepped on separate threads.
+ */
+
+#if defined(_WIN32)
+    #if defined(HC_ENV_BUILDING)
+        #define HC_ENV_API __declspec(dllexport)
+    #else
+        #define HC_ENV_API __declspec(dllimport)
+    #endif
+#else
+    #define HC_ENV_API __attribute__((visibility("default")))
+#endif
+
+// Size of an instance's observation, one byte (0 or 1) per pixel, row by row
+#define HC_ENV_WIDTH 64
+#define HC_ENV_HEIGHT 32
+#define HC_ENV_OBSERVATION_SIZE (HC_ENV_WIDTH * HC_ENV_HEIGHT)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct hc_env hc_env;
+
+/*
+ * Load the ROM at rom_path into n instances, returning NULL on failure.
+ * Instance i draws random numbers seeded with i + 1, reseeded on each reset.
+ */
+HC_ENV_API hc_env* hc_env_create(uint32_t n, const char* rom_path);
+
+HC_ENV_API void hc_env_destroy(hc_env* env);
+
+/*
+ * Hold the keys of keys[i] (bit k for key k) on instance i, then emulate
+ * frames frames of every instance. keys is NULL to keep the keys held.
+ */
+HC_ENV_API int hc_env_step(hc_env* env, const uint16_t* keys, uint32_t frames);
+
+/*
+ * Restart instance i from the loaded ROM where mask[i] is non-zero, or every
+ * instance if mask is NULL. Each reset starts an episode with a new seed.
+ */
+HC_ENV_API int hc_env_reset(hc_env* env, const uint8_t* mask);
+
+/*
+ * Screens of every instance, n * HC_ENV_OBSERVATION_SIZE bytes, instance i
+ * at i * HC_ENV_OBSERVATION_SIZE. The pointer stays valid until the
+ * environment is destroyed, its contents are updated by step and reset.
+ */
+HC_ENV_API const uint8_t* hc_env_observations(const hc_env* env);
+
+// Why the last failing call on this thread failed
+HC_ENV_API const char* hc_env_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
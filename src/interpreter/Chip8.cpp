@@ -1,24 +1,29 @@
 #include <fstream>
 #include <cerrno>
 #include <cstring>
-#include <iostream>
 #include <algorithm>
-#include <imgui.h>
-#include <imgui_impl_sdl2.h>
-#include <chrono>
 #include "Chip8.h"
 
-Chip8::Chip8(MainWindow& window)
-	: m_ROMPath{window.getROM()}
-	, m_window{window}
+// Frontend used when the core is run without a window or audio device
+static HeadlessFrontend headlessFrontend;
+
+Chip8::Chip8(std::string_view ROMPath)
+	: Chip8(ROMPath, headlessFrontend)
+{
+}
+
+Chip8::Chip8(Chip8Frontend& frontend)
+	: m_frontend{&frontend}
+{
+	Logger::instance().registerThread();
+}
+
+Chip8::Chip8(std::string_view ROMPath, Chip8Frontend& frontend)
+	: m_ROMPath{ROMPath}
+	, m_frontend{&frontend}
 {
-    #if defined(_WIN64)
-    	// Initialise high resolution timer on Windows
-		m_winTimerHandle = CreateWaitableTimerExW(nullptr, nullptr,
-			CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
-			TIMER_ALL_ACCESS
-		);
-    #endif
+	// Errors are logged from the frame loop, which must not allocate (see AllocationCounter.h)
+	Logger::instance().registerThread();
 
 	loadROM();
 }
@@ -43,21 +48,32 @@ void Chip8::loadROM() {
 		// Return get pointer to start of file
 		inFS.seekg(0, std::ifstream::beg);
 
+		// Build the initial memory image, then share its pages with
+		// every other instance which loaded the same ROM
+		std::array<std::uint8_t, kMemorySize> image{};
+
 		// Read in ROM to emulated memory, offsetting by 512 bytes.
 		// The initial 512 bytes of the Chip-8 memory was used to store
 		// the interpreter code in the original hardware.
-		inFS.read(reinterpret_cast<char*>(m_memory.begin() + kROMOffset), m_ROMSize);
+		inFS.read(reinterpret_cast<char*>(image.data() + kROMOffset), m_ROMSize);
 
 		// Initialise font data. Start font data in position 0x50 (+80 bytes) as is conventional.
-		std::copy(kFontData.begin(), kFontData.end(), m_memory.begin() + kFontOffset);
+		std::copy(kFontData.begin(), kFontData.end(), image.begin() + kFontOffset);
+
+		m_memory.assign(image);
+		m_loadedMemory = m_memory;
+
+		// Memory has been rewritten, previously decoded instructions are stale
+		invalidateDecodeCache();
+
+		m_aotProgram = findAotProgram(std::span{image}.subspan(kROMOffset, m_ROMSize));
 	} else {
 		throw std::runtime_error("Error opening ROM: " + m_ROMPath + ", " + std::strerror(errno));
 	}
 }
 
 void Chip8::resetEmulator() {
-	// Reset memory and registers
-	m_memory.clear();
+	// Reset registers, memory is restored by the caller
 	m_registers.clear();
 	m_index = 0;
 	m_PC = kROMOffset;
@@ -71,7 +87,73 @@ void Chip8::resetEmulator() {
 	m_delayTimer.reset();
 
 	// Clear framebuffer
-	m_window.clearDisplay();
+	clearDisplay();
+
+	// Release keypad and stop any pending AWAIT_KEY
+	m_keyStates = 0;
+	m_awaitingKey = false;
+	m_awaitingKeyPressed = false;
+	m_awaitingKeyRegNum = 0;
+
+	m_finished = false;
+	m_frameCount = 0;
+	m_instructionCount = 0;
+	m_frameAllocations = 0;
+	m_faults = Faults{};
+}
+
+void Chip8::openROM(std::string_view ROMPath) {
+	// Update ROM file path with new path requested
+	m_ROMPath = ROMPath;
+
+	// Reset emulator state and load ROM
+	resetEmulator();
+	m_memory.clear();
+	loadROM();
+}
+
+void Chip8::openROM(std::span<const std::uint8_t> ROM) {
+	if (ROM.size() > kMemorySize - kROMOffset)
+		throw std::runtime_error("ROM size exceeds maximum of 3584 bytes");
+
+	std::array<std::uint8_t, kMemorySize> image{};
+	std::ranges::copy(ROM, image.begin() + kROMOffset);
+	std::ranges::copy(kFontData, image.begin() + kFontOffset);
+
+	// Pages are written rather than interned, the pool would keep every
+	// page of every ROM opened (a fuzzer opens millions)
+	PagedGuestMemory<kMemorySize, MemoryBounds> loaded{m_loadedMemory};
+
+	for (std::size_t page{0}; page < loaded.kPageCount; ++page) {
+		const std::span<const std::uint8_t, kMemoryPageSize> data =
+			std::span{image}.subspan(page * kMemoryPageSize).first<kMemoryPageSize>();
+
+		if (!std::ranges::equal(loaded.getPage(page), data))
+			loaded.writePage(page, data);
+	}
+
+	resetEmulator();
+
+	// Keeps what was cached of the bytes which are the same in both ROMs
+	shareMemory(loaded);
+	m_loadedMemory = loaded;
+
+	m_ROMSize = static_cast<std::uint16_t>(ROM.size());
+	m_ROMPath.clear();
+
+	const AotProgram* program = findAotProgram(ROM);
+
+	if (program != m_aotProgram) {
+		m_aotProgram = program;
+		m_aotBlocks.reset();
+	}
+}
+
+void Chip8::reset() {
+	resetEmulator();
+
+	// Pages which were never written still share the loaded ones
+	shareMemory(m_loadedMemory);
 }
 
 void Chip8::decode(std::uint16_t instruction) {
@@ -149,280 +231,548 @@ void Chip8::decode(std::uint16_t instruction) {
             break;
 		default:
 			if (kDebugEnabled)
-				std::cout << "[DEBUG] Unknown opcode: " << instruction << std::endl;
+				logMessage(LogLevel::Debug, "Unknown opcode: {}", instruction);
 	}
 }
 
-void Chip8::start() {
-	#if defined(_WIN64)
-		// Request Windows to allow this program to use higher precision sleep timing.
-		timeBeginPeriod(1);
-	#endif
+void Chip8::setEngine(Engine engine) {
+	m_engine = engine;
+}
+
+Chip8::Engine Chip8::getEngine() const {
+	return m_engine;
+}
 
-	// Run emulator until window closes
-	while (!m_windowClosed) {
-		executionLoop();
+std::optional<Chip8::Engine> Chip8::parseEngine(std::string_view name) {
+	for (std::size_t engine{0}; engine < kEngineNames.size(); ++engine) {
+		if (kEngineNames[engine] == name)
+			return static_cast<Engine>(engine);
+	}
 
-		/*
-		 * If the last emulation ended but the window didn't close,
-		 * we know the emulation ended because the user
-		 * requested a new ROM to be loaded.
-		*/
-		if (!m_windowClosed) {
-			// Update ROM file path with new path requested
-			m_ROMPath = m_window.getROM();
-
-			// Reset emulator state and load ROM
-			resetEmulator();
-			loadROM();
-		}
+	return std::nullopt;
+}
+
+void Chip8::step(std::uint32_t frames) {
+	for (std::uint32_t frame{0}; frame < frames; ++frame) {
+		const std::uint64_t allocationsBefore = allocationCount();
+		executeFrame();
+		m_frameAllocations = allocationCount() - allocationsBefore;
 	}
 }
 
-void Chip8::executionLoop() {
+void Chip8::executeFrame() {
+	executeInstructions(kInstructionsPerFrame);
+	finishFrame();
+}
+
+std::uint16_t Chip8::executeInstructions(std::uint16_t budget) {
 	// The memory location of the ROM's final valid instruction
 	// Subtract two since instructions are two bytes in size.
 	const std::uint16_t finalInstruction {
 		static_cast<std::uint16_t>(kROMOffset + m_ROMSize - 2)
 	};
 
-	// Whether all instructions have been executed
-	bool finished = false;
+	// The threaded engine counts down to the budget after executing an instruction
+	if (budget == 0)
+		return 0;
 
-	// Fetch/decode/execute loop
-	while (!m_windowClosed) {
-		// * frame begins here *
-		const auto frameStart = std::chrono::steady_clock::now();
+	budget = std::min(budget, kInstructionsPerFrame);
+	std::uint16_t instructionsExecuted{0};
 
-		// Check if user has loaded a new ROM
-		if (m_ROMPath != m_window.getROM()) {
-			return;
-		}
+	switch (m_engine) {
+		case Engine::Decode:
+			instructionsExecuted = runDecodeEngine(finalInstruction, budget);
+			break;
+		case Engine::PreDecoded:
+			instructionsExecuted = runPreDecodedEngine(finalInstruction, budget);
+			break;
+		case Engine::Threaded:
+			instructionsExecuted = runThreadedEngine(finalInstruction, budget);
+			break;
+		case Engine::JIT:
+			instructionsExecuted = runJitEngine(finalInstruction, budget);
+			break;
+		case Engine::AOT:
+			instructionsExecuted = runAotEngine(finalInstruction, budget);
+			break;
+		case Engine::Specialized:
+			instructionsExecuted = runSpecializedEngine(finalInstruction, budget);
+			break;
+	}
 
-		if (finished) {
-			// Sleep until the user closes the window
-			SDL_WaitEvent(&m_event);
+	m_instructionCount += instructionsExecuted;
+	return instructionsExecuted;
+}
 
-			if (m_event.type == SDL_QUIT) {
-				m_windowClosed = true;
-				return;
-			}
-		} else {
-			// Get user inputs to update keyboard state at frame start
-			while (SDL_PollEvent(&m_event)) {
-				// Pass event to ImGUI
-				ImGui_ImplSDL2_ProcessEvent(&m_event);
-
-				// Scancode of key (zero if event is not a keypress)
-				SDL_Scancode& scanCode = m_event.key.keysym.scancode;
-
-				// Terminate execution on window close event
-				if (m_event.type == SDL_QUIT) {
-					m_windowClosed = true;
-					return;
-				}
+void Chip8::finishFrame() {
+	// Present frame (no change if no draw/clear calls made)
+	if (m_frameBufferModified) {
+		m_frontend->presentFrame(m_frameBuffer);
+		m_frameBufferModified = false;
+	}
 
-				// Update key state to pressed
-				if (m_event.type == SDL_KEYDOWN) {
-					setKeyState(scanCode, true);
-
-					/*
-					 * If AWAIT_KEY was called and a key hasn't been pressed previously,
-					 * save the scancode of this pressed key to await release.
-					 */
-					if (m_awaitingKey && m_awaitingScanCode == kNULLScanCode)
-						m_awaitingScanCode = scanCode;
-
-				// Update key state to not pressed
-				} else if (m_event.type == SDL_KEYUP) {
-					setKeyState(scanCode, false);
-
-					/*
-					 * If AWAIT_KEY was called and a key has been pressed,
-					 * update VX to the released key's value.
-					 */
-					if (m_awaitingKey && m_awaitingScanCode != kNULLScanCode) {
-						std::uint8_t& VX = m_registers[m_awaitingKeyRegNum];
-						VX = scanCodeToPos(scanCode);
-
-						// Restore variables for next AWAIT_KEY call
-						m_awaitingKey = false;
-						m_awaitingScanCode = kNULLScanCode;
-					}
-				}
-			}
-		}
+	/*
+	 * CHIP-8's timers decrement at the same pace as the framerate.
+	 * Therefore, we tick each timer once per frame.
+	 */
+	const bool wasBeeping = m_soundTimer.isBeeping();
 
-		// Count the number of instructions executed per frame for timing emulation (IPF)
-		std::uint16_t instructionsExecuted{0};
-
-		// Execute a certain number of instructions per frame (~12).
-		// Don't continue execution if we're currently awaiting a key press in AWAIT_KEY instruction.
-		while (instructionsExecuted < kInstructionsPerFrame && !m_awaitingKey) {
-            if (m_PC > finalInstruction) {
-                // All instructions have completed
-                finished = true;
-            } else if (m_PC + 1 < kMemorySize) {
-                /*
-                 * Fetch instruction:
-                 * Our memory is 8 bits, but an instruction is 16 bits.
-                 * We concatenate the byte at PC with the byte that follows to form one std::uint16_t
-                 */
-                std::uint16_t instruction = static_cast<std::uint16_t>(m_memory[m_PC]) << 8 | m_memory[m_PC + 1];
-                decode(instruction);
-
-            	// Increment instruction count
-            	instructionsExecuted++;
-
-                // Do not increment PC for jump or return instructions
-                if (!m_PCUpdated)
-                    // Increment PC by 2 as instructions are two bytes in size
-                    m_PC += 2;
-            } else {
-                throw std::runtime_error(
-                    "Cannot run out-of-bounds instruction at position: "
-                    + std::to_string(m_PC) + "."
-                );
-            }
+	m_delayTimer.tickTimer();
+	m_soundTimer.tickTimer();
+
+	if (m_soundTimer.isBeeping() != wasBeeping)
+		m_frontend->setBeeping(m_soundTimer.isBeeping());
+
+	++m_frameCount;
+}
+
+std::uint16_t Chip8::runDecodeEngine(std::uint16_t finalInstruction, std::uint16_t budget) {
+	// Count the number of instructions executed per frame for timing emulation (IPF)
+	std::uint16_t instructionsExecuted{0};
+
+	// Execute the budget of instructions, a frame's worth (~12) unless emulating part of one.
+	// Don't continue execution if we're currently awaiting a key press in AWAIT_KEY instruction.
+	while (instructionsExecuted < budget && !m_awaitingKey && !m_finished) {
+		if (m_PC > finalInstruction) {
+			// All instructions have completed
+			m_finished = true;
+		} else if (m_PC + 1 < kMemorySize) {
+			/*
+			 * Fetch instruction:
+			 * Our memory is 8 bits, but an instruction is 16 bits.
+			 * We concatenate the byte at PC with the byte that follows to form one std::uint16_t
+			 */
+			std::uint16_t instruction = m_memory.getView().word(m_PC);
+			const std::uint16_t instructionAddress = m_PC;
+			decode(instruction);
+
+			// Increment instruction count
+			instructionsExecuted++;
+
+			// Do not increment PC for jump or return instructions
+			if (!m_PCUpdated)
+				// Increment PC by 2 as instructions are two bytes in size
+				m_PC += 2;
+
+			// Record the instruction for the debug UI, formatted only when displayed
+			InstructionTrace trace{m_frameCount, instructionAddress, instruction, m_PC, m_index, {}};
+			std::ranges::copy(m_registers.getDataView(), trace.registers.begin());
+			m_frontend->pushInstructionTrace(trace);
+		} else {
+			throw std::runtime_error(
+				"Cannot run out-of-bounds instruction at position: "
+				+ std::to_string(m_PC) + "."
+			);
 		}
+	}
 
-		// Create struct to pass read-only debug info to Window
-		Chip8DebugData debugInfo {
-			m_memory.getDataView(),
-			m_registers.getDataView(),
-			m_PC,
-			m_index
-		};
+	return instructionsExecuted;
+}
 
-		// Render frame (no change if no draw/clear calls made)
-		m_window.render();
+void Chip8::setKeyState(std::uint8_t key, bool pressed) {
+	const auto keyBit = static_cast<std::uint16_t>(1 << (key & kNibbleMask));
+	m_keyStates = static_cast<std::uint16_t>(pressed ? m_keyStates | keyBit : m_keyStates & ~keyBit);
 
-		// Render ImGUI UI
-		m_window.drawUI(debugInfo);
+	if (!m_awaitingKey)
+		return;
 
+	if (pressed) {
 		/*
-		 * CHIP-8's timers decrement at the same pace as the framerate.
-		 * Therefore, we tick each timer once per frame.
+		 * If AWAIT_KEY was called and a key hasn't been pressed previously,
+		 * remember that a key was pressed to await release.
 		 */
-		m_delayTimer.tickTimer();
-		m_soundTimer.tickTimer();
-
+		m_awaitingKeyPressed = true;
+	} else if (m_awaitingKeyPressed) {
 		/*
-		 * Busy waiting logic is derived from Dolphin Emulator:
-		 * (permissible under GPL-2.0-or-later)
-		 * https://github.com/dolphin-emu/dolphin/blob/master/Source/Core/Common/Timer.cpp
-		 *
-		 * Windows implementation is informed by Blat Blatnik's research on high-accuracy sleep:
-		 * https://blog.bearcats.nl/perfect-sleep-function/
+		 * If AWAIT_KEY was called and a key has been pressed,
+		 * update VX to the released key's value.
 		 */
+		m_registers[m_awaitingKeyRegNum] = key & kNibbleMask;
 
-		 /*
-		 * 1 millisecond of spin time seems like a good balance between
-		 * accuracy and performance on both Windows and Linux.
-		 */
-		constexpr auto spinDuration = std::chrono::milliseconds{1};
-
-		// The expected end time of the frame
-		const auto frameEnd = frameStart + kFrameDuration;
-
-		// Actual end time of the frame
-		const auto frameComplete = std::chrono::steady_clock::now();
-
-		// If the frame completed with time to spare, sleep until the next frame
-		if (frameComplete < frameEnd) {
-			#if defined(_WIN64)
-				// SetWaitableTimerEx takes time in "100 nanosecond intervals". (Credit: Dolphin)
-				using winTimeFormat = std::chrono::duration<LONGLONG, std::ratio<100, std::nano::den>::type>;
-
-				/*
-				 * From Blat Blatnik's blog:
-				 *
-				 * "Also, [CreateWaitableTimerEx] has a quirk that if you request a sleep
-				 * period longer than the system timer period, the precision of the timer plummets."
-				 *
-				 * We limit the sleep to 95% of the time period to avoid this quirk.
-				 */
-				constexpr auto kMaxTicks =
-					duration_cast<winTimeFormat>(spinDuration) * 95 / 100;
-
-				/*
-				 * Loop using high precision sleep until end of frame is reached,
-				 * to avoid oversleep and achieve high accuracy.
-				 */
-				while (true) {
-					const auto timeNow = std::chrono::steady_clock::now();
-					const auto sleepDuration = frameEnd - timeNow - spinDuration;
-
-					// Limit maximum sleep duration to kMaxTicks (95% of 1 millisecond)
-					const auto ticks = std::min(
-						duration_cast<winTimeFormat>(sleepDuration), kMaxTicks
-					).count();
-
-					if (ticks <= 0)
-						// Sleep time has finished, spin the rest
-						break;
-
-					// Negate ticks to make Windows use relative time
-					const LARGE_INTEGER due_time{.QuadPart = -ticks};
-					SetWaitableTimerEx(
-						m_winTimerHandle, &timerDue, 0, nullptr,
-						nullptr, nullptr, 0
-					);
-
-					// Wait for timer. Use INFINITE to disable timeout.
-					WaitForSingleObject(m_winTimerHandle, INFINITE);
-				}
-			#else
-				// sleep_until on Linux provides high accuracy
-				const auto sleepPoint = frameEnd - spinDuration;
-
-				std::this_thread::sleep_until(sleepPoint);
-			#endif
-
-			// Report oversleeps for debugging
-			if (kDebugEnabled) {
-				const auto timeNow = std::chrono::steady_clock::now();
-
-				if (timeNow > frameEnd) {
-					// The amount of microseconds overslept by
-					const auto oversleepDuration =
-						std::chrono::duration_cast<std::chrono::microseconds>(
-							timeNow - frameEnd
-						).count();
-
-					std::cout <<
-						"[DEBUG] Overslept! " << oversleepDuration << " microseconds late."
-					<< std::endl;
-				}
+		// Restore variables for next AWAIT_KEY call
+		m_awaitingKey = false;
+		m_awaitingKeyPressed = false;
+	}
+}
+
+void Chip8::saveState(SaveState& state) const {
+	static_assert(SaveState::kMemorySize == kMemorySize);
+
+	m_memory.copyTo(state.memory);
+	saveRegisters(state);
+}
+
+void Chip8::saveState(SaveState& state, Memory& saved) const {
+	for (std::size_t page{0}; page < m_memory.kPageCount; ++page) {
+		// A page both hold is unchanged, never written in place while shared
+		if (saved.sharesPage(m_memory, page))
+			continue;
+
+		std::ranges::copy(m_memory.getPage(page), state.memory.begin() + page * kMemoryPageSize);
+		saved.share(m_memory, page);
+	}
+
+	saveRegisters(state);
+}
+
+void Chip8::saveRegisters(SaveState& state) const {
+	state.frameBuffer = m_frameBuffer;
+
+	std::ranges::copy(m_registers.getDataView(), state.registers.begin());
+	state.stack = m_stack;
+	state.stackSize = m_stackSize;
+	state.PC = m_PC;
+	state.index = m_index;
+	state.ROMSize = m_ROMSize;
+
+	state.delayTimer = m_delayTimer.getTimer();
+	state.soundTimer = m_soundTimer.getTimer();
+	state.beeping = m_soundTimer.isBeeping();
+
+	state.keyStates = m_keyStates;
+	state.awaitingKey = m_awaitingKey;
+	state.awaitingKeyPressed = m_awaitingKeyPressed;
+	state.awaitingKeyRegNum = m_awaitingKeyRegNum;
+
+	state.randomState = m_random.getState();
+
+	state.finished = m_finished;
+	state.frameCount = m_frameCount;
+	state.instructionCount = m_instructionCount;
+}
+
+void Chip8::loadState(const SaveState& state) {
+	restoreMemory(state.memory);
+
+	m_frameBuffer = state.frameBuffer;
+	m_frameBufferModified = true;
+
+	std::ranges::copy(state.registers, m_registers.begin());
+	m_stack = state.stack;
+	m_stackSize = state.stackSize;
+	m_PC = state.PC;
+	m_index = state.index;
+	m_ROMSize = state.ROMSize;
+
+	m_delayTimer.setTimer(state.delayTimer);
+	m_soundTimer.setTimer(state.soundTimer);
+
+	if (m_soundTimer.isBeeping() != state.beeping) {
+		m_soundTimer.setBeeping(state.beeping);
+		m_frontend->setBeeping(state.beeping);
+	}
+
+	m_keyStates = state.keyStates;
+	m_awaitingKey = state.awaitingKey;
+	m_awaitingKeyPressed = state.awaitingKeyPressed;
+	m_awaitingKeyRegNum = state.awaitingKeyRegNum;
+
+	m_random.setSeed(state.randomState);
+
+	m_finished = state.finished;
+	m_frameCount = state.frameCount;
+	m_instructionCount = state.instructionCount;
+}
+
+void Chip8::restoreMemory(std::span<const std::uint8_t, kMemorySize> memory) {
+	/*
+	 * Only store the bytes which differ, invalidating their decoded instructions,
+	 * traces and recompiled blocks as a write by the ROM would. States of the
+	 * same session mostly differ in data, so the code caches stay warm, and
+	 * pages without changes stay shared.
+	 */
+	const bool cached = m_decodeCache || m_jit || m_aotBlocks;
+	constexpr std::uint16_t kCompareSize = 64;
+
+	for (std::size_t page{0}; page < m_memory.kPageCount; ++page) {
+		const std::span<const std::uint8_t, kMemoryPageSize> current = m_memory.getPage(page);
+		const std::span<const std::uint8_t, kMemoryPageSize> restored =
+			memory.subspan(page * kMemoryPageSize).first<kMemoryPageSize>();
+
+		if (std::memcmp(current.data(), restored.data(), kMemoryPageSize) == 0)
+			continue;
+
+		// Nothing cached from memory yet
+		if (!cached) {
+			m_memory.writePage(page, restored);
+			continue;
+		}
+
+		const auto base = static_cast<std::uint16_t>(page * kMemoryPageSize);
+
+		for (std::uint16_t chunk{0}; chunk < kMemoryPageSize; chunk += kCompareSize) {
+			// The first store may have copied the page, look it up again
+			const std::span<const std::uint8_t, kMemoryPageSize> bytes = m_memory.getPage(page);
+
+			if (std::memcmp(&bytes[chunk], &restored[chunk], kCompareSize) == 0)
+				continue;
+
+			for (std::uint16_t offset = chunk; offset < chunk + kCompareSize; ++offset) {
+				if (m_memory[base + offset] != restored[offset])
+					storeMemory(base + offset, restored[offset]);
 			}
+		}
+	}
+}
+
+void Chip8::shareMemory(const PagedGuestMemory<kMemorySize, MemoryBounds>& memory) {
+	const bool cached = m_decodeCache || m_jit || m_aotBlocks;
 
-			// Spin for the remaining time
-			while (std::chrono::steady_clock::now() < frameEnd) {
-				#if defined(_WIN32)
-					YieldProcessor();
-				#else
-					std::this_thread::yield();
-				#endif
+	for (std::size_t page{0}; page < m_memory.kPageCount; ++page) {
+		if (m_memory.sharesPage(memory, page))
+			continue;
+
+		if (cached) {
+			const std::span<const std::uint8_t, kMemoryPageSize> current = m_memory.getPage(page);
+			const std::span<const std::uint8_t, kMemoryPageSize> shared = memory.getPage(page);
+			const auto base = static_cast<std::uint16_t>(page * kMemoryPageSize);
+
+			// Compared 8 bytes at a time, pages mostly differ in a few bytes
+			for (std::uint16_t chunk{0}; chunk < kMemoryPageSize; chunk += 8) {
+				if (std::memcmp(&current[chunk], &shared[chunk], 8) == 0)
+					continue;
+
+				for (std::uint16_t offset = chunk; offset < chunk + 8; ++offset) {
+					if (current[offset] != shared[offset])
+						invalidateCachedByte(base + offset);
+				}
 			}
-		} else if (kDebugEnabled) {
-			// The amount of milliseconds the frame was late by
-			const auto frameLag =
-				std::chrono::duration_cast<std::chrono::milliseconds>(
-					frameComplete - frameEnd
-				).count();
-
-			std::cout <<
-				"[DEBUG] Slow frame! " << frameLag << " milliseconds late."
-			<< std::endl;
 		}
+
+		m_memory.share(memory, page);
 	}
 }
 
-Chip8::~Chip8() {
-	#if defined(_WIN32)
-		CloseHandle(m_winTimerHandle);
+Chip8 Chip8::fork() const {
+	Chip8 copy{headlessFrontend};
+	cloneInto(copy);
+	return copy;
+}
+
+void Chip8::cloneInto(Chip8& other) const {
+	if (&other == this)
+		return;
+
+	// Hot state, one cache line
+	other.m_registers = m_registers;
+	other.m_stack = m_stack;
+	other.m_random = m_random;
+	other.m_PC = m_PC;
+	other.m_index = m_index;
+	other.m_keyStates = m_keyStates;
+	other.m_stackSize = m_stackSize;
+	other.m_PCUpdated = m_PCUpdated;
+	other.m_awaitingKey = m_awaitingKey;
+	other.m_finished = m_finished;
+
+	// Recompiled blocks are only valid for the program they were created for
+	if (other.m_aotProgram != m_aotProgram) {
+		other.m_aotProgram = m_aotProgram;
+		other.m_aotBlocks.reset();
+	}
+
+	// Share every page, discarding what the other machine cached from the pages it had
+	other.shareMemory(m_memory);
+	other.m_loadedMemory = m_loadedMemory;
+
+	other.m_ROMSize = m_ROMSize;
+
+	// Reuses the string's storage, no allocation when cloning repeatedly
+	other.m_ROMPath = m_ROMPath;
+
+	other.m_delayTimer = m_delayTimer;
+	other.m_soundTimer.setTimer(m_soundTimer.getTimer());
+
+	if (other.m_soundTimer.isBeeping() != m_soundTimer.isBeeping()) {
+		other.m_soundTimer.setBeeping(m_soundTimer.isBeeping());
+		other.m_frontend->setBeeping(m_soundTimer.isBeeping());
+	}
+
+	other.m_frameBuffer = m_frameBuffer;
+	other.m_frameBufferModified = true;
+
+	other.m_frameCount = m_frameCount;
+	other.m_instructionCount = m_instructionCount;
+	other.m_frameAllocations = m_frameAllocations;
+	other.m_faults = m_faults;
+
+	other.m_awaitingKeyPressed = m_awaitingKeyPressed;
+	other.m_awaitingKeyRegNum = m_awaitingKeyRegNum;
+	other.m_engine = m_engine;
+}
+
+void Chip8::setRandomSeed(std::uint32_t seed) {
+	m_random.setSeed(seed);
+}
+
+void Chip8::writeMemory(std::uint16_t address, std::uint8_t value) {
+	storeMemory(address, value);
+}
+
+void Chip8::storeMemory(std::uint16_t address, std::uint8_t value) {
+	m_memory.write(address, value);
+
+	// Invalidate the byte actually written, masked memory wraps the address
+	address = m_memory.wrap(address);
+
+	// Out-of-bounds writes are discarded by CheckedBounds, nothing to invalidate
+	if (address >= kMemorySize)
+		return;
+
+	invalidateCachedByte(address);
+}
 
-		// Restore timer resolution
-		timeBeginPeriod(1);
-	#endif
-}
\ No newline at end of file
+void Chip8::invalidateCachedByte(std::uint16_t address) {
+	if (m_jit)
+		m_jit->invalidate(address);
+
+	if (m_aotBlocks)
+		m_aotBlocks->invalidate(address);
+
+	if (!m_decodeCache)
+		return;
+
+	/*
+	 * Only entries starting at most kMaxFusedBytes before this byte contain
+	 * the written value: the instruction at this byte or the one before it,
+	 * or a superinstruction fusing one of them. Writes to data leave the
+	 * cache untouched.
+	 */
+	constexpr std::uint16_t kMaxFusedBytes = 5;
+	const std::uint16_t first = address > kMaxFusedBytes ? address - kMaxFusedBytes : 0;
+
+	for (std::uint16_t entry = first; entry <= address; ++entry)
+		(*m_decodeCache)[entry].op = MicroOp::UNDECODED;
+}
+
+void Chip8::invalidateDecodeCache() {
+	if (m_decodeCache)
+		m_decodeCache->fill(DecodedInstruction{});
+
+	if (m_jit)
+		m_jit->flush();
+
+	// Re-enables self-modified blocks
+	m_aotBlocks.reset();
+}
+
+void Chip8::clearDisplay() {
+	// Zero out framebuffer to completely clear it
+	m_frameBuffer.fill(0);
+
+	// Update frame
+	m_frameBufferModified = true;
+}
+
+bool Chip8::drawRow(int x_index, int y_index, std::uint8_t rowData) {
+	// Framebuffer has been modified, pixels await being drawn
+	m_frameBufferModified = true;
+
+	return drawSpriteRow(m_frameBuffer, x_index, y_index, rowData);
+}
+
+// Start a position x, XOR x and the 7 following bits with rowData.
+// If the next 7 bits are in the following byte, continue flipping bits
+// in the second byte until the sprite byte is drawn.
+bool Chip8::drawSpriteRow(
+	std::span<std::uint8_t, kPackedPixelCount> frameBuffer, int x_index, int y_index, std::uint8_t rowData
+) {
+	// If position values exceed screen limits, wrap around.
+	x_index %= kScreenWidth;
+	y_index %= kScreenHeight;
+
+	// Return true if any set bit becomes unset
+	bool bitUnset = false;
+
+	// Y position is multiplied by the pitch (bytes per row)
+	// Then we add the floor division of index / 8 to find the pixel's
+	// corresponding byte (8 pixels per byte)
+	std::uint8_t pos = (kScreenPitch * y_index) + x_index / 8;
+
+	// Determine bit index within byte
+	std::uint8_t bitPos = x_index % 8;
+
+	// Create XOR mask for first byte (unused bits are unset)
+	std::uint8_t firstXOR = rowData >> bitPos;
+	std::uint8_t& row = frameBuffer[pos];
+
+	// AND the current row with the mask.
+	// If two bits match, a set bit is flipped,
+	// making the AND operation nonzero.
+	if ((row & firstXOR) != 0) {
+		bitUnset = true;
+	}
+
+	// XOR the first byte to flip pixels
+	row ^= firstXOR;
+
+	// The starting bit wasn't at the beginning of a byte,
+	// we must continue flipping bits in the next byte
+	// to complete the drawing of the sprite byte.
+	if (bitPos != 0) {
+		// Set up new mask
+		std::uint8_t secondXOR = rowData << (8 - bitPos);
+
+		// Move to the next byte
+		++pos;
+		std::uint8_t& nextRow = frameBuffer[pos];
+
+		if ((nextRow & secondXOR) != 0) {
+			bitUnset = true;
+		}
+
+		// XOR the second byte to flip pixels
+		nextRow ^= secondXOR;
+	}
+
+	return bitUnset;
+}
+
+Chip8DebugData Chip8::getDebugData() {
+	// Create struct to pass read-only debug info
+	if (!m_debugMemory)
+		m_debugMemory = std::make_unique<std::array<std::uint8_t, kMemorySize>>();
+
+	// The memory editor shows contiguous bytes, edits go through writeMemory
+	m_memory.copyTo(*m_debugMemory);
+
+	return Chip8DebugData {
+		*m_debugMemory,
+		m_registers.getDataView(),
+		m_frameBuffer,
+		m_PC,
+		m_index,
+		m_frameAllocations,
+		[this](std::uint16_t address, std::uint8_t value) {
+			writeMemory(address, value);
+		}
+	};
+}
+
+std::span<const std::uint8_t> Chip8::getFrameBuffer() const {
+	return m_frameBuffer;
+}
+
+std::string_view Chip8::getROMPath() const {
+	return m_ROMPath;
+}
+
+std::uint64_t Chip8::getFrameCount() const {
+	return m_frameCount;
+}
+
+std::uint64_t Chip8::getInstructionCount() const {
+	return m_instructionCount;
+}
+
+std::uint64_t Chip8::getFrameAllocations() const {
+	return m_frameAllocations;
+}
+
+const Chip8::Faults& Chip8::getFaults() const {
+	return m_faults;
+}
+
+bool Chip8::isFinished() const {
+	return m_finished;
+}
@@ -1,13 +1,25 @@
 #pragma once
 
 #include <array>
-#include <random>
-#include <bitset>
-#include <format>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <optional>
+#include <utility>
+#include <stdexcept>
+#include <string_view>
+#include "Chip8Frontend.h"
+#include "Chip8DebugData.h"
+#include "SaveState.h"
+#include "MicroOp.h"
+#include "jit/JitCompiler.h"
+#include "aot/AotProgram.h"
 #include "timers/SoundTimer.h"
 #include "timers/DelayTimer.h"
-#include "../utils/SafeArray.h"
-#include "../window/MainWindow.h"
+#include "../utils/GuestMemory.h"
+#include "../utils/PagedMemory.h"
+#include "../utils/Xorshift32.h"
+#include "../utils/AllocationCounter.h"
 
 // Compile with -DDEBUG for debug output
 #ifdef DEBUG
@@ -16,13 +28,70 @@
     inline constexpr bool kDebugEnabled = false;
 #endif
 
-// For Windows platform-specific timing
-#if defined(_WIN64)
-	#include <Windows.h>
-	#include <timeapi.h>
+// Bounds policy of emulated memory, selected with -DHOTCHIP_MEMORY_BOUNDS (see GuestMemory.h)
+#if defined(HOTCHIP_MEMORY_BOUNDS_MASKED)
+    using MemoryBounds = MaskedBounds;
+#elif defined(HOTCHIP_MEMORY_BOUNDS_UNCHECKED)
+    using MemoryBounds = UncheckedBounds;
+#else
+    using MemoryBounds = CheckedBounds;
 #endif
 
 class Chip8 {
+    public:
+        // Resolution of the emulated display
+        static constexpr int kScreenWidth = 64;
+        static constexpr int kScreenHeight = 32;
+
+        // Divide pixel count by 8 for byte amount. (8 pixels per byte)
+        static constexpr int kPackedPixelCount = kScreenWidth * kScreenHeight / 8;
+        static constexpr int kScreenPitch = kScreenWidth / 8;
+
+        // Amount of emulated registers
+        static constexpr std::uint8_t kRegisterAmount = 16;
+
+        // Use constant instructions per frame (IPF) for now
+        static constexpr std::uint16_t kInstructionsPerFrame = 22;
+
+        // Interpreter engines, selectable before or between calls to step()
+        enum class Engine : std::uint8_t {
+            // Decode every instruction with decode() and the opcodeN() handlers.
+            // Reports instruction history to the frontend.
+            Decode,
+            // Execute micro-ops from a cache of pre-decoded instructions,
+            // only re-decoding code which has been overwritten.
+            PreDecoded,
+            // Pre-decoded micro-ops, threaded: every handler jumps straight
+            // to the next instruction's handler through a dispatch table.
+            Threaded,
+            // Translate basic blocks into native x86-64 code, interpreting
+            // instructions which aren't compiled. Threaded on other hosts.
+            JIT,
+            // Run code statically recompiled by hotchip-aot, interpreting
+            // computed jumps and self-modified code. Threaded for ROMs
+            // without a recompiled program.
+            AOT,
+            // Dispatch each 16 bit instruction word straight to a handler
+            // specialised for it at compile time, with constant operands.
+            // Needs HOTCHIP_SPECIALIZED_TABLE, threaded otherwise.
+            Specialized
+        };
+
+        // Command line names of each engine, in Engine order
+        static constexpr std::array<std::string_view, 6> kEngineNames = {
+            "decode", "predecoded", "threaded", "jit", "aot", "specialized"
+        };
+
+        // ROM errors the interpreter recovered from since the ROM was loaded,
+        // counted by every engine (out-of-bounds accesses: see CheckedBounds)
+        struct Faults {
+            // CALL with 16 return addresses on the stack, skipped
+            std::uint64_t stackOverflows{0};
+            // RETURN with an empty stack, skipped
+            std::uint64_t emptyReturns{0};
+        };
+
+    private:
     // Character representations for 0-9 + A-F
     // https://tobiasvl.github.io/blog/write-a-chip-8-emulator/#font
     static constexpr std::array<std::uint8_t, 80> kFontData = {
@@ -58,9 +127,6 @@ class Chip8 {
     // The bit length of a nibble
     static constexpr std::uint8_t kNibbleLength = 4;
 
-    // Amount of emulated registers
-    static constexpr std::uint8_t kRegisterAmount = 16;
-
     // The value used with AND on a 16 bit instruction to obtain a nibble
     // 00001111 in binary
     static constexpr std::uint8_t kNibbleMask = 0xF;
@@ -78,83 +144,167 @@ class Chip8 {
     // 10000000 in binary
     static constexpr std::uint16_t kMSBMask = 0x80;
 
-    // Use constant instructions per frame (IPF) for now
-    static constexpr std::uint16_t kInstructionsPerFrame = 22;
-
-    // Assume 60fps constant frame timing for now.
-    static constexpr auto kFrameDuration = std::chrono::duration<double>(1.0 / 60.0);
+    /*
+     * Hot machine state, used by nearly every instruction. Packed into the
+     * first cache line of the object, so an instance's working set is this
+     * line, the memory it executes and its decode cache. Keeps many instances
+     * per core in cache (see hotchip-bench --instances).
+     */
 
-    // Handle to waitable timer object for Windows
-    #if defined(_WIN64)
-        HANDLE m_winTimerHandle = nullptr;
-    #endif
+    // Registers 0-9 + A-F (16 total).
+    // Register numbers are nibbles, so masking never changes them and is free.
+    alignas(64) GuestMemory<kRegisterAmount, MaskedBounds> m_registers{};
 
-    // m_ROMPath contains the file path of the currently loaded ROM.
-    std::string m_ROMPath;
+    // Stack, just for subroutine return addresses
+    // TODO: Use GuestMemory for m_stack?
+    std::array<std::uint16_t, 16> m_stack{};
 
-    // Emulated memory
-    SafeArray<kMemorySize, kDebugEnabled> m_memory{};
-    std::uint16_t m_ROMSize{};
+    // Generates random numbers for CXNN, seeded from the clock unless seeded with setRandomSeed()
+    Xorshift32 m_random{
+        static_cast<std::uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count())
+    };
 
-    // Registers 0-9 + A-F (16 total)
-    SafeArray<kRegisterAmount, kDebugEnabled> m_registers{};
+    // Program counter
+    // (start at first instruction of ROM)
+    std::uint16_t m_PC{kROMOffset};
 
     // Index/Address register (12 bits wide)
     std::uint16_t m_index{};
 
-    // Program counter
-    // (start at first instruction of ROM)
-    std::uint16_t m_PC{kROMOffset};
+    // Pressed state of all 16 keypad inputs, one bit per key
+    std::uint16_t m_keyStates{0};
 
-    // Stack, just for subroutine return addresses
-    // TODO: Use SafeArray for m_stack?
-    std::array<std::uint16_t, 16> m_stack{};
     std::uint8_t m_stackSize {0};
 
     // Internal bool to determine whether the PC is to be incremented.
     // (don't increment the PC following jump or return instructions)
     bool m_PCUpdated = false;
 
-    // Mersenne Twister algorithm used for RNG
-    std::mt19937 m_mersenneTwister{
-        static_cast<std::mt19937::result_type>(
-            std::chrono::steady_clock::now().time_since_epoch().count()
-        )
-    };
+    // Boolean used to block execution on AWAIT_KEY instruction
+    bool m_awaitingKey = false;
 
-    // Generate a random value from 0 to 255 (max value of std::uint8_t)
-    std::uniform_int_distribution<std::uint8_t> m_randUint8{0, 255};
+    // Whether all instructions of the ROM have been executed
+    bool m_finished = false;
 
-    // Window is initialised in the constructor initialisation list
-    MainWindow& m_window;
+    static_assert(
+        sizeof(m_registers) + sizeof(m_stack) + sizeof(m_random) + sizeof(m_PC) + sizeof(m_index)
+        + sizeof(m_keyStates) + sizeof(m_stackSize) + sizeof(m_PCUpdated) + sizeof(m_awaitingKey)
+        + sizeof(m_finished) <= 64,
+        "Hot machine state must fit in one cache line"
+    );
+
+    // -- Cold state, from here on starting on the next cache line --
+
+    // Emulated memory, in copy-on-write pages shared with forks and other instances of the ROM
+    alignas(64) PagedGuestMemory<kMemorySize, MemoryBounds> m_memory{};
+
+    // Memory as the ROM was loaded, restored by reset(). Its pages stay shared
+    // with m_memory's until written, so only those written need restoring.
+    PagedGuestMemory<kMemorySize, MemoryBounds> m_loadedMemory{};
+    std::uint16_t m_ROMSize{};
+
+    // m_ROMPath contains the file path of the currently loaded ROM.
+    std::string m_ROMPath;
+
+    // Receives display, audio and debug output.
+    // Never null, defaults to a frontend which discards all output.
+    Chip8Frontend* m_frontend;
 
     SoundTimer m_soundTimer;
     DelayTimer m_delayTimer;
 
-    // Whether the user has closed the window
-    bool m_windowClosed = false;
+    // Full resolution pixel array, 1 byte -> 8 pixels
+    std::array<std::uint8_t, kPackedPixelCount> m_frameBuffer{};
 
-    // Boolean array representing pressed state of all 16 keypad inputs
-    std::bitset<16> m_keyStates{};
+    // Only present the framebuffer to the frontend if it has been modified
+    bool m_frameBufferModified = false;
 
-    // For handling user input events
-    SDL_Event m_event{};
+    // Number of frames emulated since the ROM was loaded
+    std::uint64_t m_frameCount{0};
 
-    // Boolean used to block execution on AWAIT_KEY instruction
-    bool m_awaitingKey = false;
+    // Number of instructions executed since the ROM was loaded
+    std::uint64_t m_instructionCount{0};
+
+    // Heap allocations made by the last emulated frame (see AllocationCounter.h)
+    std::uint64_t m_frameAllocations{0};
 
-    // Use SDL_SCANCODE_UNKNOWN when the key is yet to be pressed.
-    static constexpr SDL_Scancode kNULLScanCode = SDL_SCANCODE_UNKNOWN;
+    Faults m_faults{};
 
-    // The key pressed by the AWAIT_KEY instruction, to await its release.
-    SDL_Scancode m_awaitingScanCode = kNULLScanCode;
+    // Whether a key has been pressed during AWAIT_KEY, to await its release.
+    bool m_awaitingKeyPressed = false;
 
     // The register number used to store keypress of AWAIT_KEY instruction
     std::uint8_t m_awaitingKeyRegNum{0};
 
+    // The interpreter engine used by step()
+    Engine m_engine = Engine::Decode;
+
+    // Pre-decoded instruction for every memory address, allocated on first use.
+    // Entries are decoded lazily and reset to UNDECODED when their bytes are written.
+    std::unique_ptr<std::array<DecodedInstruction, kMemorySize>> m_decodeCache;
+
+    // Native code blocks of the JIT engine, created on first use
+    std::unique_ptr<JitCompiler> m_jit;
+
+    // Statically recompiled program of the loaded ROM (if linked in),
+    // and its block table, created on first use
+    const AotProgram* m_aotProgram{nullptr};
+    std::unique_ptr<AotBlockTable> m_aotBlocks;
+
+    // Contiguous copy of memory for the debug UI, allocated on first use
+    std::unique_ptr<std::array<std::uint8_t, kMemorySize>> m_debugMemory;
+
     // Second step of the fetch/decode/execute loop
     void decode(std::uint16_t instruction);
 
+    // Execute a single micro-op, including its update of the PC.
+    // Defined in chip8_microops.h for use by the faster engines.
+    template<MicroOp op>
+    void executeMicroOp(const DecodedInstruction& instruction);
+
+    // Execute a fused micro-op (see MicroOp.h), returning the amount of
+    // instructions executed. Only its first instruction is executed when
+    // the rest of the sequence doesn't fit in budget.
+    template<MicroOp op>
+    std::uint8_t executeFused(const DecodedInstruction& instruction, std::uint16_t budget);
+
+    // Decode the instruction at address for the decode cache, fused with
+    // the instructions after it where they form a superinstruction
+    DecodedInstruction decodeCacheEntry(std::uint16_t address, std::uint16_t finalInstruction);
+
+    // Handler of the specialized engine for one instruction word
+    using SpecializedHandler = void (*)(Chip8& chip8);
+
+    // Execute the instruction word given as a template argument, its operands
+    // are constants. Defined in specialized/SpecializedHandlers.h.
+    template<std::uint16_t instruction>
+    static void executeSpecialized(Chip8& chip8);
+
+    // Build the table of handlers for every instruction word starting with prefix
+    template<std::uint8_t prefix, std::uint16_t... suffixes>
+    static constexpr std::array<SpecializedHandler, 0x1000> makeSpecializedTable(
+        std::integer_sequence<std::uint16_t, suffixes...>
+    );
+
+    // Handlers of all instruction words starting with prefix (the first nibble).
+    // Each prefix is defined in its own file in specialized/, to compile in parallel.
+    template<std::uint8_t prefix>
+    static const std::array<SpecializedHandler, 0x1000> kSpecializedHandlers;
+
+    // Write to emulated memory, invalidating any cached decode of the written bytes
+    void storeMemory(std::uint16_t address, std::uint8_t value);
+    void invalidateDecodeCache();
+
+    // Discard the decoded instructions, traces and blocks containing the byte at address
+    void invalidateCachedByte(std::uint16_t address);
+
+    // Execute the instruction at the PC through the decode cache, at most budget
+    // instructions of it if fused. Returns the amount of instructions executed.
+    std::uint8_t executeCachedInstruction(
+        std::array<DecodedInstruction, kMemorySize>& cache, std::uint16_t finalInstruction,
+        std::uint16_t budget
+    );
+
     // -- Helper functions for manipulating opcodes --
 
     // Helper function to obtain a 4 bit nibble by position from a 16 bit opcode
@@ -191,55 +341,6 @@ class Chip8 {
         return address;
     }
 
-    static std::uint8_t scanCodeToPos(SDL_Scancode scanCode) {
-        std::uint8_t pos{0};
-
-        /*
-         * All 16 buttons used for the Chip-8 keypad.
-         * Order of enum maps to array index.
-         *
-         * Scancodes are used over key names for
-         * consistency across keyboards layouts.
-         */
-        switch(scanCode) {
-            case SDL_SCANCODE_1: pos = 0x1; break;
-            case SDL_SCANCODE_2: pos = 0x2; break;
-            case SDL_SCANCODE_3: pos = 0x3; break;
-            case SDL_SCANCODE_4: pos = 0xC; break;
-            case SDL_SCANCODE_Q: pos = 0x4; break;
-            case SDL_SCANCODE_W: pos = 0x5; break;
-            case SDL_SCANCODE_E: pos = 0x6; break;
-            case SDL_SCANCODE_R: pos = 0xD; break;
-            case SDL_SCANCODE_A: pos = 0x7; break;
-            case SDL_SCANCODE_S: pos = 0x8; break;
-            case SDL_SCANCODE_D: pos = 0x9; break;
-            case SDL_SCANCODE_F: pos = 0xE; break;
-            case SDL_SCANCODE_Z: pos = 0xA; break;
-            case SDL_SCANCODE_X: pos = 0x0; break;
-            case SDL_SCANCODE_C: pos = 0xB; break;
-            case SDL_SCANCODE_V: pos = 0xF; break;
-
-            // Unused key
-            default: break;
-        }
-
-        return pos;
-    }
-
-    static std::string u8toHex(std::uint8_t val) {
-        return std::format("{:02X}", static_cast<unsigned>(val));
-    }
-
-    static std::string u16toHex(std::uint16_t val) {
-        return std::format("{:04X}", static_cast<unsigned>(val));
-    }
-
-    void setKeyState(SDL_Scancode scanCode, bool state) {
-        // Position in m_keyStates array
-        std::uint8_t pos = scanCodeToPos(scanCode);
-        m_keyStates[pos] = state;
-    }
-
     // All emulated instruction opcodes by prefix
     void opcode0(std::uint16_t instruction);
     void opcode1(std::uint16_t instruction);
@@ -258,6 +359,15 @@ class Chip8 {
     void opcodeE(std::uint16_t instruction);
     void opcodeF(std::uint16_t instruction);
 
+    // Whether the key with the lower nibble of key is pressed, for SKIP_KEY_PRESSED/NOT_PRESSED
+    [[nodiscard]] bool isKeyPressed(std::uint8_t key) const {
+        return (m_keyStates >> (key & kNibbleMask)) & 1;
+    }
+
+    // Framebuffer operations used by CLEAR_DISPLAY and DRAW
+    void clearDisplay();
+    bool drawRow(int x_index, int y_index, std::uint8_t rowData);
+
     /*
      * Private member functions used to initialise and
      * reset the state of the emulator.
@@ -265,16 +375,131 @@ class Chip8 {
     void loadROM();
     void resetEmulator();
 
-    /*
-     * Main execution loop of the emulator.
-     *
-     * The state of the window (closed or running)
-     * determines whether the emulation is still running.
-     */
-    void executionLoop();
+    // Emulate a single frame: execute instructions, then tick timers
+    void executeFrame();
+
+    // Execute up to budget instructions (1 to kInstructionsPerFrame) using each engine.
+    // Returns the amount of instructions executed.
+    std::uint16_t runDecodeEngine(std::uint16_t finalInstruction, std::uint16_t budget);
+    std::uint16_t runPreDecodedEngine(std::uint16_t finalInstruction, std::uint16_t budget);
+    std::uint16_t runThreadedEngine(std::uint16_t finalInstruction, std::uint16_t budget);
+    std::uint16_t runJitEngine(std::uint16_t finalInstruction, std::uint16_t budget);
+    std::uint16_t runAotEngine(std::uint16_t finalInstruction, std::uint16_t budget);
+    std::uint16_t runSpecializedEngine(std::uint16_t finalInstruction, std::uint16_t budget);
+
+    // Everything of a state but memory
+    void saveRegisters(SaveState& state) const;
+
+    // Store memory's bytes which differ from emulated memory (see loadState)
+    void restoreMemory(std::span<const std::uint8_t, kMemorySize> memory);
+
+    // Share every page of memory which emulated memory doesn't already,
+    // invalidating what was cached of the bytes which change
+    void shareMemory(const PagedGuestMemory<kMemorySize, MemoryBounds>& memory);
 
     public:
-        Chip8(MainWindow& window);
-        ~Chip8();
-        void start();
+        // Load the ROM at ROMPath, sending output to frontend (or nowhere)
+        explicit Chip8(std::string_view ROMPath);
+        Chip8(std::string_view ROMPath, Chip8Frontend& frontend);
+
+        // An empty machine without a ROM, until one is opened (e.g. from memory)
+        explicit Chip8(Chip8Frontend& frontend);
+
+        // Reset the emulator and load a different ROM
+        void openROM(std::string_view ROMPath);
+
+        /*
+         * Reset the emulator and load a ROM from memory, e.g. one generated by
+         * a fuzzer. Its pages aren't shared with other instances of the ROM,
+         * pages which didn't change since the last ROM stay shared with it.
+         */
+        void openROM(std::span<const std::uint8_t> ROM);
+
+        /*
+         * Reset the emulator to the current ROM as it was loaded, without
+         * reading the file again. Only the memory pages written since are
+         * restored, taking well under a microsecond.
+         */
+        void reset();
+
+        // Select the interpreter engine. All engines produce identical machine state.
+        void setEngine(Engine engine);
+        [[nodiscard]] Engine getEngine() const;
+
+        // Look up an engine by its command line name (see kEngineNames)
+        static std::optional<Engine> parseEngine(std::string_view name);
+
+        // XOR a row of 8 pixels into frameBuffer at (x, y), wrapping the position on screen.
+        // Returns whether any pixel was turned off, as DXYN reports in VF.
+        static bool drawSpriteRow(
+            std::span<std::uint8_t, kPackedPixelCount> frameBuffer, int x_index, int y_index, std::uint8_t rowData
+        );
+
+        /*
+         * Emulate a number of frames as fast as possible.
+         *
+         * Frame pacing is the caller's responsibility,
+         * headless callers can run unthrottled.
+         */
+        void step(std::uint32_t frames = 1);
+
+        /*
+         * Emulate a frame in parts, for comparing engines (see Lockstep.h).
+         * executeInstructions() runs up to budget of the frame's instructions,
+         * returning how many ran (fewer once blocked by AWAIT_KEY or finished),
+         * and finishFrame() presents the frame and ticks the timers. step() is
+         * kInstructionsPerFrame instructions, then finishFrame().
+         */
+        std::uint16_t executeInstructions(std::uint16_t budget);
+        void finishFrame();
+
+        // Update the pressed state of a keypad key (0x0-0xF)
+        void setKeyState(std::uint8_t key, bool pressed);
+
+        /*
+         * Copy the complete machine state into state, or restore it.
+         * Both take microseconds. Loading a state keeps the decode cache and
+         * native code of memory which the state doesn't change.
+         */
+        void saveState(SaveState& state) const;
+        void loadState(const SaveState& state);
+
+        // Emulated memory, as kept alongside a state to save only what changed
+        using Memory = PagedGuestMemory<kMemorySize, MemoryBounds>;
+
+        /*
+         * Save into a state holding the memory of saved, copying only the
+         * pages written since. saved then shares the current pages, so the
+         * cost scales with the pages written rather than all memory (see
+         * RewindBuffer). A default constructed saved matches a state of zeros.
+         */
+        void saveState(SaveState& state, Memory& saved) const;
+
+        /*
+         * Independent copies of the machine for speculative execution, e.g.
+         * search trying every input. A fork has the same state and engine,
+         * sends its output nowhere and compiles its own code caches.
+         * cloneInto() overwrites another machine, keeping its frontend and
+         * the code it has cached for memory that is the same. Both share the
+         * memory pages, copying about 500 bytes, and don't allocate (fork's
+         * caches are allocated on first use, pages on the first write to them).
+         */
+        [[nodiscard]] Chip8 fork() const;
+        void cloneInto(Chip8& other) const;
+
+        // Seed the random numbers of CXNN, for runs which can be reproduced
+        void setRandomSeed(std::uint32_t seed);
+
+        // Write a byte of emulated memory from outside the interpreter (e.g. memory editor)
+        void writeMemory(std::uint16_t address, std::uint8_t value);
+
+        // Read-only views of the machine state for debugging and output
+        Chip8DebugData getDebugData();
+        [[nodiscard]] std::span<const std::uint8_t> getFrameBuffer() const;
+        [[nodiscard]] std::string_view getROMPath() const;
+        [[nodiscard]] std::uint64_t getFrameCount() const;
+        [[nodiscard]] std::uint64_t getInstructionCount() const;
+        [[nodiscard]] std::uint64_t getFrameAllocations() const;
+        [[nodiscard]] const Faults& getFaults() const;
+        [[nodiscard]] bool isFinished() const;
 };
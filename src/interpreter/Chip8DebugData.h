@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <span>
+#include <functional>
 #include "../utils/RingBuffer.h"
 
 // A simple struct to hold read-only access to emulated memory.
@@ -9,6 +10,15 @@
 struct Chip8DebugData {
     std::span<std::uint8_t> memory;
     std::span<std::uint8_t> registers;
+    std::span<const std::uint8_t> frameBuffer;
     const std::uint16_t PC;
     const std::uint16_t index;
+
+    // Heap allocations made by the last emulated frame.
+    // Always zero unless built with HOTCHIP_COUNT_ALLOCATIONS.
+    const std::uint64_t frameAllocations;
+
+    // Memory edits must go through the interpreter so it can
+    // invalidate any instructions it has already decoded.
+    std::function<void(std::uint16_t, std::uint8_t)> writeMemory;
 };
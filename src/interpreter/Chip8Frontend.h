@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include "InstructionTrace.h"
+
+/*
+ * Abstract sink for everything the emulation core produces for the host:
+ * display frames, the sound timer's beep and debug instruction history.
+ *
+ * Input flows the other way, frontends feed keypad state into the core
+ * through Chip8::setKeyState() between calls to Chip8::step().
+ */
+class Chip8Frontend {
+    public:
+        // Called at the end of an emulated frame if the framebuffer was modified.
+        // The framebuffer is 64x32 pixels packed 8 pixels per byte, MSB first.
+        virtual void presentFrame(std::span<const std::uint8_t> frameBuffer) = 0;
+
+        // Called when the sound timer starts or stops beeping
+        virtual void setBeeping(bool beeping) = 0;
+
+        // Called for every instruction executed by the decode engine.
+        // Format the record with formatInstructionTrace() only if it is displayed.
+        virtual void pushInstructionTrace(const InstructionTrace& trace) = 0;
+
+        virtual ~Chip8Frontend() = default;
+};
+
+// Frontend that discards all output, used to run the core without a window or audio device.
+class HeadlessFrontend final : public Chip8Frontend {
+    public:
+        void presentFrame(std::span<const std::uint8_t>) override {}
+        void setBeeping(bool) override {}
+        void pushInstructionTrace(const InstructionTrace&) override {}
+};
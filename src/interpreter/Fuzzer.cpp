@@ -0,0 +1,358 @@
+#include <bit>
+#include <algorithm>
+#include <stdexcept>
+#include "Fuzzer.h"
+#include "Lockstep.h"
+
+// Largest ROM which fits in memory, 4096 - 512 bytes
+static constexpr std::size_t kMaxROMSize = 0xE00;
+
+// Instructions which jump or point to an address, given one in the ROM by mutateROM()
+static constexpr std::array<std::uint16_t, 4> kAddressPrefixes = {0x1000, 0x2000, 0xA000, 0xB000};
+
+// Bit of a finding in the coverage map, above FuzzCorpus::kReached
+static constexpr std::uint8_t mapBit(FuzzFinding finding) {
+    return static_cast<std::uint8_t>(fuzzFindingBit(finding) << 1);
+}
+
+FuzzCorpus::FuzzCorpus(std::uint32_t frames)
+    : m_map{std::make_unique<std::atomic<std::uint8_t>[]>(kMapSize)}
+    , m_frames{frames}
+{
+}
+
+std::uint8_t FuzzCorpus::reach(std::span<const std::uint32_t> entries, std::uint8_t mask) {
+    std::uint8_t unreached{0};
+
+    for (const std::uint32_t entry : entries) {
+        std::atomic<std::uint8_t>& bits = m_map[entry];
+
+        // Reading first, most entries have been reached before and needn't be written
+        if ((bits.load(std::memory_order_relaxed) & mask) == mask)
+            continue;
+
+        const std::uint8_t previous = bits.fetch_or(mask, std::memory_order_relaxed);
+        unreached |= static_cast<std::uint8_t>(mask & ~previous);
+
+        if ((mask & ~previous & kReached) != 0)
+            m_coverage.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return unreached;
+}
+
+void FuzzCorpus::add(const FuzzInput& input) {
+    const std::scoped_lock lock{m_mutex};
+    m_inputs.push_back(input);
+}
+
+void FuzzCorpus::copyInputs(std::size_t first, std::vector<FuzzInput>& inputs) const {
+    const std::scoped_lock lock{m_mutex};
+
+    if (first < m_inputs.size())
+        inputs.insert(inputs.end(), m_inputs.begin() + static_cast<std::ptrdiff_t>(first), m_inputs.end());
+}
+
+std::size_t FuzzCorpus::getSize() const {
+    const std::scoped_lock lock{m_mutex};
+    return m_inputs.size();
+}
+
+std::uint64_t FuzzCorpus::getCoverage() const {
+    return m_coverage.load(std::memory_order_relaxed);
+}
+
+FuzzWorker::CoverageFrontend::CoverageFrontend()
+    : m_reached(FuzzCorpus::kMapSize, 0)
+{
+}
+
+void FuzzWorker::CoverageFrontend::pushInstructionTrace(const InstructionTrace& trace) {
+    const auto opcode = static_cast<std::uint32_t>(decodeMicroOp(trace.instruction).op);
+    const std::uint32_t entry = std::uint32_t{trace.PC} << 6 | opcode;
+
+    if (m_reached[entry] == 0) {
+        m_reached[entry] = 1;
+        entries.push_back(entry);
+    }
+
+    // Traced after it ran, so the instruction which first hit a fault is its site
+    const Chip8::Faults& faults = machine->getFaults();
+    const std::array<bool, 3> hit = {
+        faults.stackOverflows != 0, faults.emptyReturns != 0, CheckedBounds::outOfBoundsAccesses != outOfBounds
+    };
+
+    for (std::size_t fault{0}; fault < hit.size(); ++fault) {
+        if (hit[fault] && faultSites[fault] == kNoSite)
+            faultSites[fault] = entry;
+    }
+}
+
+void FuzzWorker::CoverageFrontend::clear() {
+    for (const std::uint32_t entry : entries)
+        m_reached[entry] = 0;
+
+    entries.clear();
+    faultSites.fill(kNoSite);
+    outOfBounds = CheckedBounds::outOfBoundsAccesses;
+}
+
+FuzzWorker::FuzzWorker(FuzzCorpus& corpus, std::uint32_t seed)
+    : m_corpus{corpus}
+    , m_random{seed}
+{
+    m_coverage.machine = &m_chip8;
+    m_chip8.setEngine(Chip8::Engine::Decode);
+
+    for (std::size_t engine{1}; engine < Chip8::kEngineNames.size(); ++engine) {
+        m_engines.push_back(std::make_unique<Chip8>(m_chip8.fork()));
+        m_engines.back()->setEngine(static_cast<Chip8::Engine>(engine));
+    }
+}
+
+std::uint32_t FuzzWorker::below(std::uint32_t bound) {
+    // Multiplied rather than taken modulo bound, the high bits are xorshift's best
+    return static_cast<std::uint32_t>(std::uint64_t{m_random.next()} * bound >> 32);
+}
+
+void FuzzWorker::mutateROM() {
+    std::vector<std::uint8_t>& ROM = m_input.ROM;
+
+    // Only growing an empty (or one byte) ROM makes a difference
+    const std::uint32_t mutation = ROM.size() < 2 ? 6 : below(8);
+    const auto size = static_cast<std::uint32_t>(ROM.size());
+
+    // Instructions are at even offsets in most ROMs
+    const std::uint32_t instruction = size >= 2 ? below(size / 2) * 2 : 0;
+
+    switch (mutation) {
+        case 0:
+            // Flip a bit
+            ROM[below(size)] ^= static_cast<std::uint8_t>(1 << below(8));
+            break;
+        case 1:
+            // Replace a byte
+            ROM[below(size)] = m_random.nextByte();
+            break;
+        case 2: {
+            // Add or subtract a little, e.g. from a counter or coordinate
+            std::uint8_t& byte = ROM[below(size)];
+            byte = static_cast<std::uint8_t>(byte + below(33) - 16);
+            break;
+        }
+        case 3: {
+            // Replace an instruction with any other
+            const std::uint32_t word = m_random.next() >> 16;
+            ROM[instruction] = static_cast<std::uint8_t>(word >> 8);
+            ROM[instruction + 1] = static_cast<std::uint8_t>(word);
+            break;
+        }
+        case 4: {
+            // Jump, call or point I into the ROM, where a random address would mostly miss it
+            const auto word = static_cast<std::uint16_t>(
+                kAddressPrefixes[below(kAddressPrefixes.size())] | (0x200 + below(size / 2) * 2)
+            );
+
+            ROM[instruction] = static_cast<std::uint8_t>(word >> 8);
+            ROM[instruction + 1] = static_cast<std::uint8_t>(word);
+            break;
+        }
+        case 5:
+            // Remove an instruction
+            ROM.erase(ROM.begin() + instruction, ROM.begin() + instruction + 2);
+            break;
+        case 6: {
+            // Insert an instruction
+            if (size + 2 > kMaxROMSize)
+                break;
+
+            const std::uint32_t word = m_random.next() >> 16;
+            ROM.insert(ROM.begin() + instruction, {static_cast<std::uint8_t>(word >> 8), static_cast<std::uint8_t>(word)});
+            break;
+        }
+        case 7: {
+            // Overwrite part of the ROM with part of another input's, growing it if need be
+            const std::vector<std::uint8_t>& other = m_inputs[below(static_cast<std::uint32_t>(m_inputs.size()))].ROM;
+
+            if (other.empty())
+                break;
+
+            const std::uint32_t start = below(static_cast<std::uint32_t>(other.size()));
+            const std::uint32_t length = 1 + below(static_cast<std::uint32_t>(other.size()) - start);
+            const std::uint32_t destination = below(size);
+
+            ROM.resize(std::min<std::size_t>(std::max<std::size_t>(size, destination + length), kMaxROMSize));
+
+            const std::size_t copied = std::min<std::size_t>(length, ROM.size() - destination);
+            std::copy_n(other.begin() + start, copied, ROM.begin() + destination);
+            break;
+        }
+    }
+}
+
+void FuzzWorker::mutateKeys() {
+    std::vector<std::uint16_t>& keys = m_input.keys;
+
+    if (keys.empty())
+        return;
+
+    // A run of frames, from a tap to holding a key throughout
+    const auto frames = static_cast<std::uint32_t>(keys.size());
+    const std::uint32_t first = below(frames);
+    const std::uint32_t last = first + below(frames - first);
+    const std::uint32_t mutation = below(3);
+    const auto key = static_cast<std::uint16_t>(1 << below(16));
+
+    for (std::uint32_t frame = first; frame <= last; ++frame) {
+        if (mutation == 0)
+            keys[frame] ^= key;
+        else if (mutation == 1)
+            keys[frame] = key;
+        else
+            keys[frame] = 0;
+    }
+}
+
+std::uint8_t FuzzWorker::execute(Chip8& chip8, const FuzzInput& input) {
+    const std::uint64_t outOfBounds = CheckedBounds::outOfBoundsAccesses;
+
+    chip8.openROM(input.ROM);
+    chip8.setRandomSeed(input.seed);
+
+    std::uint16_t held{0};
+
+    for (const std::uint16_t keys : input.keys) {
+        // Press and release only the keys which changed, as a keyboard would
+        for (std::uint16_t changed = held ^ keys; changed != 0; changed &= changed - 1) {
+            const auto key = static_cast<std::uint8_t>(std::countr_zero(changed));
+            chip8.setKeyState(key, (keys >> key & 1) != 0);
+        }
+
+        held = keys;
+        chip8.step();
+
+        // Nothing left to run but the timers
+        if (chip8.isFinished())
+            break;
+    }
+
+    std::uint8_t findings{0};
+
+    if (chip8.getFaults().stackOverflows != 0)
+        findings |= fuzzFindingBit(FuzzFinding::StackOverflow);
+
+    if (chip8.getFaults().emptyReturns != 0)
+        findings |= fuzzFindingBit(FuzzFinding::EmptyReturn);
+
+    if (CheckedBounds::outOfBoundsAccesses != outOfBounds)
+        findings |= fuzzFindingBit(FuzzFinding::OutOfBounds);
+
+    return findings;
+}
+
+bool FuzzWorker::diverges(const FuzzInput& input, std::uint8_t findings) {
+    m_chip8.saveState(*m_expected);
+
+    const std::uint64_t expectedHash = hashSaveState(*m_expected);
+    const Chip8::Faults& expectedFaults = m_chip8.getFaults();
+
+    for (const std::unique_ptr<Chip8>& engine : m_engines) {
+        try {
+            if (execute(*engine, input) != findings)
+                return true;
+        } catch (const std::exception&) {
+            return true;
+        }
+
+        engine->saveState(*m_actual);
+        const Chip8::Faults& faults = engine->getFaults();
+
+        if (hashSaveState(*m_actual) != expectedHash
+            || faults.stackOverflows != expectedFaults.stackOverflows
+            || faults.emptyReturns != expectedFaults.emptyReturns)
+            return true;
+    }
+
+    return false;
+}
+
+FuzzResult FuzzWorker::run(const FuzzInput& input) {
+    if (&input != &m_input)
+        m_input = input;
+
+    {
+        const std::scoped_lock lock{m_runningMutex};
+        m_running = m_input;
+    }
+
+    FuzzResult result;
+    std::uint8_t findings{0};
+
+    m_coverage.clear();
+
+    try {
+        findings = execute(m_chip8, m_input);
+    } catch (const std::exception& e) {
+        findings = fuzzFindingBit(FuzzFinding::Crash);
+        result.error = e.what();
+    }
+
+    result.added = (m_corpus.reach(m_coverage.entries, FuzzCorpus::kReached) & FuzzCorpus::kReached) != 0;
+
+    std::uint8_t unreached{0};
+
+    if ((findings & fuzzFindingBit(FuzzFinding::Crash)) != 0)
+        unreached |= m_corpus.reach(m_coverage.entries, mapBit(FuzzFinding::Crash));
+
+    for (std::size_t fault{0}; fault < m_coverage.faultSites.size(); ++fault) {
+        const auto finding = static_cast<FuzzFinding>(static_cast<std::size_t>(FuzzFinding::StackOverflow) + fault);
+        const std::uint32_t site = m_coverage.faultSites[fault];
+
+        if ((findings & fuzzFindingBit(finding)) != 0 && site != CoverageFrontend::kNoSite)
+            unreached |= m_corpus.reach(std::span{&site, 1}, mapBit(finding));
+    }
+
+    // Inputs worth keeping are checked against the other engines, most aren't
+    if ((result.added || unreached != 0) && (findings & fuzzFindingBit(FuzzFinding::Crash)) == 0
+        && diverges(m_input, findings))
+        unreached |= m_corpus.reach(m_coverage.entries, mapBit(FuzzFinding::Divergence));
+
+    if (result.added)
+        m_corpus.add(m_input);
+
+    result.findings = static_cast<std::uint8_t>(unreached >> 1);
+    return result;
+}
+
+FuzzInput FuzzWorker::getRunningInput() const {
+    const std::scoped_lock lock{m_runningMutex};
+    return m_running;
+}
+
+FuzzResult FuzzWorker::fuzz() {
+    if (m_inputs.empty() || ++m_sinceSync >= kSyncInterval) {
+        m_corpus.copyInputs(m_inputs.size(), m_inputs);
+        m_sinceSync = 0;
+
+        if (m_inputs.empty())
+            throw std::runtime_error("Fuzzing needs an input in the corpus");
+    }
+
+    m_input = m_inputs[below(static_cast<std::uint32_t>(m_inputs.size()))];
+
+    // Stacked mutations reach further from the corpus, single ones stay close to it
+    const std::uint32_t mutations = 1u << below(4);
+
+    for (std::uint32_t mutation{0}; mutation < mutations; ++mutation) {
+        const std::uint32_t target = below(16);
+
+        if (target < 11)
+            mutateROM();
+        else if (target < 15)
+            mutateKeys();
+        else
+            m_input.seed = m_random.next();
+    }
+
+    return run(m_input);
+}
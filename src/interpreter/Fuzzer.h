@@ -0,0 +1,219 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "Chip8.h"
+#include "Chip8Frontend.h"
+#include "MicroOp.h"
+#include "../utils/Xorshift32.h"
+
+/*
+ * Coverage-guided fuzzing of the interpreter and ROMs (see hotchip-fuzz).
+ *
+ * An input is a ROM and the keys held on each frame it runs for. Workers
+ * mutate inputs of a shared corpus, run them headless on the decode engine
+ * and mark every (PC, opcode) pair executed in a shared coverage map, the
+ * opcode being the operation without its operands (its MicroOp). Inputs
+ * reaching a pair no earlier input reached join the corpus. Operands aren't
+ * part of the pair, or nearly every mutated instruction would be new.
+ *
+ * Each entry of the map also has a bit per kind of finding, so a finding is
+ * only reported once for each pair, rather than for every mutation of the
+ * first input making it: a fault for the pair of the instruction which hit
+ * it, a crash or divergence for any pair the input reached.
+ */
+
+// A ROM and its input, played from the machine's reset
+struct FuzzInput {
+    std::vector<std::uint8_t> ROM;
+
+    // Keys held on each frame (bit k for key k), one per frame run
+    std::vector<std::uint16_t> keys;
+
+    // Seed of the random numbers of CXNN
+    std::uint32_t seed{1};
+};
+
+// What inputs are reported for
+enum class FuzzFinding : std::uint8_t {
+    // The interpreter threw an exception
+    Crash,
+    // ROM errors the interpreter recovered from (see Chip8::Faults and CheckedBounds)
+    StackOverflow,
+    EmptyReturn,
+    OutOfBounds,
+    // Another engine ended in a different state, or hit different faults, than the decode engine
+    Divergence
+};
+
+// Names of each finding for output files, in FuzzFinding order
+inline constexpr std::array<std::string_view, 5> kFuzzFindingNames = {
+    "crash", "stack-overflow", "empty-return", "out-of-bounds", "divergence"
+};
+
+// Bit of a finding in FuzzResult::findings
+constexpr std::uint8_t fuzzFindingBit(FuzzFinding finding) {
+    return static_cast<std::uint8_t>(1 << static_cast<std::uint8_t>(finding));
+}
+
+static_assert(static_cast<int>(MicroOp::COUNT) <= 64, "Opcodes must fit in 6 bits of a coverage map entry");
+
+// Coverage map and corpus, shared by every worker
+class FuzzCorpus {
+    public:
+        // Entries of the coverage map, the PC's 12 bits above the opcode's 6
+        static constexpr int kMapBits = 18;
+        static constexpr std::size_t kMapSize = std::size_t{1} << kMapBits;
+
+        // Bit of an entry set once an input reached it, the findings' bits above it
+        static constexpr std::uint8_t kReached = 1;
+
+    private:
+        std::unique_ptr<std::atomic<std::uint8_t>[]> m_map;
+
+        // Entries reached
+        std::atomic<std::uint64_t> m_coverage{0};
+
+        // Frames inputs run for
+        std::uint32_t m_frames;
+
+        mutable std::mutex m_mutex;
+        std::vector<FuzzInput> m_inputs;
+
+    public:
+        explicit FuzzCorpus(std::uint32_t frames);
+
+        /*
+         * Set the bits of mask on the entries reached by an input, returning
+         * the bits which weren't set on all of them before: kReached for new
+         * coverage, a finding's bit for a new finding.
+         */
+        std::uint8_t reach(std::span<const std::uint32_t> entries, std::uint8_t mask);
+
+        void add(const FuzzInput& input);
+
+        // Append the inputs from first on to inputs
+        void copyInputs(std::size_t first, std::vector<FuzzInput>& inputs) const;
+
+        [[nodiscard]] std::size_t getSize() const;
+        [[nodiscard]] std::uint64_t getCoverage() const;
+
+        [[nodiscard]] std::uint32_t getFrames() const {
+            return m_frames;
+        }
+};
+
+// The outcome of running an input
+struct FuzzResult {
+    // Whether the input reached new coverage and joined the corpus
+    bool added{false};
+
+    // New findings of the input, FuzzFinding bits
+    std::uint8_t findings{0};
+
+    // What was thrown, for a crash
+    std::string error;
+};
+
+/*
+ * Mutates and runs inputs of a corpus, on one thread. Inputs reaching new
+ * coverage, or making a finding, are run again on every other engine, and
+ * the state they end in compared with the decode engine's.
+ */
+class FuzzWorker {
+    // Marks the instructions the decode engine executes as coverage map entries
+    class CoverageFrontend final : public Chip8Frontend {
+        // Whether an entry was already reached by this input, cleared after each one
+        std::vector<std::uint8_t> m_reached;
+
+        public:
+            // Fault sites of faults not hit by this input
+            static constexpr std::uint32_t kNoSite = ~0u;
+
+            // Entries reached by this input
+            std::vector<std::uint32_t> entries;
+
+            // Entry of the first instruction to hit each fault, from FuzzFinding::StackOverflow on
+            std::array<std::uint32_t, 3> faultSites{};
+
+            // The machine traced, and the thread's out-of-bounds accesses before this input
+            const Chip8* machine{nullptr};
+            std::uint64_t outOfBounds{0};
+
+            CoverageFrontend();
+
+            void presentFrame(std::span<const std::uint8_t>) override {}
+            void setBeeping(bool) override {}
+            void pushInstructionTrace(const InstructionTrace& trace) override;
+
+            // Start a new input
+            void clear();
+    };
+
+    // Inputs are synced from the corpus after this many are run
+    static constexpr std::uint32_t kSyncInterval = 1024;
+
+    FuzzCorpus& m_corpus;
+
+    CoverageFrontend m_coverage;
+    Chip8 m_chip8{m_coverage};
+
+    // A machine for each other engine
+    std::vector<std::unique_ptr<Chip8>> m_engines;
+    std::unique_ptr<SaveState> m_expected = std::make_unique<SaveState>();
+    std::unique_ptr<SaveState> m_actual = std::make_unique<SaveState>();
+
+    // The corpus, as of the last sync
+    std::vector<FuzzInput> m_inputs;
+    std::uint32_t m_sinceSync{0};
+
+    // The input being run
+    FuzzInput m_input;
+
+    // A copy of m_input published before each run, for other threads to read
+    mutable std::mutex m_runningMutex;
+    FuzzInput m_running;
+
+    Xorshift32 m_random;
+
+    // Random number below bound (non-zero)
+    std::uint32_t below(std::uint32_t bound);
+
+    // Mutate m_input in place, once
+    void mutateROM();
+    void mutateKeys();
+
+    // Run input on chip8, returning the FuzzFinding bits of the faults it hit
+    static std::uint8_t execute(Chip8& chip8, const FuzzInput& input);
+
+    // Whether any other engine ends input in a different state from m_chip8,
+    // or with other faults than findings (those of m_chip8)
+    bool diverges(const FuzzInput& input, std::uint8_t findings);
+
+    public:
+        FuzzWorker(FuzzCorpus& corpus, std::uint32_t seed);
+
+        FuzzWorker(const FuzzWorker&) = delete;
+        FuzzWorker& operator=(const FuzzWorker&) = delete;
+
+        // Run an input as is, e.g. a seed ROM, adding it to the corpus if it reaches new coverage
+        FuzzResult run(const FuzzInput& input);
+
+        // Mutate an input of the corpus and run it, the corpus mustn't be empty
+        FuzzResult fuzz();
+
+        // The input last run, only from the thread running the worker
+        [[nodiscard]] const FuzzInput& getInput() const {
+            return m_input;
+        }
+
+        // A copy of the input being run, from any thread (e.g. a watchdog while the worker runs it)
+        [[nodiscard]] FuzzInput getRunningInput() const;
+};
@@ -0,0 +1,295 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include "Chip8.h"
+#include "InputMovie.h"
+#include "../utils/AtomicFile.h"
+
+/*
+ * Encoded format, counts and frames are LEB128 variable length integers:
+ * - "HCMV", the format's magic bytes
+ * - 16 bit little-endian version (Movie::kVersion)
+ * - Frame count
+ * - Event count, then for each: frames since the previous event's frame,
+ *   and a byte of the key (low nibble) and whether it was pressed (bit 4)
+ * - Keyframe count, then for each: frames since the previous keyframe,
+ *   a byte of flags (kReplacedBit), the size of its encoded save state and
+ *   the save state
+ */
+static constexpr std::array<std::uint8_t, 4> kMagic = {'H', 'C', 'M', 'V'};
+static constexpr std::uint8_t kPressedBit = 0x10;
+static constexpr std::uint8_t kReplacedBit = 0x01;
+
+// Appends the fields of the format
+class MovieWriter {
+    std::vector<std::uint8_t>& m_data;
+
+    public:
+        explicit MovieWriter(std::vector<std::uint8_t>& data) : m_data{data} {}
+
+        void put(std::uint8_t byte) {
+            m_data.push_back(byte);
+        }
+
+        void put(std::span<const std::uint8_t> bytes) {
+            m_data.insert(m_data.end(), bytes.begin(), bytes.end());
+        }
+
+        void putVarint(std::uint64_t value) {
+            while (value >= 0x80) {
+                m_data.push_back(static_cast<std::uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+
+            m_data.push_back(static_cast<std::uint8_t>(value));
+        }
+};
+
+// Reads the fields written by MovieWriter, throwing at the end of the data
+class MovieReader {
+    std::span<const std::uint8_t> m_data;
+    std::size_t m_position{0};
+
+    public:
+        explicit MovieReader(std::span<const std::uint8_t> data) : m_data{data} {}
+
+        std::uint8_t get() {
+            if (m_position == m_data.size())
+                throw std::runtime_error("Corrupt movie");
+
+            return m_data[m_position++];
+        }
+
+        std::span<const std::uint8_t> get(std::uint64_t size) {
+            if (size > m_data.size() - m_position)
+                throw std::runtime_error("Corrupt movie");
+
+            const std::span<const std::uint8_t> bytes = m_data.subspan(m_position, size);
+            m_position += size;
+            return bytes;
+        }
+
+        std::uint64_t getVarint() {
+            std::uint64_t value{0};
+
+            for (unsigned shift{0}; shift < 64; shift += 7) {
+                const std::uint8_t byte = get();
+                value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+
+            throw std::runtime_error("Corrupt movie");
+        }
+
+        [[nodiscard]] bool atEnd() const {
+            return m_position == m_data.size();
+        }
+};
+
+std::vector<std::uint8_t> encodeMovie(const Movie& movie) {
+    std::vector<std::uint8_t> data{kMagic.begin(), kMagic.end()};
+    MovieWriter writer{data};
+
+    writer.put(static_cast<std::uint8_t>(Movie::kVersion));
+    writer.put(static_cast<std::uint8_t>(Movie::kVersion >> 8));
+    writer.putVarint(movie.frameCount);
+
+    std::uint64_t frame{0};
+    writer.putVarint(movie.events.size());
+
+    for (const Movie::Event& event : movie.events) {
+        writer.putVarint(event.frame - frame);
+        writer.put(static_cast<std::uint8_t>((event.key & 0xF) | (event.pressed ? kPressedBit : 0)));
+        frame = event.frame;
+    }
+
+    frame = 0;
+    writer.putVarint(movie.keyframes.size());
+
+    for (const Movie::Keyframe& keyframe : movie.keyframes) {
+        writer.putVarint(keyframe.frame - frame);
+        writer.put(keyframe.replaced ? kReplacedBit : 0);
+        writer.putVarint(keyframe.state.size());
+        writer.put(keyframe.state);
+        frame = keyframe.frame;
+    }
+
+    return data;
+}
+
+Movie decodeMovie(std::span<const std::uint8_t> data) {
+    if (data.size() < kMagic.size() || !std::ranges::equal(data.first(kMagic.size()), kMagic))
+        throw std::runtime_error("Not a movie");
+
+    MovieReader reader{data.subspan(kMagic.size())};
+    const std::uint8_t versionLow = reader.get();
+    const auto version = static_cast<std::uint16_t>(versionLow | reader.get() << 8);
+
+    if (version != Movie::kVersion)
+        throw std::runtime_error(
+            "Unsupported movie version " + std::to_string(version)
+            + ", expected " + std::to_string(Movie::kVersion)
+        );
+
+    Movie movie;
+    movie.frameCount = reader.getVarint();
+
+    // Counts are checked against the bytes left before reserving, each entry takes at least one
+    const auto readCount = [&] {
+        const std::uint64_t count = reader.getVarint();
+
+        if (count > data.size())
+            throw std::runtime_error("Corrupt movie");
+
+        return static_cast<std::size_t>(count);
+    };
+
+    std::uint64_t frame{0};
+    movie.events.resize(readCount());
+
+    for (Movie::Event& event : movie.events) {
+        frame += reader.getVarint();
+        const std::uint8_t byte = reader.get();
+
+        if (frame > movie.frameCount || (byte & ~(kPressedBit | 0xF)) != 0)
+            throw std::runtime_error("Corrupt movie");
+
+        event = Movie::Event{frame, static_cast<std::uint8_t>(byte & 0xF), (byte & kPressedBit) != 0};
+    }
+
+    frame = 0;
+    movie.keyframes.resize(readCount());
+
+    for (Movie::Keyframe& keyframe : movie.keyframes) {
+        const std::uint64_t delta = reader.getVarint();
+
+        // Only the first keyframe is at frame 0, later ones are in increasing order
+        if ((&keyframe == &movie.keyframes.front()) != (delta == 0) || frame + delta > movie.frameCount)
+            throw std::runtime_error("Corrupt movie");
+
+        frame += delta;
+        const std::uint8_t flags = reader.get();
+
+        if ((flags & ~kReplacedBit) != 0)
+            throw std::runtime_error("Corrupt movie");
+
+        const std::span<const std::uint8_t> state = reader.get(reader.getVarint());
+        keyframe = Movie::Keyframe{frame, {state.begin(), state.end()}, (flags & kReplacedBit) != 0};
+
+        // Throws for an invalid state now rather than during playback
+        (void) decodeSaveState(keyframe.state);
+    }
+
+    if (movie.keyframes.empty() || !reader.atEnd())
+        throw std::runtime_error("Corrupt movie");
+
+    return movie;
+}
+
+void writeMovieFile(const std::string& path, const Movie& movie) {
+    writeFileAtomically(path, encodeMovie(movie), "movie");
+}
+
+Movie readMovieFile(const std::string& path) {
+    std::ifstream inFS{path, std::ifstream::binary};
+
+    if (!inFS.is_open())
+        throw std::runtime_error("Error opening movie: " + path + ", " + std::strerror(errno));
+
+    const std::vector<std::uint8_t> data{std::istreambuf_iterator<char>{inFS}, std::istreambuf_iterator<char>{}};
+    return decodeMovie(data);
+}
+
+static std::vector<std::uint8_t> encodeState(const Chip8& chip8) {
+    SaveState state;
+    chip8.saveState(state);
+    return encodeSaveState(state);
+}
+
+MovieRecorder::MovieRecorder(const Chip8& chip8) {
+    m_movie.keyframes.push_back({0, encodeState(chip8), false});
+}
+
+void MovieRecorder::setKeyState(Chip8& chip8, std::uint8_t key, bool pressed) {
+    m_movie.events.push_back({m_movie.frameCount, static_cast<std::uint8_t>(key & 0xF), pressed});
+    chip8.setKeyState(key, pressed);
+}
+
+void MovieRecorder::endFrame(const Chip8& chip8) {
+    ++m_movie.frameCount;
+    m_frameEvents = m_movie.events.size();
+
+    if (m_movie.frameCount - m_movie.keyframes.back().frame >= Movie::kKeyframeInterval)
+        m_movie.keyframes.push_back({m_movie.frameCount, encodeState(chip8), false});
+}
+
+void MovieRecorder::keyframe(const Chip8& chip8) {
+    // Events before the state was replaced have no effect, the state holds the keypad
+    m_movie.events.resize(m_frameEvents);
+
+    // A periodic keyframe at this frame becomes one playback loads
+    if (m_movie.keyframes.back().frame == m_movie.frameCount)
+        m_movie.keyframes.back() = {m_movie.frameCount, encodeState(chip8), true};
+    else
+        m_movie.keyframes.push_back({m_movie.frameCount, encodeState(chip8), true});
+}
+
+MoviePlayer::MoviePlayer(const Movie& movie, Chip8& chip8) : m_movie{movie} {
+    seek(chip8, 0);
+}
+
+void MoviePlayer::seek(Chip8& chip8, std::uint64_t frame) {
+    if (frame > m_movie.frameCount)
+        throw std::runtime_error(
+            "Can't seek to frame " + std::to_string(frame) + " of a movie of "
+            + std::to_string(m_movie.frameCount) + " frames"
+        );
+
+    // The last keyframe at or before frame, the first is at frame 0
+    const auto keyframe = std::ranges::upper_bound(
+        m_movie.keyframes, frame, {}, &Movie::Keyframe::frame
+    ) - 1;
+
+    chip8.loadState(decodeSaveState(keyframe->state));
+
+    m_frame = keyframe->frame;
+    m_keyframe = static_cast<std::size_t>(keyframe - m_movie.keyframes.begin()) + 1;
+    m_event = static_cast<std::size_t>(
+        std::ranges::lower_bound(m_movie.events, m_frame, {}, &Movie::Event::frame) - m_movie.events.begin()
+    );
+
+    while (m_frame < frame)
+        step(chip8);
+}
+
+bool MoviePlayer::beginFrame(Chip8& chip8) {
+    if (isFinished())
+        return false;
+
+    // The state was replaced here while recording, other keyframes are only for seek()
+    if (m_keyframe < m_movie.keyframes.size() && m_movie.keyframes[m_keyframe].frame == m_frame) {
+        if (m_movie.keyframes[m_keyframe].replaced)
+            chip8.loadState(decodeSaveState(m_movie.keyframes[m_keyframe].state));
+
+        ++m_keyframe;
+    }
+
+    for (; m_event < m_movie.events.size() && m_movie.events[m_event].frame == m_frame; ++m_event)
+        chip8.setKeyState(m_movie.events[m_event].key, m_movie.events[m_event].pressed);
+
+    ++m_frame;
+    return true;
+}
+
+bool MoviePlayer::step(Chip8& chip8) {
+    if (!beginFrame(chip8))
+        return false;
+
+    chip8.step();
+    return true;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "SaveState.h"
+
+class Chip8;
+
+/*
+ * A recorded session: the machine state it starts from and every keypad
+ * event, replayed bit-exactly by MoviePlayer.
+ *
+ * Events are the calls to Chip8::setKeyState() before each frame, in order,
+ * so AWAIT_KEY sees the same presses and releases. The first keyframe holds
+ * the starting state, including the state (seed) of the random numbers.
+ *
+ * A keyframe, an encoded save state, is stored every kKeyframeInterval frames,
+ * and wherever the state was replaced rather than emulated (e.g. by loading a
+ * save state or rewinding). Seeking loads the keyframe before the frame and
+ * replays at most kKeyframeInterval frames from it. Playback only loads the
+ * replaced states, so replaying from any frame emulates everything between.
+ */
+struct Movie {
+    // Version of the encoding, increased whenever the format changes
+    static constexpr std::uint16_t kVersion = 2;
+
+    // Frames between keyframes, 10 seconds at 60 frames per second
+    static constexpr std::uint64_t kKeyframeInterval = 600;
+
+    // A call to setKeyState() before frame
+    struct Event {
+        std::uint64_t frame;
+        std::uint8_t key;
+        bool pressed;
+    };
+
+    // The machine state at the start of frame, before its events
+    struct Keyframe {
+        std::uint64_t frame;
+        std::vector<std::uint8_t> state;
+
+        // Whether the state was replaced here while recording, rather than stored to seek from
+        bool replaced;
+    };
+
+    // Frames recorded
+    std::uint64_t frameCount{0};
+
+    // Ordered by frame, then in the order they were made
+    std::vector<Event> events;
+
+    // Ordered by frame, the first at frame 0
+    std::vector<Keyframe> keyframes;
+};
+
+// Encode a movie to the binary movie format
+std::vector<std::uint8_t> encodeMovie(const Movie& movie);
+
+// Decode a movie encoded by encodeMovie().
+// Throws std::runtime_error for data which isn't a valid movie of this version.
+Movie decodeMovie(std::span<const std::uint8_t> data);
+
+// Write an encoded movie to path, replacing the file only once it's complete
+void writeMovieFile(const std::string& path, const Movie& movie);
+
+// Read a movie from a file written by writeMovieFile(), throws std::runtime_error on failure
+Movie readMovieFile(const std::string& path);
+
+/*
+ * Records a movie of a machine, from its state when recording starts.
+ *
+ * Key events must go through setKeyState() rather than the machine's own,
+ * endFrame() is called after every emulated frame and keyframe() after the
+ * state is replaced.
+ */
+class MovieRecorder {
+    Movie m_movie;
+
+    // Events recorded for the frame not yet emulated begin here
+    std::size_t m_frameEvents{0};
+
+    public:
+        explicit MovieRecorder(const Chip8& chip8);
+
+        // Record a key event and pass it on to chip8
+        void setKeyState(Chip8& chip8, std::uint8_t key, bool pressed);
+
+        // Record that chip8 has emulated a frame
+        void endFrame(const Chip8& chip8);
+
+        // Record chip8's state, replaced other than by emulation since the last frame
+        void keyframe(const Chip8& chip8);
+
+        [[nodiscard]] const Movie& getMovie() const {
+            return m_movie;
+        }
+};
+
+/*
+ * Plays a movie back on a machine running the movie's ROM.
+ *
+ * beginFrame() applies the movie's input (and keyframe) of the next frame,
+ * then the caller emulates the frame, e.g. with Chip8::step().
+ */
+class MoviePlayer {
+    const Movie& m_movie;
+
+    // The next frame to play, and its first event and keyframe (or the ones after it)
+    std::uint64_t m_frame{0};
+    std::size_t m_event{0};
+    std::size_t m_keyframe{0};
+
+    public:
+        // Plays movie, which must outlive the player, from its first frame
+        MoviePlayer(const Movie& movie, Chip8& chip8);
+
+        // Continue playing from frame, loading the keyframe before it and replaying
+        // up to it. Throws std::runtime_error past the end of the movie.
+        void seek(Chip8& chip8, std::uint64_t frame);
+
+        // Apply the next frame's input and any state replaced before it, false
+        // (applying nothing) once the movie has ended
+        bool beginFrame(Chip8& chip8);
+
+        // beginFrame() and emulate the frame, false once the movie has ended
+        bool step(Chip8& chip8);
+
+        // The next frame to play
+        [[nodiscard]] std::uint64_t getFrame() const {
+            return m_frame;
+        }
+
+        [[nodiscard]] bool isFinished() const {
+            return m_frame >= m_movie.frameCount;
+        }
+};
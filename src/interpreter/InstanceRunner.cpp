@@ -0,0 +1,164 @@
+#include <algorithm>
+#include "InstanceRunner.h"
+#include "Lockstep.h"
+#include "../utils/Logger.h"
+
+void InstanceRunner::WorkQueue::push(std::uint32_t machine) {
+    const std::lock_guard lock{mutex};
+    machines[(head + size) % machines.size()] = machine;
+    ++size;
+}
+
+bool InstanceRunner::WorkQueue::popFront(std::uint32_t& machine) {
+    const std::lock_guard lock{mutex};
+
+    if (size == 0)
+        return false;
+
+    machine = machines[head];
+    head = (head + 1) % machines.size();
+    --size;
+    return true;
+}
+
+bool InstanceRunner::WorkQueue::popBack(std::uint32_t& machine) {
+    const std::lock_guard lock{mutex};
+
+    if (size == 0)
+        return false;
+
+    --size;
+    machine = machines[(head + size) % machines.size()];
+    return true;
+}
+
+InstanceRunner::InstanceRunner(std::uint32_t threads)
+    : m_threadCount{threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())}
+    , m_queues{std::make_unique<WorkQueue[]>(m_threadCount)}
+    , m_workers{std::make_unique<Worker[]>(m_threadCount)}
+    , m_start{m_threadCount}
+    , m_finish{m_threadCount}
+{
+    for (std::uint32_t worker{0}; worker < m_threadCount; ++worker)
+        m_workers[worker].victims.setSeed(worker + 1);
+
+    // The caller of run() is worker 0
+    for (std::uint32_t worker{1}; worker < m_threadCount; ++worker)
+        m_threads.emplace_back(&InstanceRunner::workerLoop, this, worker);
+}
+
+InstanceRunner::~InstanceRunner() {
+    m_stopping = true;
+    m_start.arrive_and_wait();
+
+    for (std::thread& thread : m_threads)
+        thread.join();
+}
+
+void InstanceRunner::setBatchFrames(std::uint32_t frames) {
+    m_batchFrames = std::max(frames, 1u);
+}
+
+void InstanceRunner::run(std::span<Chip8* const> machines, std::uint32_t frames) {
+    m_machines = machines;
+    m_frames = frames;
+    m_results.assign(machines.size(), Result{});
+
+    for (std::uint32_t worker{0}; worker < m_threadCount; ++worker) {
+        WorkQueue& queue = m_queues[worker];
+        queue.machines.assign(std::max<std::size_t>(machines.size(), 1), 0);
+        queue.head = 0;
+        queue.size = 0;
+
+        m_workers[worker].statistics = WorkerStatistics{};
+    }
+
+    // Deal machines round-robin, stealing evens out the rest
+    for (std::uint32_t machine{0}; machine < machines.size(); ++machine)
+        m_queues[machine % m_threadCount].push(machine);
+
+    m_remaining.store(static_cast<std::uint32_t>(machines.size()), std::memory_order_relaxed);
+
+    // The barriers order the setup above before the threads' work, and their results before returning
+    m_start.arrive_and_wait();
+    work(0);
+    m_finish.arrive_and_wait();
+}
+
+void InstanceRunner::workerLoop(std::uint32_t worker) {
+    Logger::instance().registerThread();
+
+    while (true) {
+        m_start.arrive_and_wait();
+
+        if (m_stopping)
+            return;
+
+        work(worker);
+        m_finish.arrive_and_wait();
+    }
+}
+
+void InstanceRunner::work(std::uint32_t worker) {
+    std::uint32_t machine{0};
+
+    while (m_remaining.load(std::memory_order_acquire) != 0) {
+        if (!m_queues[worker].popFront(machine) && !steal(worker, machine)) {
+            // Every machine left is being run by another thread
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (runBatch(worker, machine))
+            m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+        else
+            m_queues[worker].push(machine);
+    }
+}
+
+bool InstanceRunner::steal(std::uint32_t worker, std::uint32_t& machine) {
+    Worker& self = m_workers[worker];
+
+    // Try every other thread, starting from a random one so thieves spread out
+    const std::uint32_t first = self.victims.next() % m_threadCount;
+
+    for (std::uint32_t offset{0}; offset < m_threadCount; ++offset) {
+        const std::uint32_t victim = (first + offset) % m_threadCount;
+
+        // The back of the queue is the machine its thread will run last
+        if (victim != worker && m_queues[victim].popBack(machine)) {
+            ++self.statistics.steals;
+            return true;
+        }
+    }
+
+    ++self.statistics.failedSteals;
+    return false;
+}
+
+bool InstanceRunner::runBatch(std::uint32_t worker, std::uint32_t machine) {
+    Worker& self = m_workers[worker];
+    Result& result = m_results[machine];
+    Chip8& chip8 = *m_machines[machine];
+
+    const std::uint64_t instructions = chip8.getInstructionCount();
+    const std::uint32_t frames = static_cast<std::uint32_t>(
+        std::min<std::uint64_t>(m_batchFrames, m_frames - result.frames)
+    );
+
+    const auto start = std::chrono::steady_clock::now();
+    chip8.step(frames);
+    result.time += std::chrono::steady_clock::now() - start;
+
+    result.frames += frames;
+    result.instructions += chip8.getInstructionCount() - instructions;
+    ++result.batches;
+    ++self.statistics.batches;
+
+    if (result.frames < m_frames && !chip8.isFinished())
+        return false;
+
+    chip8.saveState(*self.state);
+    result.hash = hashSaveState(*self.state);
+    return true;
+}
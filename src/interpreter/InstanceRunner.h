@@ -0,0 +1,143 @@
+#pragma once
+
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <barrier>
+#include <chrono>
+#include <cstdint>
+#include "Chip8.h"
+#include "SaveState.h"
+#include "../utils/Xorshift32.h"
+
+/*
+ * Runs many independent headless machines on a pool of threads, e.g.
+ * thousands of regression or AI sessions on a many-core server.
+ *
+ * A task runs one machine for a batch of frames, then puts it at the back
+ * of its thread's queue. Machines are dealt round-robin to the queues, and
+ * a thread whose queue is empty steals from the back of another's, so
+ * threads stay busy however uneven the machines are: one waiting in FX0A
+ * runs a frame in nanoseconds, one drawing every frame in microseconds.
+ *
+ * Every batch costs one uncontended lock of a queue (tens of nanoseconds,
+ * against a batch of frames in microseconds), and a steal one lock of
+ * the victim's. Results are written to a cache line per machine, and each
+ * thread's counters to its own, so threads never write to a line shared
+ * with another.
+ *
+ * Machines share nothing but copy-on-write memory pages (see PagedMemory.h),
+ * so results are the same whatever the amount of threads.
+ */
+class InstanceRunner {
+    public:
+        // Frames a task runs a machine for before re-queueing it
+        static constexpr std::uint32_t kDefaultBatchFrames = 16;
+
+        // Output of one machine, alone on its cache line
+        struct alignas(64) Result {
+            std::uint64_t frames{0};
+            std::uint64_t instructions{0};
+
+            // Hash of the final state (see hashSaveState())
+            std::uint64_t hash{0};
+
+            // Time spent running the machine, and how many tasks it took
+            std::chrono::nanoseconds time{0};
+            std::uint32_t batches{0};
+        };
+
+        // Counters of one thread, alone on its cache line
+        struct alignas(64) WorkerStatistics {
+            std::uint64_t batches{0};
+            std::uint64_t steals{0};
+            std::uint64_t failedSteals{0};
+        };
+
+    private:
+        // A thread's queue of machines, indices into the machines being run
+        struct alignas(64) WorkQueue {
+            std::mutex mutex;
+
+            // Ring of capacity the amount of machines, so never full
+            std::vector<std::uint32_t> machines;
+            std::size_t head{0};
+            std::size_t size{0};
+
+            void push(std::uint32_t machine);
+            bool popFront(std::uint32_t& machine);
+            bool popBack(std::uint32_t& machine);
+        };
+
+        // A thread's own state, only written by it
+        struct alignas(64) Worker {
+            WorkerStatistics statistics;
+            Xorshift32 victims{1};
+
+            // Final states to hash, allocated once
+            std::unique_ptr<SaveState> state = std::make_unique<SaveState>();
+        };
+
+        std::uint32_t m_threadCount;
+        std::vector<std::thread> m_threads;
+        std::unique_ptr<WorkQueue[]> m_queues;
+        std::unique_ptr<Worker[]> m_workers;
+
+        // Threads wait at m_start for run(), and at m_finish until every machine is done
+        std::barrier<> m_start;
+        std::barrier<> m_finish;
+        bool m_stopping{false};
+
+        // The run in progress
+        std::span<Chip8* const> m_machines;
+        std::uint32_t m_frames{0};
+        std::uint32_t m_batchFrames{kDefaultBatchFrames};
+        std::vector<Result> m_results;
+        std::atomic<std::uint32_t> m_remaining{0};
+
+        void workerLoop(std::uint32_t worker);
+
+        // Run and re-queue machines until all are done
+        void work(std::uint32_t worker);
+
+        // Take a machine from another thread's queue
+        bool steal(std::uint32_t worker, std::uint32_t& machine);
+
+        // Run a batch of a machine's frames, returning whether it is done
+        bool runBatch(std::uint32_t worker, std::uint32_t machine);
+
+    public:
+        // Start threads (the caller of run() being one of them), hardware_concurrency() by default
+        explicit InstanceRunner(std::uint32_t threads = 0);
+        ~InstanceRunner();
+
+        InstanceRunner(const InstanceRunner&) = delete;
+        InstanceRunner& operator=(const InstanceRunner&) = delete;
+
+        // Frames a task runs a machine for, at least 1
+        void setBatchFrames(std::uint32_t frames);
+
+        /*
+         * Emulate frames frames of every machine, returning once all are done
+         * (or finished, see Chip8::isFinished()). Machines must not be
+         * touched by the caller until it returns.
+         */
+        void run(std::span<Chip8* const> machines, std::uint32_t frames);
+
+        [[nodiscard]] std::uint32_t getThreadCount() const {
+            return m_threadCount;
+        }
+
+        // Results of the last run, by machine
+        [[nodiscard]] std::span<const Result> getResults() const {
+            return m_results;
+        }
+
+        // Counters of a thread in the last run, 0 being run()'s caller
+        [[nodiscard]] const WorkerStatistics& getStatistics(std::uint32_t thread) const {
+            return m_workers[thread].statistics;
+        }
+};
@@ -0,0 +1,77 @@
+#include <format>
+#include "InstructionTrace.h"
+
+std::string formatInstructionTrace(const InstructionTrace& trace) {
+    const std::uint16_t instruction = trace.instruction;
+
+    // Operands as unsigned, which std::format prints as numbers rather than characters
+    const unsigned x = (instruction >> 8) & 0xF;
+    const unsigned y = (instruction >> 4) & 0xF;
+    const unsigned n = instruction & 0xF;
+    const unsigned nn = instruction & 0xFF;
+    const unsigned nnn = instruction & 0xFFF;
+
+    // Register values after the instruction
+    const unsigned VX = trace.registers[x];
+    const unsigned VY = trace.registers[y];
+    const unsigned VF = trace.registers[0xF];
+    const unsigned index = trace.index;
+
+    switch (instruction >> 12) {
+        case 0x0:
+            if (nn == 0xE0)
+                return "DISPLAY CLEAR";
+            if (nn == 0xEE)
+                return std::format("RETURN {:04X} -> {:04X}", trace.PC, trace.nextPC);
+            break;
+        case 0x1: return std::format("GOTO {:04X}", nnn);
+        case 0x2: return std::format("CALL {:04X}", trace.nextPC);
+        case 0x3: return std::format("IF V{:02X} == {:02X}", x, nn);
+        case 0x4: return std::format("IF V{:02X} != {:02X}", x, nn);
+        case 0x5: return std::format("IF V{:02X} == V{:02X}", x, y);
+        case 0x6: return std::format("V{:02X} = {:02X}", x, nn);
+        case 0x7: return std::format("V{:02X} += {:02X}", x, nn);
+        case 0x8:
+            switch (n) {
+                case 0x0: return std::format("V{:02X} = V{:02X}", x, y);
+                case 0x1: return std::format("V{:02X} |= V{:02X}", x, y);
+                case 0x2: return std::format("V{:02X} &= V{:02X}", x, y);
+                case 0x3: return std::format("V{:02X} ^= V{:02X}", x, y);
+                case 0x4: return std::format("V{:02X} += V{:02X}, VF = {:02X}", x, y, VF);
+                case 0x5: return std::format("V{:02X} -= V{:02X}, VF = {:02X}", x, y, VF);
+                case 0x6: return std::format("V{:02X} = V{:02X} >> 1, VF = {:02X}", x, y, VF);
+                case 0x7: return std::format("V{:02X} = V{:02X} - V{:02X}, VF = {:02X}", x, y, x, VF);
+                case 0xE: return std::format("V{:02X} = V{:02X} << 1, VF = {:02X}", x, y, VF);
+                default: break;
+            }
+            break;
+        case 0x9: return std::format("IF V{:02X} != V{:02X}", x, y);
+        case 0xA: return std::format("I = {:04X}", nnn);
+        case 0xB: return std::format("PC = {:02X} + {:04X}", static_cast<unsigned>(trace.registers[0]), nnn);
+        case 0xC: return std::format("V{:02X} = {:02X} (RAND)", x, VX);
+        case 0xD: return std::format("DRAW: ({:02X}, {:02X}), N: {:02X}, VF: {:02X}", VX, VY, n, VF);
+        case 0xE:
+            if (nn == 0x9E)
+                return std::format("SKIP IF {:02X} PRESSED", VX);
+            if (nn == 0xA1)
+                return std::format("SKIP IF {:02X} NOT PRESSED", VX);
+            break;
+        case 0xF:
+            switch (nn) {
+                case 0x07: return std::format("GET DELAY TIMER : {:02X}", VX);
+                case 0x15: return std::format("SET DELAY TIMER: {:02X}", VX);
+                case 0x18: return std::format("SET SOUND TIMER: {:02X}", VX);
+                case 0x0A: return "AWAITING KEYPRESS";
+                case 0x1E: return std::format("I += {:02X}, I = {:04X}", VX, index);
+                case 0x29: return std::format("LOAD CHAR: {:02X}", VX);
+                case 0x33: return std::format("BCD V{:02X} = {:02X} INDEX: {:04X}", x, VX, index);
+                case 0x55: return std::format("DUMP REG: VX = {:02X}, I = {:04X}", x, index);
+                case 0x65: return std::format("LOAD REG: VX = {:02X}, I = {:04X}", x, index);
+                default: break;
+            }
+            break;
+        default: break;
+    }
+
+    return std::format("UNKNOWN {:04X}", static_cast<unsigned>(instruction));
+}
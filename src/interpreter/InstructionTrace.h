@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <cstdint>
+#include <type_traits>
+
+/*
+ * Record of one instruction executed by the decode engine, for the debug UI's
+ * instruction history. Fixed size and trivially copyable, so recording it costs
+ * a copy rather than formatting and allocating a string for every instruction.
+ * formatInstructionTrace() produces the readable text when a row is drawn.
+ */
+struct InstructionTrace {
+    // Frame the instruction was executed in
+    std::uint64_t frame;
+
+    // Address and word of the instruction
+    std::uint16_t PC;
+    std::uint16_t instruction;
+
+    // PC and I after the instruction
+    std::uint16_t nextPC;
+    std::uint16_t index;
+
+    // V registers after the instruction
+    std::array<std::uint8_t, 16> registers;
+};
+
+static_assert(std::is_trivially_copyable_v<InstructionTrace>);
+static_assert(sizeof(InstructionTrace) == 32, "Two trace records per cache line");
+
+// Readable description of a traced instruction, such as "V3 += 01"
+std::string formatInstructionTrace(const InstructionTrace& trace);
@@ -0,0 +1,211 @@
+#include <cstring>
+#include "Lockstep.h"
+
+// Mix a word into a hash (multiply-xorshift)
+static std::uint64_t mix(std::uint64_t hash, std::uint64_t value) {
+    hash = (hash ^ value) * 0x9E3779B97F4A7C15;
+    return hash ^ hash >> 29;
+}
+
+std::uint64_t hashSaveState(const SaveState& state) {
+    std::uint64_t hash{0};
+
+    // Memory and the framebuffer are whole words
+    static_assert(SaveState::kMemorySize % 8 == 0 && SaveState::kFrameBufferSize % 8 == 0);
+
+    const auto hashBytes = [&](std::span<const std::uint8_t> bytes) {
+        for (std::size_t offset{0}; offset < bytes.size(); offset += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, bytes.data() + offset, sizeof(word));
+            hash = mix(hash, word);
+        }
+    };
+
+    hashBytes(state.memory);
+    hashBytes(state.frameBuffer);
+    hashBytes(state.registers);
+
+    for (const std::uint16_t address : state.stack)
+        hash = mix(hash, address);
+
+    // Fields are hashed one by one, the padding between them holds anything
+    hash = mix(hash, state.stackSize);
+    hash = mix(hash, state.PC);
+    hash = mix(hash, state.index);
+    hash = mix(hash, state.ROMSize);
+    hash = mix(hash, state.delayTimer);
+    hash = mix(hash, state.soundTimer);
+    hash = mix(hash, state.beeping);
+    hash = mix(hash, state.keyStates);
+    hash = mix(hash, state.awaitingKey);
+    hash = mix(hash, state.awaitingKeyPressed);
+    hash = mix(hash, state.awaitingKeyRegNum);
+    hash = mix(hash, state.randomState);
+    hash = mix(hash, state.finished);
+    hash = mix(hash, state.frameCount);
+    hash = mix(hash, state.instructionCount);
+
+    return hash;
+}
+
+// The first part of the state which differs between a and b
+static std::string_view differingPart(const SaveState& a, const SaveState& b) {
+    if (a.registers != b.registers || a.PC != b.PC || a.index != b.index
+        || a.stack != b.stack || a.stackSize != b.stackSize)
+        return "registers";
+
+    if (a.memory != b.memory)
+        return "memory";
+
+    if (a.frameBuffer != b.frameBuffer)
+        return "framebuffer";
+
+    if (a.delayTimer != b.delayTimer || a.soundTimer != b.soundTimer || a.beeping != b.beeping)
+        return "timers";
+
+    if (a.keyStates != b.keyStates || a.awaitingKey != b.awaitingKey
+        || a.awaitingKeyPressed != b.awaitingKeyPressed || a.awaitingKeyRegNum != b.awaitingKeyRegNum)
+        return "keypad";
+
+    if (a.randomState != b.randomState)
+        return "random numbers";
+
+    return "counters";
+}
+
+Lockstep::Lockstep(Chip8& machine, Chip8& other, Granularity granularity)
+    : m_machine{machine}
+    , m_other{&other}
+    , m_granularity{granularity}
+{
+}
+
+Lockstep::Lockstep(Chip8& machine, std::span<const std::uint64_t> expectedHashes, Granularity granularity)
+    : m_machine{machine}
+    , m_other{nullptr}
+    , m_expectedHashes{expectedHashes}
+    , m_granularity{granularity}
+{
+}
+
+void Lockstep::recordHashes() {
+    m_recordHashes = true;
+}
+
+void Lockstep::setKeyState(std::uint8_t key, bool pressed) {
+    m_machine.setKeyState(key, pressed);
+
+    if (m_other)
+        m_other->setKeyState(key, pressed);
+}
+
+std::optional<Lockstep::Divergence> Lockstep::step() {
+    // Keep the start of the frame to replay it
+    if (m_machineStart) {
+        m_machine.cloneInto(*m_machineStart);
+    } else {
+        m_machineStart.emplace(m_machine.fork());
+    }
+
+    if (m_other) {
+        if (m_otherStart)
+            m_other->cloneInto(*m_otherStart);
+        else
+            m_otherStart.emplace(m_other->fork());
+    }
+
+    if (m_granularity == Granularity::Instruction) {
+        if (std::optional<Divergence> divergence = replayInstructions())
+            return divergence;
+
+        m_machine.finishFrame();
+
+        if (m_other)
+            m_other->finishFrame();
+    } else {
+        m_machine.step();
+
+        if (m_other)
+            m_other->step();
+    }
+
+    if (compare())
+        return std::nullopt;
+
+    // Find the instruction, unless the frame ended the same and only its end diverged
+    if (m_granularity == Granularity::Frame && m_other) {
+        if (std::optional<Divergence> divergence = replayInstructions())
+            return divergence;
+
+        m_machine.finishFrame();
+        m_other->finishFrame();
+        compare();
+    }
+
+    SaveState start;
+    m_machineStart->saveState(start);
+    return describe(start, 0);
+}
+
+bool Lockstep::compare() {
+    m_machine.saveState(m_state);
+    const std::uint64_t hash = mix(m_hash, hashSaveState(m_state));
+
+    bool same = true;
+
+    if (m_other) {
+        m_other->saveState(m_otherState);
+        same = hash == mix(m_hash, hashSaveState(m_otherState));
+    } else if (m_comparisons < m_expectedHashes.size()) {
+        same = hash == m_expectedHashes[m_comparisons];
+    }
+
+    if (m_recordHashes)
+        m_hashes.push_back(hash);
+
+    m_hash = hash;
+    ++m_comparisons;
+
+    return same;
+}
+
+std::optional<Lockstep::Divergence> Lockstep::replayInstructions() {
+    // The first machine before the instruction replayed next
+    SaveState before;
+    m_machineStart->saveState(before);
+
+    for (std::uint16_t budget{1}; budget <= Chip8::kInstructionsPerFrame; ++budget) {
+        // Even before the first, the machines may have run the whole frame already
+        m_machineStart->cloneInto(m_machine);
+
+        if (m_other)
+            m_otherStart->cloneInto(*m_other);
+
+        const std::uint16_t executed = m_machine.executeInstructions(budget);
+        const std::uint16_t otherExecuted = m_other ? m_other->executeInstructions(budget) : executed;
+
+        if (!compare())
+            return describe(before, budget);
+
+        // Both blocked (AWAIT_KEY) or finished, more instructions wouldn't run
+        if (executed < budget && otherExecuted < budget)
+            break;
+
+        before = m_state;
+    }
+
+    return std::nullopt;
+}
+
+Lockstep::Divergence Lockstep::describe(const SaveState& state, std::uint16_t instruction) const {
+    // The instruction word as fetched, wrapping around the end of memory
+    const auto opcode = static_cast<std::uint16_t>(
+        state.memory[state.PC % SaveState::kMemorySize] << 8
+        | state.memory[(state.PC + 1) % SaveState::kMemorySize]
+    );
+
+    return Divergence{
+        state.frameCount, instruction, state.PC, opcode,
+        m_other ? differingPart(m_state, m_otherState) : "unknown"
+    };
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include "Chip8.h"
+
+// Hash of a complete machine state, to tell states apart (not cryptographic)
+std::uint64_t hashSaveState(const SaveState& state);
+
+/*
+ * Differential execution: runs a machine in lockstep with another one on the
+ * same ROM and input, e.g. the decode engine against a faster engine,
+ * comparing a rolling hash of their complete state (registers, memory,
+ * framebuffer, timers, keypad and random numbers) as they go.
+ *
+ * States are compared after every frame, or with Granularity::Instruction
+ * after every instruction: each frame is replayed from its start for every
+ * amount of its instructions (see Chip8::executeInstructions()), so engines
+ * running blocks or fused instructions are compared on the same code paths
+ * as a full frame. When frames differ, their instructions are replayed the
+ * same way to find the first one which diverges.
+ *
+ * Machines in different builds (e.g. debug against release) are compared
+ * through the stream of rolling hashes, recorded by one build and checked
+ * by the other. Without both states, divergence is found to the frame, or
+ * the instruction when both streams are of Granularity::Instruction.
+ */
+class Lockstep {
+    public:
+        enum class Granularity : std::uint8_t {
+            Frame,
+            Instruction
+        };
+
+        // Where the machines first differ
+        struct Divergence {
+            std::uint64_t frame;
+
+            // Instructions of the frame executed, up to and including the
+            // diverging one, or 0 when the end of the frame (e.g. the timers) diverged
+            std::uint16_t instruction;
+
+            // Address and word of the diverging instruction in the first machine,
+            // or of the frame's first instruction when instruction is 0
+            std::uint16_t PC;
+            std::uint16_t opcode;
+
+            // The first part of the state which differs, "unknown" against hashes
+            std::string_view part;
+        };
+
+    private:
+        Chip8& m_machine;
+
+        // The machine compared against, or null when checking m_expectedHashes
+        Chip8* m_other;
+
+        std::span<const std::uint64_t> m_expectedHashes;
+        Granularity m_granularity;
+
+        // Rolling hash of every state compared, and the hashes so far if recording
+        std::uint64_t m_hash{0};
+        std::uint64_t m_comparisons{0};
+        std::vector<std::uint64_t> m_hashes;
+        bool m_recordHashes{false};
+
+        // The states last compared
+        SaveState m_state;
+        SaveState m_otherState;
+
+        // The machines at the start of the frame, for replaying it
+        std::optional<Chip8> m_machineStart;
+        std::optional<Chip8> m_otherStart;
+
+        // Whether machines are the same at the next point of comparison, updating the rolling hash
+        bool compare();
+
+        // Replay the frame from its start, comparing after every amount of its instructions.
+        // Returns the first divergence, leaving the machines at the end of the frame's instructions.
+        std::optional<Divergence> replayInstructions();
+
+        // Describe a divergence of the states last compared, at instruction of the
+        // frame, which the first machine executed from state
+        [[nodiscard]] Divergence describe(const SaveState& state, std::uint16_t instruction) const;
+
+    public:
+        // Compare machine against other, both at the same state (e.g. just loaded)
+        Lockstep(Chip8& machine, Chip8& other, Granularity granularity);
+
+        // Compare machine against the hashes recorded by another run with the same
+        // granularity, or against none to only record them
+        Lockstep(Chip8& machine, std::span<const std::uint64_t> expectedHashes, Granularity granularity);
+
+        // Keep the rolling hash at every comparison, for checking another run against
+        void recordHashes();
+
+        // Pass a key event on to both machines
+        void setKeyState(std::uint8_t key, bool pressed);
+
+        // Emulate a frame on both machines, returning where they diverged if they did
+        std::optional<Divergence> step();
+
+        // Rolling hash of every state compared so far
+        [[nodiscard]] std::uint64_t getHash() const {
+            return m_hash;
+        }
+
+        // Hashes kept by recordHashes()
+        [[nodiscard]] std::span<const std::uint64_t> getHashes() const {
+            return m_hashes;
+        }
+
+        // Whether recorded hashes are left to check, states past them aren't compared
+        [[nodiscard]] bool hasExpectedHashes() const {
+            return m_comparisons < m_expectedHashes.size();
+        }
+};
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Every distinct CHIP-8 instruction, with the prefix/suffix
+ * decoding of decode() and the opcodeN() handlers already done.
+ */
+enum class MicroOp : std::uint8_t {
+    // Cache entry that hasn't been decoded yet (or was invalidated by a write)
+    UNDECODED,
+    // Instruction with no effect other than advancing the PC
+    UNKNOWN,
+    CLEAR_DISPLAY,
+    RETURN,
+    GOTO,
+    CALL,
+    SKIP_EQ_IMM,
+    SKIP_NE_IMM,
+    SKIP_EQ_REG,
+    SET_IMM,
+    ADD_IMM,
+    REG_ASSIGNMENT,
+    REG_OR,
+    REG_AND,
+    REG_XOR,
+    REG_ADD,
+    REG_SUBTRACT,
+    REG_RSHIFT,
+    REG_DIFFERENCE,
+    REG_LSHIFT,
+    SKIP_NE_REG,
+    SET_INDEX,
+    JUMP_V0,
+    RAND,
+    DRAW,
+    IS_KEY_PRESSED,
+    IS_KEY_NOT_PRESSED,
+    TIMER_GET_DELAY,
+    TIMER_DELAY_SET,
+    TIMER_SOUND_SET,
+    AWAIT_KEY,
+    ADD_TO_I,
+    LOAD_CHAR,
+    BCD_VX,
+    DUMP_REG,
+    LOAD_REG,
+    /*
+     * Superinstructions: a frequent sequence fused into the cache entry of
+     * its first instruction by fuseMicroOps(). The first instruction keeps
+     * its usual operand fields, so it can still be executed on its own.
+     */
+    // ANNN DXYN: nnn = NNN, x, y and n of the draw
+    SET_INDEX_DRAW,
+    // 6XNN 6YNN: x and nn of the first, y = second Y, n = second NN
+    SET_IMM_PAIR,
+    // 7XNN 3XKK 1MMM (loop counter): nn = NN, n = KK, nnn = MMM
+    ADD_SKIP_LOOP,
+    // FX07 3XKK (delay timer poll): nn = KK
+    DELAY_SKIP,
+    // Number of micro-ops, for dispatch tables
+    COUNT
+};
+
+// A pre-decoded instruction with all of its operands extracted
+struct DecodedInstruction {
+    MicroOp op{MicroOp::UNDECODED};
+    std::uint8_t x{};
+    std::uint8_t y{};
+    std::uint8_t n{};
+    std::uint8_t nn{};
+    std::uint16_t nnn{};
+};
+
+// Translate a 16 bit instruction into its micro-op and operands
+constexpr DecodedInstruction decodeMicroOp(std::uint16_t instruction) {
+    DecodedInstruction decoded{
+        MicroOp::UNKNOWN,
+        static_cast<std::uint8_t>((instruction >> 8) & 0xF),
+        static_cast<std::uint8_t>((instruction >> 4) & 0xF),
+        static_cast<std::uint8_t>(instruction & 0xF),
+        static_cast<std::uint8_t>(instruction & 0xFF),
+        static_cast<std::uint16_t>(instruction & 0xFFF)
+    };
+
+    switch (instruction >> 12) {
+        case 0x0:
+            if (decoded.nn == 0xE0)
+                decoded.op = MicroOp::CLEAR_DISPLAY;
+            else if (decoded.nn == 0xEE)
+                decoded.op = MicroOp::RETURN;
+            break;
+        case 0x1: decoded.op = MicroOp::GOTO; break;
+        case 0x2: decoded.op = MicroOp::CALL; break;
+        case 0x3: decoded.op = MicroOp::SKIP_EQ_IMM; break;
+        case 0x4: decoded.op = MicroOp::SKIP_NE_IMM; break;
+        case 0x5: decoded.op = MicroOp::SKIP_EQ_REG; break;
+        case 0x6: decoded.op = MicroOp::SET_IMM; break;
+        case 0x7: decoded.op = MicroOp::ADD_IMM; break;
+        case 0x8:
+            switch (decoded.n) {
+                case 0x0: decoded.op = MicroOp::REG_ASSIGNMENT; break;
+                case 0x1: decoded.op = MicroOp::REG_OR; break;
+                case 0x2: decoded.op = MicroOp::REG_AND; break;
+                case 0x3: decoded.op = MicroOp::REG_XOR; break;
+                case 0x4: decoded.op = MicroOp::REG_ADD; break;
+                case 0x5: decoded.op = MicroOp::REG_SUBTRACT; break;
+                case 0x6: decoded.op = MicroOp::REG_RSHIFT; break;
+                case 0x7: decoded.op = MicroOp::REG_DIFFERENCE; break;
+                case 0xE: decoded.op = MicroOp::REG_LSHIFT; break;
+                default: break;
+            }
+            break;
+        case 0x9: decoded.op = MicroOp::SKIP_NE_REG; break;
+        case 0xA: decoded.op = MicroOp::SET_INDEX; break;
+        case 0xB: decoded.op = MicroOp::JUMP_V0; break;
+        case 0xC: decoded.op = MicroOp::RAND; break;
+        case 0xD: decoded.op = MicroOp::DRAW; break;
+        case 0xE:
+            if (decoded.nn == 0x9E)
+                decoded.op = MicroOp::IS_KEY_PRESSED;
+            else if (decoded.nn == 0xA1)
+                decoded.op = MicroOp::IS_KEY_NOT_PRESSED;
+            break;
+        case 0xF:
+            switch (decoded.nn) {
+                case 0x07: decoded.op = MicroOp::TIMER_GET_DELAY; break;
+                case 0x15: decoded.op = MicroOp::TIMER_DELAY_SET; break;
+                case 0x18: decoded.op = MicroOp::TIMER_SOUND_SET; break;
+                case 0x0A: decoded.op = MicroOp::AWAIT_KEY; break;
+                case 0x1E: decoded.op = MicroOp::ADD_TO_I; break;
+                case 0x29: decoded.op = MicroOp::LOAD_CHAR; break;
+                case 0x33: decoded.op = MicroOp::BCD_VX; break;
+                case 0x55: decoded.op = MicroOp::DUMP_REG; break;
+                case 0x65: decoded.op = MicroOp::LOAD_REG; break;
+                default: break;
+            }
+            break;
+        default: break;
+    }
+
+    return decoded;
+}
+
+// Amount of instructions a fused micro-op covers, at most
+constexpr std::uint8_t fusedLength(MicroOp op) {
+    switch (op) {
+        case MicroOp::SET_INDEX_DRAW:
+        case MicroOp::SET_IMM_PAIR:
+        case MicroOp::DELAY_SKIP: return 2;
+        case MicroOp::ADD_SKIP_LOOP: return 3;
+        default: return 1;
+    }
+}
+
+// Micro-op of a fused micro-op's first instruction
+constexpr MicroOp fusedFirstOp(MicroOp op) {
+    switch (op) {
+        case MicroOp::SET_INDEX_DRAW: return MicroOp::SET_INDEX;
+        case MicroOp::SET_IMM_PAIR: return MicroOp::SET_IMM;
+        case MicroOp::ADD_SKIP_LOOP: return MicroOp::ADD_IMM;
+        case MicroOp::DELAY_SKIP: return MicroOp::TIMER_GET_DELAY;
+        default: return op;
+    }
+}
+
+/*
+ * Fuse a decoded instruction with the two following it, if they form one of
+ * the superinstructions. Instructions past the end of the ROM are passed as
+ * UNDECODED and never fused.
+ *
+ * Only the entry of the first instruction is fused, the entries of the others
+ * are decoded on their own. Jumps and skips landing inside a sequence (such
+ * as the 1NNN after a skip) therefore run the individual instructions.
+ */
+constexpr DecodedInstruction fuseMicroOps(
+    const DecodedInstruction& first, const DecodedInstruction& second,
+    const DecodedInstruction& third
+) {
+    DecodedInstruction fused = first;
+
+    switch (first.op) {
+        case MicroOp::SET_INDEX:
+            if (second.op == MicroOp::DRAW) {
+                fused.op = MicroOp::SET_INDEX_DRAW;
+                fused.x = second.x;
+                fused.y = second.y;
+                fused.n = second.n;
+            }
+            break;
+        case MicroOp::SET_IMM:
+            if (second.op == MicroOp::SET_IMM) {
+                fused.op = MicroOp::SET_IMM_PAIR;
+                fused.y = second.x;
+                fused.n = second.nn;
+            }
+            break;
+        case MicroOp::ADD_IMM:
+            if (second.op == MicroOp::SKIP_EQ_IMM && second.x == first.x && third.op == MicroOp::GOTO) {
+                fused.op = MicroOp::ADD_SKIP_LOOP;
+                fused.n = second.nn;
+                fused.nnn = third.nnn;
+            }
+            break;
+        case MicroOp::TIMER_GET_DELAY:
+            if (second.op == MicroOp::SKIP_EQ_IMM && second.x == first.x) {
+                fused.op = MicroOp::DELAY_SKIP;
+                fused.nn = second.nn;
+            }
+            break;
+        default: break;
+    }
+
+    return fused;
+}
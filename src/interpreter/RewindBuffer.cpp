@@ -0,0 +1,164 @@
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include "Chip8.h"
+#include "RewindBuffer.h"
+#include "../utils/ZeroRunLength.h"
+
+// States are recorded, XORed and rebuilt as plain bytes
+static_assert(std::is_trivially_copyable_v<SaveState>);
+
+// Memory comes first in a state, and its pages compress to whole runs
+static_assert(offsetof(SaveState, memory) == 0);
+static_assert(kMemoryPageSize % kZeroRunMaxLength == 0);
+
+// Largest compressed frame, a state without any runs of zeros
+static constexpr std::size_t kMaxFrameSize = maxZeroRunCompressedSize(sizeof(SaveState));
+static_assert(kMaxFrameSize <= UINT16_MAX);
+
+static std::span<std::uint8_t> bytesOf(SaveState& state) {
+    return {reinterpret_cast<std::uint8_t*>(&state), sizeof(SaveState)};
+}
+
+static std::span<const std::uint8_t> bytesOf(const SaveState& state) {
+    return {reinterpret_cast<const std::uint8_t*>(&state), sizeof(SaveState)};
+}
+
+RewindBuffer::RewindBuffer()
+    : m_buffer(kBufferSize)
+    , m_entries(kMaxFrames)
+{
+}
+
+void RewindBuffer::push(const Chip8& chip8) {
+    if (m_count == kMaxFrames)
+        dropOldestSecond();
+
+    const std::size_t offset = allocate(kMaxFrameSize);
+    const std::span<std::uint8_t> frame = std::span{m_buffer}.subspan(offset, kMaxFrameSize);
+
+    const std::size_t next = m_newestState ^ 1;
+    const std::span<std::uint8_t> state = bytesOf(m_states[next]);
+    chip8.saveState(m_states[next], m_memories[next]);
+
+    // The oldest frame must be a keyframe, so is the first after dropping every frame
+    const bool keyframe = m_count == 0 || m_sinceKeyframe + 1 == kKeyframeInterval;
+    std::size_t size{0};
+
+    if (keyframe) {
+        size = compressZeroRuns(state, frame);
+        m_sinceKeyframe = 0;
+    } else {
+        size = compressDelta(frame);
+        ++m_sinceKeyframe;
+    }
+
+    entry(m_count) = Entry{
+        static_cast<std::uint32_t>(offset), static_cast<std::uint16_t>(size), keyframe
+    };
+
+    ++m_count;
+    m_usedBytes += size;
+    m_newestState = next;
+}
+
+bool RewindBuffer::rewind(Chip8& chip8) {
+    if (m_count < 2)
+        return false;
+
+    m_usedBytes -= entry(m_count - 1).size;
+    --m_count;
+
+    rebuildNewest();
+    chip8.loadState(m_states[m_newestState]);
+
+    // The rebuilt state's memory is the machine's now, share its pages again
+    chip8.saveState(m_states[m_newestState], m_memories[m_newestState]);
+
+    return true;
+}
+
+void RewindBuffer::clear() {
+    m_first = 0;
+    m_count = 0;
+    m_sinceKeyframe = 0;
+    m_usedBytes = 0;
+}
+
+void RewindBuffer::dropOldestSecond() {
+    do {
+        m_usedBytes -= entry(0).size;
+        m_first = (m_first + 1) % kMaxFrames;
+        --m_count;
+    } while (m_count > 0 && !entry(0).keyframe);
+}
+
+std::size_t RewindBuffer::allocate(std::size_t size) {
+    /*
+     * Frames are stored one after the other, from the oldest on, wrapping
+     * around to the start of the buffer when the next doesn't fit before the
+     * end. The space after the newest frame holds the oldest frames once
+     * the buffer has wrapped around.
+     */
+    while (m_count > 0) {
+        const Entry& newest = entry(m_count - 1);
+        const std::size_t end = newest.offset + newest.size;
+        const std::size_t oldest = entry(0).offset;
+
+        if (end + size <= kBufferSize) {
+            if (oldest < end || oldest >= end + size)
+                return end;
+        } else if (oldest < end && oldest >= size) {
+            // Wrapped around, the start of the buffer is free
+            return 0;
+        }
+
+        dropOldestSecond();
+    }
+
+    return 0;
+}
+
+std::size_t RewindBuffer::compressDelta(std::span<std::uint8_t> frame) const {
+    const std::span<const std::uint8_t> state = bytesOf(m_states[m_newestState ^ 1]);
+    const std::span<const std::uint8_t> base = bytesOf(m_states[m_newestState]);
+    std::size_t size{0};
+
+    for (std::size_t page{0}; page < Chip8::Memory::kPageCount; ++page) {
+        const std::size_t offset = page * kMemoryPageSize;
+
+        // Both states hold the same shared page, so the same bytes
+        if (m_memories[0].sharesPage(m_memories[1], page)) {
+            size += writeZeroRuns(kMemoryPageSize, frame.subspan(size));
+            continue;
+        }
+
+        size += compressZeroRunDelta(
+            state.subspan(offset, kMemoryPageSize), base.subspan(offset, kMemoryPageSize), frame.subspan(size)
+        );
+    }
+
+    return size + compressZeroRunDelta(
+        state.subspan(SaveState::kMemorySize), base.subspan(SaveState::kMemorySize), frame.subspan(size)
+    );
+}
+
+void RewindBuffer::rebuildNewest() {
+    // The newest keyframe, at most kKeyframeInterval - 1 frames back
+    std::size_t keyframe = m_count - 1;
+
+    while (!entry(keyframe).keyframe)
+        --keyframe;
+
+    const std::span<std::uint8_t> state = bytesOf(m_states[m_newestState]);
+    const std::span<const std::uint8_t> buffer = m_buffer;
+    bool valid = decompressZeroRuns(buffer.subspan(entry(keyframe).offset, entry(keyframe).size), state);
+
+    for (std::size_t age = keyframe + 1; age < m_count && valid; ++age)
+        valid = xorZeroRuns(buffer.subspan(entry(age).offset, entry(age).size), state);
+
+    if (!valid)
+        throw std::runtime_error("Corrupt rewind buffer");
+
+    m_sinceKeyframe = m_count - 1 - keyframe;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "Chip8.h"
+#include "SaveState.h"
+
+/*
+ * Rolling history of the machine state of every frame, for rewinding.
+ *
+ * Every kKeyframeInterval-th frame is stored in full, the frames between
+ * as the XOR of their state and the frame before, which is almost all zero.
+ * Both are compressed with ZeroRunLength.h, so a frame changing a few bytes
+ * takes a few bytes. Only the memory pages written since are copied and
+ * compared, the others are still shared with the memory kept for the state
+ * (see Chip8::saveState()), so recording scales with the pages a ROM writes.
+ * The first write to a page after recording copies the page. The oldest second is dropped when kMaxFrames frames are
+ * stored or the buffer is full.
+ *
+ * All memory is allocated up front, recording a frame doesn't allocate.
+ */
+class RewindBuffer {
+    public:
+        // Frames kept, 60 seconds at 60 frames per second
+        static constexpr std::size_t kMaxFrames = 60 * 60;
+
+        // A full state every second, the most deltas applied to rebuild a frame
+        static constexpr std::size_t kKeyframeInterval = 60;
+
+        // Bytes of compressed frames kept
+        static constexpr std::size_t kBufferSize = 4 * 1024 * 1024;
+
+    private:
+        // A recorded frame in m_buffer
+        struct Entry {
+            std::uint32_t offset;
+            std::uint16_t size;
+            bool keyframe;
+        };
+
+        std::vector<std::uint8_t> m_buffer;
+
+        // Ring of recorded frames, from the oldest at m_first
+        std::vector<Entry> m_entries;
+        std::size_t m_first{0};
+        std::size_t m_count{0};
+
+        // The state of the newest frame, which the next frame is a delta of,
+        // and space for the next frame
+        std::array<SaveState, 2> m_states{};
+        std::size_t m_newestState{0};
+
+        // The memory of each state, sharing the machine's pages saved into it
+        std::array<Chip8::Memory, 2> m_memories{};
+
+        // Frames recorded since the newest keyframe
+        std::size_t m_sinceKeyframe{0};
+
+        // Sum of the recorded frames' sizes
+        std::size_t m_usedBytes{0};
+
+        [[nodiscard]] Entry& entry(std::size_t age) {
+            return m_entries[(m_first + age) % kMaxFrames];
+        }
+
+        // Drop the oldest keyframe and its deltas
+        void dropOldestSecond();
+
+        // Find space for a frame of at most size bytes, dropping old frames as needed
+        std::size_t allocate(std::size_t size);
+
+        // Compress the delta from the newest state to the next into frame, returning its size
+        std::size_t compressDelta(std::span<std::uint8_t> frame) const;
+
+        // Rebuild the newest frame's state from its keyframe into m_states
+        void rebuildNewest();
+
+    public:
+        RewindBuffer();
+
+        // Record the state of the frame just emulated
+        void push(const Chip8& chip8);
+
+        // Drop the newest frame and load the one before it.
+        // Returns false, loading nothing, once only the oldest frame is left.
+        bool rewind(Chip8& chip8);
+
+        // Forget every frame, e.g. when a new ROM is loaded
+        void clear();
+
+        // Amount of frames recorded, rewind() goes back to the oldest
+        [[nodiscard]] std::size_t getFrameCount() const {
+            return m_count;
+        }
+
+        // Bytes taken by the recorded frames
+        [[nodiscard]] std::size_t getUsedBytes() const {
+            return m_usedBytes;
+        }
+};
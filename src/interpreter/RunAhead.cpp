@@ -0,0 +1,31 @@
+#include <string>
+#include <stdexcept>
+#include "RunAhead.h"
+
+RunAhead::RunAhead(std::uint32_t frames) {
+    setFrames(frames);
+}
+
+void RunAhead::setFrames(std::uint32_t frames) {
+    if (frames > kMaxFrames)
+        throw std::runtime_error(
+            "Can't run more than " + std::to_string(kMaxFrames) + " frames ahead: " + std::to_string(frames)
+        );
+
+    m_frames = frames;
+}
+
+std::span<const std::uint8_t> RunAhead::step(Chip8& chip8) {
+    chip8.step();
+
+    if (m_frames == 0)
+        return chip8.getFrameBuffer();
+
+    if (m_ahead)
+        chip8.cloneInto(*m_ahead);
+    else
+        m_ahead.emplace(chip8.fork());
+
+    m_ahead->step(m_frames);
+    return m_ahead->getFrameBuffer();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <span>
+#include <cstdint>
+#include <optional>
+#include "Chip8.h"
+
+/*
+ * Run-ahead, hiding the frames of lag between a ROM reading the keypad
+ * (EX9E/EXA1) and drawing the result (DXYN).
+ *
+ * Every frame the machine is emulated one frame, then a copy of it is
+ * emulated getFrames() more frames with the same keys held. The copy's
+ * framebuffer is shown instead of the machine's, so the effect of a key
+ * press is seen that many frames earlier. The copy is thrown away each
+ * frame: only the machine's own frames count and make sound.
+ *
+ * The copy shares the machine's memory pages and keeps its code caches
+ * (see Chip8::cloneInto()), so after the first frame running ahead doesn't
+ * allocate and costs about one frame of emulation per frame ahead.
+ */
+class RunAhead {
+    public:
+        // Most frames to run ahead, beyond any ROM's lag
+        static constexpr std::uint32_t kMaxFrames = 8;
+
+    private:
+        std::uint32_t m_frames{0};
+
+        // The copy run ahead, forked from the machine on first use
+        std::optional<Chip8> m_ahead;
+
+    public:
+        explicit RunAhead(std::uint32_t frames = 0);
+
+        // Throws std::runtime_error above kMaxFrames
+        void setFrames(std::uint32_t frames);
+
+        [[nodiscard]] std::uint32_t getFrames() const {
+            return m_frames;
+        }
+
+        // Emulate a frame of chip8, returning the framebuffer to show:
+        // getFrames() frames ahead of chip8's, or chip8's own with no run-ahead
+        std::span<const std::uint8_t> step(Chip8& chip8);
+};
@@ -0,0 +1,179 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include "SaveState.h"
+#include "../utils/AtomicFile.h"
+#include "../utils/ZeroRunLength.h"
+
+/*
+ * Encoded format, integers are little-endian:
+ * - "HCSS", the format's magic bytes
+ * - 16 bit version (SaveState::kVersion)
+ * - The fields of SaveState in declaration order, compressed with ZeroRunLength.h
+ */
+static constexpr std::array<std::uint8_t, 4> kMagic = {'H', 'C', 'S', 'S'};
+static constexpr std::size_t kHeaderSize = kMagic.size() + sizeof(std::uint16_t);
+
+// Size of the fields before compression
+static constexpr std::size_t kFieldsSize =
+    SaveState::kMemorySize + SaveState::kFrameBufferSize
+    + 16 + 16 * 2 + 1 + 2 + 2 + 2   // Registers, stack, stack size, PC, index, ROM size
+    + 1 + 1 + 1                     // Timers, beeping
+    + 2 + 1 + 1 + 1                 // Key states, AWAIT_KEY
+    + 4 + 1 + 8 + 8;                // Random state, finished, frame and instruction counts
+
+// ROMs are loaded at 0x200, the most memory they can take
+static constexpr std::size_t kMaxROMSize = SaveState::kMemorySize - 0x200;
+
+// Appends little-endian fields to a fixed size buffer
+class FieldWriter {
+    std::span<std::uint8_t> m_data;
+    std::size_t m_position{0};
+
+    public:
+        explicit FieldWriter(std::span<std::uint8_t> data) : m_data{data} {}
+
+        void put(std::uint64_t value, std::size_t bytes) {
+            for (std::size_t byte{0}; byte < bytes; ++byte)
+                m_data[m_position++] = static_cast<std::uint8_t>(value >> (byte * 8));
+        }
+
+        void put(std::span<const std::uint8_t> bytes) {
+            std::ranges::copy(bytes, m_data.subspan(m_position).begin());
+            m_position += bytes.size();
+        }
+};
+
+// Reads the fields written by FieldWriter
+class FieldReader {
+    std::span<const std::uint8_t> m_data;
+    std::size_t m_position{0};
+
+    public:
+        explicit FieldReader(std::span<const std::uint8_t> data) : m_data{data} {}
+
+        std::uint64_t get(std::size_t bytes) {
+            std::uint64_t value{0};
+
+            for (std::size_t byte{0}; byte < bytes; ++byte)
+                value |= static_cast<std::uint64_t>(m_data[m_position++]) << (byte * 8);
+
+            return value;
+        }
+
+        void get(std::span<std::uint8_t> bytes) {
+            std::ranges::copy(m_data.subspan(m_position, bytes.size()), bytes.begin());
+            m_position += bytes.size();
+        }
+
+        bool getBool() {
+            return get(1) != 0;
+        }
+};
+
+std::vector<std::uint8_t> encodeSaveState(const SaveState& state) {
+    std::array<std::uint8_t, kFieldsSize> fields{};
+    FieldWriter writer{fields};
+
+    writer.put(state.memory);
+    writer.put(state.frameBuffer);
+    writer.put(state.registers);
+
+    for (const std::uint16_t address : state.stack)
+        writer.put(address, 2);
+
+    writer.put(state.stackSize, 1);
+    writer.put(state.PC, 2);
+    writer.put(state.index, 2);
+    writer.put(state.ROMSize, 2);
+    writer.put(state.delayTimer, 1);
+    writer.put(state.soundTimer, 1);
+    writer.put(state.beeping, 1);
+    writer.put(state.keyStates, 2);
+    writer.put(state.awaitingKey, 1);
+    writer.put(state.awaitingKeyPressed, 1);
+    writer.put(state.awaitingKeyRegNum, 1);
+    writer.put(state.randomState, 4);
+    writer.put(state.finished, 1);
+    writer.put(state.frameCount, 8);
+    writer.put(state.instructionCount, 8);
+
+    std::vector<std::uint8_t> data(kHeaderSize + maxZeroRunCompressedSize(kFieldsSize));
+    FieldWriter header{data};
+    header.put(kMagic);
+    header.put(SaveState::kVersion, 2);
+
+    const std::size_t compressedSize = compressZeroRuns(fields, std::span{data}.subspan(kHeaderSize));
+    data.resize(kHeaderSize + compressedSize);
+
+    return data;
+}
+
+SaveState decodeSaveState(std::span<const std::uint8_t> data) {
+    if (data.size() < kHeaderSize || !std::ranges::equal(data.first(kMagic.size()), kMagic))
+        throw std::runtime_error("Not a save state");
+
+    FieldReader header{data.subspan(kMagic.size())};
+    const auto version = static_cast<std::uint16_t>(header.get(2));
+
+    if (version != SaveState::kVersion)
+        throw std::runtime_error(
+            "Unsupported save state version " + std::to_string(version)
+            + ", expected " + std::to_string(SaveState::kVersion)
+        );
+
+    std::array<std::uint8_t, kFieldsSize> fields{};
+
+    if (!decompressZeroRuns(data.subspan(kHeaderSize), fields))
+        throw std::runtime_error("Corrupt save state");
+
+    SaveState state;
+    FieldReader reader{fields};
+
+    reader.get(state.memory);
+    reader.get(state.frameBuffer);
+    reader.get(state.registers);
+
+    for (std::uint16_t& address : state.stack)
+        address = static_cast<std::uint16_t>(reader.get(2));
+
+    state.stackSize = static_cast<std::uint8_t>(reader.get(1));
+    state.PC = static_cast<std::uint16_t>(reader.get(2));
+    state.index = static_cast<std::uint16_t>(reader.get(2));
+    state.ROMSize = static_cast<std::uint16_t>(reader.get(2));
+    state.delayTimer = static_cast<std::uint8_t>(reader.get(1));
+    state.soundTimer = static_cast<std::uint8_t>(reader.get(1));
+    state.beeping = reader.getBool();
+    state.keyStates = static_cast<std::uint16_t>(reader.get(2));
+    state.awaitingKey = reader.getBool();
+    state.awaitingKeyPressed = reader.getBool();
+    state.awaitingKeyRegNum = static_cast<std::uint8_t>(reader.get(1));
+    state.randomState = static_cast<std::uint32_t>(reader.get(4));
+    state.finished = reader.getBool();
+    state.frameCount = reader.get(8);
+    state.instructionCount = reader.get(8);
+
+    // Values the interpreter relies on being in range
+    if (state.stackSize > state.stack.size() || state.awaitingKeyRegNum >= state.registers.size()
+        || state.ROMSize > kMaxROMSize)
+        throw std::runtime_error("Corrupt save state");
+
+    return state;
+}
+
+void writeSaveStateFile(const std::string& path, const SaveState& state) {
+    writeFileAtomically(path, encodeSaveState(state), "save state");
+}
+
+SaveState readSaveStateFile(const std::string& path) {
+    std::ifstream inFS{path, std::ifstream::binary};
+
+    if (!inFS.is_open())
+        throw std::runtime_error("Error opening save state: " + path + ", " + std::strerror(errno));
+
+    const std::vector<std::uint8_t> data{std::istreambuf_iterator<char>{inFS}, std::istreambuf_iterator<char>{}};
+    return decodeSaveState(data);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/*
+ * The complete machine state of a Chip8, taken by Chip8::saveState()
+ * and restored by Chip8::loadState().
+ *
+ * Plain data, so keeping a state in memory is a 4.5 KB copy. States are
+ * encoded to a versioned binary format for files, compressed with
+ * zero run-length encoding (see ZeroRunLength.h): a typical state with a
+ * small ROM is a few hundred bytes.
+ */
+struct SaveState {
+    // Size of emulated memory
+    static constexpr std::uint16_t kMemorySize = 0x1000;
+
+    // Framebuffer size in bytes, 8 pixels per byte
+    static constexpr std::uint16_t kFrameBufferSize = 64 * 32 / 8;
+
+    // Version of the encoding, increased whenever the encoded fields change
+    static constexpr std::uint16_t kVersion = 1;
+
+    std::array<std::uint8_t, kMemorySize> memory{};
+    std::array<std::uint8_t, kFrameBufferSize> frameBuffer{};
+
+    std::array<std::uint8_t, 16> registers{};
+    std::array<std::uint16_t, 16> stack{};
+    std::uint8_t stackSize{0};
+    std::uint16_t PC{0};
+    std::uint16_t index{0};
+
+    // Size of the loaded ROM, which sets the last instruction executed
+    std::uint16_t ROMSize{0};
+
+    std::uint8_t delayTimer{0};
+    std::uint8_t soundTimer{0};
+    bool beeping{false};
+
+    // Keypad and AWAIT_KEY state
+    std::uint16_t keyStates{0};
+    bool awaitingKey{false};
+    bool awaitingKeyPressed{false};
+    std::uint8_t awaitingKeyRegNum{0};
+
+    // State of the CXNN random number generator
+    std::uint32_t randomState{0};
+
+    bool finished{false};
+    std::uint64_t frameCount{0};
+    std::uint64_t instructionCount{0};
+};
+
+// Encode a state to the binary save state format
+std::vector<std::uint8_t> encodeSaveState(const SaveState& state);
+
+// Decode a state encoded by encodeSaveState().
+// Throws std::runtime_error for data which isn't a valid save state of this version.
+SaveState decodeSaveState(std::span<const std::uint8_t> data);
+
+// Write an encoded state to path, replacing the file only once it's complete
+void writeSaveStateFile(const std::string& path, const SaveState& state);
+
+// Read a state from a file written by writeSaveStateFile(), throws std::runtime_error on failure
+SaveState readSaveStateFile(const std::string& path);
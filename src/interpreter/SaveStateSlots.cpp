@@ -0,0 +1,105 @@
+#include <format>
+#include <utility>
+#include <stdexcept>
+#include <filesystem>
+#include "Chip8.h"
+#include "SaveStateSlots.h"
+#include "../utils/Logger.h"
+
+SaveStateSlots::SaveStateSlots(std::string filePrefix)
+    : m_filePrefix{std::move(filePrefix)}
+    , m_thread{&SaveStateSlots::run, this}
+{
+}
+
+SaveStateSlots::~SaveStateSlots() {
+    {
+        const std::lock_guard lock{m_mutex};
+        m_running = false;
+    }
+
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+void SaveStateSlots::run() {
+    // Write errors are logged from this thread
+    Logger::instance().registerThread();
+
+    std::unique_lock lock{m_mutex};
+
+    while (true) {
+        m_condition.wait(lock, [this] { return !m_pending.empty() || !m_running; });
+
+        // Pending writes are finished before exiting
+        if (m_pending.empty())
+            return;
+
+        PendingWrite write = std::move(m_pending.front());
+        m_pending.pop_front();
+        m_writing = true;
+
+        lock.unlock();
+
+        try {
+            writeSaveStateFile(write.path, write.state);
+        } catch (const std::exception& e) {
+            logText(LogLevel::Error, std::format("Failed to write save state of frame {}: {}", write.state.frameCount, e.what()));
+        }
+
+        lock.lock();
+        m_writing = false;
+        m_condition.notify_all();
+    }
+}
+
+std::string SaveStateSlots::slotPath(std::size_t slot) const {
+    return m_filePrefix + ".state" + std::to_string(slot + 1);
+}
+
+void SaveStateSlots::setFilePrefix(std::string filePrefix) {
+    // Earlier saves are still written under the old prefix
+    m_filePrefix = std::move(filePrefix);
+    m_used.fill(false);
+}
+
+void SaveStateSlots::save(std::size_t slot, const Chip8& chip8) {
+    if (slot >= kSlotCount)
+        throw std::runtime_error("Invalid save state slot: " + std::to_string(slot));
+
+    chip8.saveState(m_slots[slot]);
+    m_used[slot] = true;
+
+    {
+        const std::lock_guard lock{m_mutex};
+        m_pending.push_back({slotPath(slot), m_slots[slot]});
+    }
+
+    m_condition.notify_all();
+}
+
+bool SaveStateSlots::load(std::size_t slot, Chip8& chip8) {
+    if (slot >= kSlotCount)
+        throw std::runtime_error("Invalid save state slot: " + std::to_string(slot));
+
+    if (!m_used[slot]) {
+        const std::string path = slotPath(slot);
+
+        // A save made before the prefix last changed may still be writing the file
+        flush();
+
+        if (!std::filesystem::exists(path))
+            return false;
+
+        m_slots[slot] = readSaveStateFile(path);
+        m_used[slot] = true;
+    }
+
+    chip8.loadState(m_slots[slot]);
+    return true;
+}
+
+void SaveStateSlots::flush() {
+    std::unique_lock lock{m_mutex};
+    m_condition.wait(lock, [this] { return m_pending.empty() && !m_writing; });
+}
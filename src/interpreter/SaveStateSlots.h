@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <cstddef>
+#include <condition_variable>
+#include "SaveState.h"
+
+class Chip8;
+
+/*
+ * Numbered save state slots of a ROM.
+ *
+ * Saving copies the machine state into the slot, then a background thread
+ * encodes it and writes it to "<file prefix>.state<N>" (N counting from 1),
+ * so the frame loop never waits on disk. Loading restores the slot from
+ * memory, or the slot's file when it hasn't been saved in this session.
+ */
+class SaveStateSlots {
+    public:
+        static constexpr std::size_t kSlotCount = 4;
+
+    private:
+        // A state waiting to be written to disk
+        struct PendingWrite {
+            std::string path;
+            SaveState state;
+        };
+
+        std::array<SaveState, kSlotCount> m_slots{};
+        std::array<bool, kSlotCount> m_used{};
+
+        // Slot files are named after this, usually the ROM path
+        std::string m_filePrefix;
+
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::deque<PendingWrite> m_pending;
+        bool m_writing = false;
+        bool m_running = true;
+        std::thread m_thread;
+
+        // Writer thread: write pending states until destroyed
+        void run();
+
+        [[nodiscard]] std::string slotPath(std::size_t slot) const;
+
+    public:
+        explicit SaveStateSlots(std::string filePrefix);
+
+        // Finishes writing every saved state
+        ~SaveStateSlots();
+
+        SaveStateSlots(const SaveStateSlots&) = delete;
+        SaveStateSlots& operator=(const SaveStateSlots&) = delete;
+
+        // Empty every slot and name slot files after a different prefix (e.g. a new ROM)
+        void setFilePrefix(std::string filePrefix);
+
+        // Save the machine state to a slot, and asynchronously to the slot's file
+        void save(std::size_t slot, const Chip8& chip8);
+
+        // Load the machine state of a slot. Returns false if the slot has
+        // never been saved. Throws std::runtime_error for an invalid slot file.
+        bool load(std::size_t slot, Chip8& chip8);
+
+        // Wait until every saved state has been written to disk
+        void flush();
+};
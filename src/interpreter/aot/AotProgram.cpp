@@ -0,0 +1,46 @@
+#include <vector>
+#include <algorithm>
+#include "AotProgram.h"
+
+// Function local, so registration works during any static initialisation order
+static std::vector<const AotProgram*>& registeredPrograms() {
+    static std::vector<const AotProgram*> programs;
+    return programs;
+}
+
+void registerAotProgram(const AotProgram& program) {
+    registeredPrograms().push_back(&program);
+}
+
+const AotProgram* findAotProgram(std::span<const std::uint8_t> ROM) {
+    for (const AotProgram* program : registeredPrograms()) {
+        if (std::ranges::equal(program->ROM, ROM))
+            return program;
+    }
+
+    return nullptr;
+}
+
+AotBlockTable::AotBlockTable(const AotProgram& program) {
+    m_blockOf.fill(kNoBlock);
+
+    for (const AotBlock& block : program.blocks) {
+        m_entries[block.start] = block.code;
+
+        for (std::uint16_t instruction = block.start; instruction < block.end; instruction += 2)
+            m_blockOf[instruction] = block.start;
+    }
+}
+
+void AotBlockTable::invalidate(std::uint16_t address) {
+    if (address >= kMemorySize)
+        return;
+
+    // Only instructions starting at this byte or the byte before it contain it
+    for (const int instruction : {address - 1, static_cast<int>(address)}) {
+        if (instruction < 0 || m_blockOf[instruction] == kNoBlock)
+            continue;
+
+        m_entries[m_blockOf[instruction]] = nullptr;
+    }
+}
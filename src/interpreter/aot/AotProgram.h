@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <cstdint>
+#include <string_view>
+
+/*
+ * A ROM statically recompiled to C++ by hotchip-aot.
+ *
+ * Each basic block of the ROM's reachable code becomes one function,
+ * compiled into the executable alongside the core. Like the JIT's traces,
+ * blocks take the V register file, the index register and the most
+ * instructions they may execute, and return the amount executed (upper
+ * 16 bits) and the next address (lower 16 bits). They also take the block
+ * table, to call their successors directly while they are still enabled.
+ */
+class AotBlockTable;
+
+using AotBlockFunction = std::uint32_t (*)(
+    std::uint8_t* registers, std::uint16_t* index, std::uint32_t budget,
+    const AotBlockTable& blocks
+);
+
+struct AotBlock {
+    // Address of the block's first instruction, and one past its last instruction
+    std::uint16_t start;
+    std::uint16_t end;
+
+    AotBlockFunction code;
+};
+
+struct AotProgram {
+    // File name of the ROM the program was generated from
+    std::string_view name;
+
+    // ROM contents, a program is only used for the exact ROM it was generated from
+    std::span<const std::uint8_t> ROM;
+
+    std::span<const AotBlock> blocks;
+};
+
+// Add a program to the programs linked into the executable
+void registerAotProgram(const AotProgram& program);
+
+// Find the program generated from a ROM, or nullptr
+const AotProgram* findAotProgram(std::span<const std::uint8_t> ROM);
+
+// Registers a program during static initialisation, used by generated code
+struct AotRegistration {
+    explicit AotRegistration(const AotProgram& program) {
+        registerAotProgram(program);
+    }
+};
+
+/*
+ * Block lookup for a loaded program.
+ *
+ * Blocks whose code is overwritten are disabled, leaving the
+ * self-modified code to the interpreter until the ROM is reloaded.
+ */
+class AotBlockTable {
+    static constexpr std::uint16_t kMemorySize = 0x1000;
+
+    // No block contains the instruction
+    static constexpr std::uint16_t kNoBlock = 0xFFFF;
+
+    // Block starting at each address
+    std::array<AotBlockFunction, kMemorySize> m_entries{};
+
+    // Start of the block containing the instruction at each address
+    std::array<std::uint16_t, kMemorySize> m_blockOf{};
+
+    public:
+        explicit AotBlockTable(const AotProgram& program);
+
+        [[nodiscard]] AotBlockFunction getBlock(std::uint16_t address) const {
+            return m_entries[address];
+        }
+
+        // Disable blocks containing the byte at address, after a write to it
+        void invalidate(std::uint16_t address);
+};
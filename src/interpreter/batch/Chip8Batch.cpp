@@ -0,0 +1,666 @@
+#include <bit>
+#include <string>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "Chip8Batch.h"
+#include "../MicroOp.h"
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+
+namespace {
+    using LaneMask = std::uint32_t;
+
+    template<typename T>
+    using Lanes = std::array<T, Chip8Batch::kMaxLanes>;
+
+    constexpr std::size_t kLanes = Chip8Batch::kMaxLanes;
+
+    // Each bit of a byte of a lane mask, as a byte of 0xFF or 0x00 per lane (in little-endian order)
+    constexpr std::array<std::uint64_t, 256> kByteMasks = [] {
+        std::array<std::uint64_t, 256> masks{};
+
+        for (std::size_t bits{0}; bits < 256; ++bits) {
+            for (std::size_t lane{0}; lane < 8; ++lane) {
+                if (bits >> lane & 1)
+                    masks[bits] |= std::uint64_t{0xFF} << lane * 8;
+            }
+        }
+
+        return masks;
+    }();
+
+    /*
+     * The lanes an instruction applies to, as masks of all ones or all zeros
+     * per lane of each width. Operations assign through them without
+     * branches, which the compiler turns into vector blends.
+     */
+    struct Selection {
+        alignas(32) Lanes<std::uint8_t> bytes;
+        alignas(64) Lanes<std::uint16_t> words;
+
+        explicit Selection(LaneMask mask) {
+            for (std::size_t part{0}; part < kLanes / 8; ++part) {
+                const std::uint64_t bits = kByteMasks[mask >> part * 8 & 0xFF];
+                std::memcpy(&bytes[part * 8], &bits, sizeof(bits));
+            }
+
+            for (std::size_t lane{0}; lane < kLanes; ++lane)
+                words[lane] = static_cast<std::uint16_t>(static_cast<std::int8_t>(bytes[lane]));
+        }
+    };
+
+    // Set target to value(lane) in the selected lanes
+    template<typename Value>
+    void assign(Lanes<std::uint8_t>& target, const Selection& selection, Value value) {
+        for (std::size_t lane{0}; lane < kLanes; ++lane) {
+            const auto selected = selection.bytes[lane];
+            target[lane] = static_cast<std::uint8_t>((value(lane) & selected) | (target[lane] & ~selected));
+        }
+    }
+
+    template<typename Value>
+    void assign(Lanes<std::uint16_t>& target, const Selection& selection, Value value) {
+        for (std::size_t lane{0}; lane < kLanes; ++lane) {
+            const auto selected = selection.words[lane];
+            target[lane] = static_cast<std::uint16_t>((value(lane) & selected) | (target[lane] & ~selected));
+        }
+    }
+
+    // Lanes holding value
+    LaneMask equalLanes(const Lanes<std::uint8_t>& lanes, std::uint8_t value) {
+        #if defined(__AVX2__)
+            const __m256i values = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.data()));
+            return static_cast<LaneMask>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(values, _mm256_set1_epi8(static_cast<char>(value)))
+            ));
+        #elif defined(__SSE2__)
+            const __m128i wanted = _mm_set1_epi8(static_cast<char>(value));
+            const __m128i low = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes.data()));
+            const __m128i high = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes.data() + 16));
+
+            return static_cast<LaneMask>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, wanted)))
+                | static_cast<LaneMask>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, wanted))) << 16;
+        #else
+            LaneMask equal{0};
+
+            for (std::size_t lane{0}; lane < kLanes; ++lane)
+                equal |= static_cast<LaneMask>(lanes[lane] == value) << lane;
+
+            return equal;
+        #endif
+    }
+
+    LaneMask equalLanes(const Lanes<std::uint16_t>& lanes, std::uint16_t value) {
+        #if defined(__SSE2__)
+            // Compare 8 lanes a vector, packing each pair of results to bytes
+            const __m128i wanted = _mm_set1_epi16(static_cast<short>(value));
+            const auto* vectors = reinterpret_cast<const __m128i*>(lanes.data());
+            LaneMask equal{0};
+
+            for (std::size_t half{0}; half < 2; ++half) {
+                const __m128i first = _mm_cmpeq_epi16(_mm_load_si128(vectors + half * 2), wanted);
+                const __m128i second = _mm_cmpeq_epi16(_mm_load_si128(vectors + half * 2 + 1), wanted);
+                equal |= static_cast<LaneMask>(_mm_movemask_epi8(_mm_packs_epi16(first, second))) << half * 16;
+            }
+
+            return equal;
+        #else
+            LaneMask equal{0};
+
+            for (std::size_t lane{0}; lane < kLanes; ++lane)
+                equal |= static_cast<LaneMask>(lanes[lane] == value) << lane;
+
+            return equal;
+        #endif
+    }
+
+    // Lanes holding more than value
+    LaneMask greaterLanes(const Lanes<std::uint16_t>& lanes, std::uint16_t value) {
+        #if defined(__SSE2__)
+            // Unsigned: the saturating difference is zero unless above value
+            const __m128i bound = _mm_set1_epi16(static_cast<short>(value));
+            const __m128i zero = _mm_setzero_si128();
+            const auto* vectors = reinterpret_cast<const __m128i*>(lanes.data());
+            LaneMask greater{0};
+
+            for (std::size_t half{0}; half < 2; ++half) {
+                const __m128i first = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_load_si128(vectors + half * 2), bound), zero);
+                const __m128i second = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_load_si128(vectors + half * 2 + 1), bound), zero);
+                greater |= static_cast<LaneMask>(_mm_movemask_epi8(_mm_packs_epi16(first, second))) << half * 16;
+            }
+
+            return ~greater;
+        #else
+            LaneMask greater{0};
+
+            for (std::size_t lane{0}; lane < kLanes; ++lane)
+                greater |= static_cast<LaneMask>(lanes[lane] > value) << lane;
+
+            return greater;
+        #endif
+    }
+
+    // Call function with every lane of mask, lowest first
+    template<typename Function>
+    void forEachLane(LaneMask mask, Function function) {
+        while (mask != 0) {
+            function(static_cast<std::size_t>(std::countr_zero(mask)));
+            mask &= mask - 1;
+        }
+    }
+}
+
+Chip8Batch::Chip8Batch(const Chip8& chip8, std::size_t lanes)
+    : m_lanes{lanes >= kMaxLanes ? ~LaneMask{0} : (LaneMask{1} << lanes) - 1}
+    , m_memory{std::make_unique<std::array<Lanes<std::uint8_t>, kMemorySize>>()}
+    , m_pristine{std::make_unique<SaveState>()}
+{
+    if (lanes == 0 || lanes > kMaxLanes)
+        throw std::runtime_error("A batch runs 1 to " + std::to_string(kMaxLanes) + " lanes");
+
+    chip8.saveState(*m_pristine);
+    m_ROMSize = m_pristine->ROMSize;
+
+    for (std::size_t lane{0}; lane < lanes; ++lane)
+        loadState(lane, *m_pristine);
+}
+
+std::size_t Chip8Batch::getLaneCount() const {
+    return static_cast<std::size_t>(std::popcount(m_lanes));
+}
+
+void Chip8Batch::step(std::uint32_t frames) {
+    for (std::uint32_t frame{0}; frame < frames; ++frame) {
+        for (std::uint16_t instruction{0}; instruction < Chip8::kInstructionsPerFrame; ++instruction)
+            executeStep();
+
+        finishFrame();
+    }
+}
+
+void Chip8Batch::executeStep() {
+    LaneMask runnable = m_lanes & ~m_awaitingKey & ~m_finished;
+
+    if (runnable == 0)
+        return;
+
+    // Lanes past the ROM's final instruction have finished, without executing one
+    const LaneMask past = greaterLanes(m_PC, m_finalInstruction);
+    m_finished |= runnable & past;
+    runnable &= ~past;
+
+    // Every lane left executes one instruction, in a group or alone
+    const LaneMask executing = runnable;
+    ++m_statistics.steps;
+
+    // The lowest lane left leads a group of the lanes running the same instruction as it
+    while (runnable != 0) {
+        const auto leader = static_cast<std::size_t>(std::countr_zero(runnable));
+        const std::uint16_t PC = m_PC[leader];
+        const auto instruction = static_cast<std::uint16_t>((*m_memory)[PC][leader] << 8 | (*m_memory)[PC + 1][leader]);
+
+        const LaneMask group = matchInstruction(runnable, PC, instruction);
+        execute(instruction, group);
+
+        runnable &= ~group;
+        ++m_statistics.groups;
+    }
+
+    m_statistics.instructions += static_cast<std::uint64_t>(std::popcount(executing));
+
+    // Counts are relative to the steps, only lanes which sat this one out change
+    forEachLane(m_lanes & ~executing, [&](std::size_t lane) {
+        --m_instructionCount[lane];
+    });
+}
+
+Chip8Batch::LaneMask Chip8Batch::matchInstruction(LaneMask candidates, std::uint16_t PC, std::uint16_t instruction) const {
+    // A lane may have written over its own copy of the code
+    return candidates & equalLanes(m_PC, PC)
+        & equalLanes((*m_memory)[PC], static_cast<std::uint8_t>(instruction >> 8))
+        & equalLanes((*m_memory)[PC + 1], static_cast<std::uint8_t>(instruction));
+}
+
+std::uint8_t Chip8Batch::readMemory(std::size_t lane, std::uint16_t address) const {
+    address = MemoryBounds::wrap<kMemorySize>(address);
+
+    if (!MemoryBounds::allows<kMemorySize>(address) || address >= kMemorySize) [[unlikely]]
+        return 0;
+
+    return (*m_memory)[address][lane];
+}
+
+void Chip8Batch::writeMemory(std::size_t lane, std::uint16_t address, std::uint8_t value) {
+    address = MemoryBounds::wrap<kMemorySize>(address);
+
+    if (!MemoryBounds::allows<kMemorySize>(address) || address >= kMemorySize) [[unlikely]]
+        return;
+
+    (*m_memory)[address][lane] = value;
+    m_dirtyBlocks[address / kDirtyBlockSize] |= LaneMask{1} << lane;
+}
+
+/*
+ * Semantics match Chip8::executeMicroOp() exactly. Operations on registers,
+ * I, the PC and timers apply to every lane at once through the selection,
+ * those on each lane's stack, memory or framebuffer loop over the group.
+ */
+void Chip8Batch::execute(std::uint16_t word, LaneMask group) {
+    // Instructions are two bytes, a skip moves past the next instruction
+    constexpr std::uint16_t kNext = 2;
+    constexpr std::uint16_t kSkip = 4;
+
+    const DecodedInstruction instruction = decodeMicroOp(word);
+    const Selection selection{group};
+
+    Lanes<std::uint8_t>& VX = m_registers[instruction.x];
+    Lanes<std::uint8_t>& VY = m_registers[instruction.y];
+    Lanes<std::uint8_t>& VF = m_registers[0xF];
+
+    const auto advance = [&](std::uint16_t amount) {
+        assign(m_PC, selection, [&](std::size_t lane) { return m_PC[lane] + amount; });
+    };
+
+    const auto skipIf = [&](auto condition) {
+        assign(m_PC, selection, [&](std::size_t lane) {
+            return m_PC[lane] + (condition(lane) ? kSkip : kNext);
+        });
+    };
+
+    // Flags are computed before VX is written, VF is written last so it wins when X is F
+    Lanes<std::uint8_t> result;
+    Lanes<std::uint8_t> flag;
+
+    switch (instruction.op) {
+        case MicroOp::CLEAR_DISPLAY:
+            forEachLane(group, [&](std::size_t lane) {
+                m_frameBuffers[lane].fill(0);
+            });
+
+            advance(kNext);
+            break;
+        case MicroOp::RETURN:
+            forEachLane(group, [&](std::size_t lane) {
+                if (m_stackSize[lane] > 0) {
+                    m_PC[lane] = m_stack[--m_stackSize[lane]][lane];
+                } else {
+                    if (kDebugEnabled)
+                        logMessage(LogLevel::Error, "Return attempted from outside of subroutine at {}", m_PC[lane]);
+
+                    m_PC[lane] += kNext;
+                }
+            });
+            break;
+        case MicroOp::GOTO:
+            assign(m_PC, selection, [&](std::size_t) { return instruction.nnn; });
+            break;
+        case MicroOp::CALL:
+            forEachLane(group, [&](std::size_t lane) {
+                if (m_stackSize[lane] < kStackDepth) {
+                    m_stack[m_stackSize[lane]++][lane] = static_cast<std::uint16_t>(m_PC[lane] + kNext);
+                    m_PC[lane] = instruction.nnn;
+                } else {
+                    logMessage(LogLevel::Error, "Maximum stack depth exceeded at {}", m_PC[lane]);
+                    m_PC[lane] += kNext;
+                }
+            });
+            break;
+        case MicroOp::SKIP_EQ_IMM:
+            skipIf([&](std::size_t lane) { return VX[lane] == instruction.nn; });
+            break;
+        case MicroOp::SKIP_NE_IMM:
+            skipIf([&](std::size_t lane) { return VX[lane] != instruction.nn; });
+            break;
+        case MicroOp::SKIP_EQ_REG:
+            skipIf([&](std::size_t lane) { return VX[lane] == VY[lane]; });
+            break;
+        case MicroOp::SKIP_NE_REG:
+            skipIf([&](std::size_t lane) { return VX[lane] != VY[lane]; });
+            break;
+        case MicroOp::SET_IMM:
+            assign(VX, selection, [&](std::size_t) { return instruction.nn; });
+            advance(kNext);
+            break;
+        case MicroOp::ADD_IMM:
+            assign(VX, selection, [&](std::size_t lane) { return VX[lane] + instruction.nn; });
+            advance(kNext);
+            break;
+        case MicroOp::REG_ASSIGNMENT:
+            assign(VX, selection, [&](std::size_t lane) { return VY[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::REG_OR:
+            assign(VX, selection, [&](std::size_t lane) { return VX[lane] | VY[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::REG_AND:
+            assign(VX, selection, [&](std::size_t lane) { return VX[lane] & VY[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::REG_XOR:
+            assign(VX, selection, [&](std::size_t lane) { return VX[lane] ^ VY[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::REG_ADD:
+            for (std::size_t lane{0}; lane < kLanes; ++lane) {
+                const auto sum = static_cast<std::uint16_t>(VX[lane] + VY[lane]);
+                result[lane] = static_cast<std::uint8_t>(sum);
+                flag[lane] = sum > std::numeric_limits<std::uint8_t>::max();
+            }
+
+            assign(VX, selection, [&](std::size_t lane) { return result[lane]; });
+            assign(VF, selection, [&](std::size_t lane) { return flag[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::REG_SUBTRACT:
+            for (std::size_t lane{0}; lane < kLanes; ++lane) {
+                result[lane] = static_cast<std::uint8_t>(VX[lane] - VY[lane]);
+                flag[lane] = VX[lane] >= VY[lane];
+            }
+
+            assign(VX, selection, [&](std::size_t lane) { return result[lane]; });
+            assign(VF, selection, [&](std::size_t lane) { return flag[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::REG_DIFFERENCE:
+            for (std::size_t lane{0}; lane < kLanes; ++lane) {
+                result[lane] = static_cast<std::uint8_t>(VY[lane] - VX[lane]);
+                flag[lane] = VY[lane] >= VX[lane];
+            }
+
+            assign(VX, selection, [&](std::size_t lane) { return result[lane]; });
+            assign(VF, selection, [&](std::size_t lane) { return flag[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::REG_LSHIFT:
+            // QUIRK
+            for (std::size_t lane{0}; lane < kLanes; ++lane) {
+                result[lane] = static_cast<std::uint8_t>(VY[lane] << 1);
+                flag[lane] = VY[lane] >> 7;
+            }
+
+            assign(VX, selection, [&](std::size_t lane) { return result[lane]; });
+            assign(VF, selection, [&](std::size_t lane) { return flag[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::REG_RSHIFT:
+            // QUIRK
+            for (std::size_t lane{0}; lane < kLanes; ++lane) {
+                result[lane] = VY[lane] >> 1;
+                flag[lane] = VY[lane] & 1;
+            }
+
+            assign(VX, selection, [&](std::size_t lane) { return result[lane]; });
+            assign(VF, selection, [&](std::size_t lane) { return flag[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::SET_INDEX:
+            assign(m_index, selection, [&](std::size_t) { return instruction.nnn; });
+            advance(kNext);
+            break;
+        case MicroOp::JUMP_V0:
+            assign(m_PC, selection, [&](std::size_t lane) { return m_registers[0][lane] + instruction.nnn; });
+            break;
+        case MicroOp::RAND:
+            // Each lane's generator is Xorshift32, the modulo by NN isn't vectorised
+            forEachLane(group, [&](std::size_t lane) {
+                std::uint32_t state = m_random[lane];
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                m_random[lane] = state;
+
+                VX[lane] = static_cast<std::uint8_t>((state >> 24) & instruction.nn);
+            });
+
+            advance(kNext);
+            break;
+        case MicroOp::DRAW:
+            forEachLane(group, [&](std::size_t lane) {
+                const std::uint8_t x = VX[lane];
+                const std::uint8_t y = VY[lane];
+                bool bitFlipped = false;
+
+                for (std::uint8_t row{0}; row < instruction.n; ++row) {
+                    const std::uint8_t rowData = readMemory(lane, static_cast<std::uint16_t>(m_index[lane] + row));
+                    bitFlipped = Chip8::drawSpriteRow(m_frameBuffers[lane], x, y + row, rowData) || bitFlipped;
+                }
+
+                VF[lane] = bitFlipped;
+            });
+
+            advance(kNext);
+            break;
+        case MicroOp::IS_KEY_PRESSED:
+            skipIf([&](std::size_t lane) { return (m_keyStates[lane] >> (VX[lane] & 0xF) & 1) != 0; });
+            break;
+        case MicroOp::IS_KEY_NOT_PRESSED:
+            skipIf([&](std::size_t lane) { return (m_keyStates[lane] >> (VX[lane] & 0xF) & 1) == 0; });
+            break;
+        case MicroOp::TIMER_GET_DELAY:
+            assign(VX, selection, [&](std::size_t lane) { return m_delayTimer[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::TIMER_DELAY_SET:
+            assign(m_delayTimer, selection, [&](std::size_t lane) { return VX[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::TIMER_SOUND_SET:
+            assign(m_soundTimer, selection, [&](std::size_t lane) { return VX[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::AWAIT_KEY:
+            m_awaitingKey |= group;
+            assign(m_awaitingKeyRegNum, selection, [&](std::size_t) { return instruction.x; });
+            advance(kNext);
+            break;
+        case MicroOp::ADD_TO_I:
+            assign(m_index, selection, [&](std::size_t lane) { return m_index[lane] + VX[lane]; });
+            advance(kNext);
+            break;
+        case MicroOp::LOAD_CHAR:
+            // Each font consists of five bytes.
+            forEachLane(group, [&](std::size_t lane) {
+                m_index[lane] = readMemory(lane, static_cast<std::uint16_t>(kFontOffset + VX[lane] * 5));
+            });
+
+            advance(kNext);
+            break;
+        case MicroOp::BCD_VX:
+            forEachLane(group, [&](std::size_t lane) {
+                const std::uint8_t value = VX[lane];
+                const std::uint16_t index = m_index[lane];
+
+                writeMemory(lane, index, value / 100);
+                writeMemory(lane, static_cast<std::uint16_t>(index + 1), (value % 100) / 10);
+                writeMemory(lane, static_cast<std::uint16_t>(index + 2), value % 10);
+            });
+
+            advance(kNext);
+            break;
+        case MicroOp::DUMP_REG:
+            forEachLane(group, [&](std::size_t lane) {
+                for (std::uint8_t reg{0}; reg <= instruction.x; ++reg)
+                    writeMemory(lane, static_cast<std::uint16_t>(m_index[lane] + reg), m_registers[reg][lane]);
+            });
+
+            advance(kNext);
+            break;
+        case MicroOp::LOAD_REG:
+            forEachLane(group, [&](std::size_t lane) {
+                for (std::uint8_t reg{0}; reg <= instruction.x; ++reg)
+                    m_registers[reg][lane] = readMemory(lane, static_cast<std::uint16_t>(m_index[lane] + reg));
+            });
+
+            advance(kNext);
+            break;
+        default:
+            // UNKNOWN: no effect besides advancing the PC
+            if (kDebugEnabled)
+                logMessage(LogLevel::Debug, "Unknown instruction at: {}", m_PC[std::countr_zero(group)]);
+
+            advance(kNext);
+    }
+}
+
+void Chip8Batch::finishFrame() {
+    // Every lane's timers tick, as Chip8's do whether or not it ran
+    for (std::size_t lane{0}; lane < kMaxLanes; ++lane) {
+        m_beeping[lane] = m_soundTimer[lane] > 0;
+        m_delayTimer[lane] -= m_delayTimer[lane] > 0;
+        m_soundTimer[lane] -= m_soundTimer[lane] > 0;
+        ++m_frameCount[lane];
+    }
+}
+
+void Chip8Batch::setKeyState(std::size_t lane, std::uint8_t key, bool pressed) {
+    const auto keyBit = static_cast<std::uint16_t>(1 << (key & 0xF));
+    const LaneMask laneBit = LaneMask{1} << lane;
+
+    m_keyStates[lane] = static_cast<std::uint16_t>(pressed ? m_keyStates[lane] | keyBit : m_keyStates[lane] & ~keyBit);
+
+    if ((m_awaitingKey & laneBit) == 0)
+        return;
+
+    // As Chip8::setKeyState(), AWAIT_KEY finishes when a key is pressed and released
+    if (pressed) {
+        m_awaitingKeyPressed |= laneBit;
+    } else if ((m_awaitingKeyPressed & laneBit) != 0) {
+        m_registers[m_awaitingKeyRegNum[lane]][lane] = key & 0xF;
+        m_awaitingKey &= ~laneBit;
+        m_awaitingKeyPressed &= ~laneBit;
+    }
+}
+
+void Chip8Batch::setRandomSeed(std::size_t lane, std::uint32_t seed) {
+    m_random[lane] = Xorshift32{seed}.getState();
+}
+
+void Chip8Batch::saveState(std::size_t lane, SaveState& state) const {
+    const LaneMask laneBit = LaneMask{1} << lane;
+
+    for (std::uint16_t address{0}; address < kMemorySize; ++address)
+        state.memory[address] = (*m_memory)[address][lane];
+
+    state.frameBuffer = m_frameBuffers[lane];
+
+    for (std::uint8_t reg{0}; reg < Chip8::kRegisterAmount; ++reg)
+        state.registers[reg] = m_registers[reg][lane];
+
+    for (std::uint8_t entry{0}; entry < kStackDepth; ++entry)
+        state.stack[entry] = m_stack[entry][lane];
+
+    state.stackSize = m_stackSize[lane];
+    state.PC = m_PC[lane];
+    state.index = m_index[lane];
+    state.ROMSize = m_ROMSize;
+
+    state.delayTimer = m_delayTimer[lane];
+    state.soundTimer = m_soundTimer[lane];
+    state.beeping = m_beeping[lane] != 0;
+
+    state.keyStates = m_keyStates[lane];
+    state.awaitingKey = (m_awaitingKey & laneBit) != 0;
+    state.awaitingKeyPressed = (m_awaitingKeyPressed & laneBit) != 0;
+    state.awaitingKeyRegNum = m_awaitingKeyRegNum[lane];
+
+    state.randomState = m_random[lane];
+
+    state.finished = (m_finished & laneBit) != 0;
+    state.frameCount = m_frameCount[lane];
+    state.instructionCount = getInstructionCount(lane);
+}
+
+void Chip8Batch::loadState(std::size_t lane, const SaveState& state) {
+    // Lanes share the final instruction, so run the same ROM
+    if (state.ROMSize != m_ROMSize)
+        throw std::runtime_error("Every lane of a batch must run the same ROM");
+
+    const LaneMask laneBit = LaneMask{1} << lane;
+
+    // Blocks which differ from the pristine state are restored by reset()
+    for (std::size_t block{0}; block < m_dirtyBlocks.size(); ++block) {
+        const std::size_t base = block * kDirtyBlockSize;
+
+        for (std::size_t offset{0}; offset < kDirtyBlockSize; ++offset)
+            (*m_memory)[base + offset][lane] = state.memory[base + offset];
+
+        const bool pristine = std::memcmp(&state.memory[base], &m_pristine->memory[base], kDirtyBlockSize) == 0;
+        m_dirtyBlocks[block] = pristine ? m_dirtyBlocks[block] & ~laneBit : m_dirtyBlocks[block] | laneBit;
+    }
+
+    loadStateExceptMemory(lane, state);
+}
+
+void Chip8Batch::reset(std::size_t lane) {
+    const LaneMask laneBit = LaneMask{1} << lane;
+
+    // Blocks the lane never wrote still hold the pristine bytes
+    for (std::size_t block{0}; block < m_dirtyBlocks.size(); ++block) {
+        if ((m_dirtyBlocks[block] & laneBit) == 0)
+            continue;
+
+        const std::size_t base = block * kDirtyBlockSize;
+
+        for (std::size_t offset{0}; offset < kDirtyBlockSize; ++offset)
+            (*m_memory)[base + offset][lane] = m_pristine->memory[base + offset];
+
+        m_dirtyBlocks[block] &= ~laneBit;
+    }
+
+    loadStateExceptMemory(lane, *m_pristine);
+}
+
+void Chip8Batch::loadStateExceptMemory(std::size_t lane, const SaveState& state) {
+    const LaneMask laneBit = LaneMask{1} << lane;
+    const auto setLane = [&](LaneMask& mask, bool set) {
+        mask = set ? mask | laneBit : mask & ~laneBit;
+    };
+
+    m_frameBuffers[lane] = state.frameBuffer;
+
+    for (std::uint8_t reg{0}; reg < Chip8::kRegisterAmount; ++reg)
+        m_registers[reg][lane] = state.registers[reg];
+
+    for (std::uint8_t entry{0}; entry < kStackDepth; ++entry)
+        m_stack[entry][lane] = state.stack[entry];
+
+    m_stackSize[lane] = state.stackSize;
+    m_PC[lane] = state.PC;
+    m_index[lane] = state.index;
+    m_finalInstruction = static_cast<std::uint16_t>(kROMOffset + m_ROMSize - 2);
+
+    m_delayTimer[lane] = state.delayTimer;
+    m_soundTimer[lane] = state.soundTimer;
+    m_beeping[lane] = state.beeping;
+
+    m_keyStates[lane] = state.keyStates;
+    setLane(m_awaitingKey, state.awaitingKey);
+    setLane(m_awaitingKeyPressed, state.awaitingKeyPressed);
+    m_awaitingKeyRegNum[lane] = state.awaitingKeyRegNum;
+
+    setRandomSeed(lane, state.randomState);
+
+    setLane(m_finished, state.finished);
+    m_frameCount[lane] = state.frameCount;
+    m_instructionCount[lane] = state.instructionCount - m_statistics.steps;
+}
+
+std::span<const std::uint8_t> Chip8Batch::getFrameBuffer(std::size_t lane) const {
+    return m_frameBuffers[lane];
+}
+
+std::uint64_t Chip8Batch::getInstructionCount(std::size_t lane) const {
+    return m_instructionCount[lane] + m_statistics.steps;
+}
+
+bool Chip8Batch::isFinished(std::size_t lane) const {
+    return (m_finished & LaneMask{1} << lane) != 0;
+}
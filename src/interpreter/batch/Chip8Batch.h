@@ -0,0 +1,158 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include "../Chip8.h"
+#include "../SaveState.h"
+
+/*
+ * Up to 32 machines of the same ROM run in lockstep, e.g. an RL trainer
+ * stepping one game with different inputs.
+ *
+ * State is stored structure-of-arrays: each register, the PC, I, the
+ * timers and every byte of memory is an array of one element per lane.
+ * Every step, each lane executes one instruction. Lanes at the same PC
+ * with the same instruction word execute it together, each operation of
+ * the instruction applied to every lane at once under a mask of the lanes
+ * (vectorised by the compiler to SSE2, AVX2 when targeted). Memory is
+ * interleaved by lane, so the instruction at a PC is one row of 32 bytes,
+ * compared across lanes in a couple of vector instructions.
+ *
+ * Lanes stepping the same game mostly run the same code. When their PCs
+ * diverge, each group of lanes at the same PC executes in turn, a lane
+ * alone costing about what a scalar interpreter would, until they reach
+ * the same PC again.
+ *
+ * Lanes execute exactly the instructions a Chip8 would on the same input,
+ * so a lane's state (see saveState()) matches a Chip8's on any engine.
+ * Lanes are headless, frames and sound aren't presented anywhere.
+ */
+class Chip8Batch {
+    public:
+        static constexpr std::size_t kMaxLanes = 32;
+
+        struct Statistics {
+            // Instructions executed, summed over lanes
+            std::uint64_t instructions{0};
+
+            // Steps of every lane, and groups of lanes executing an instruction together.
+            // instructions / groups is how many lanes ran each instruction on average.
+            std::uint64_t steps{0};
+            std::uint64_t groups{0};
+        };
+
+    private:
+        // One bit per lane
+        using LaneMask = std::uint32_t;
+
+        template<typename T>
+        using Lanes = std::array<T, kMaxLanes>;
+
+        static constexpr std::uint16_t kMemorySize = SaveState::kMemorySize;
+        static constexpr std::uint16_t kFrameBufferSize = SaveState::kFrameBufferSize;
+
+        // As in Chip8
+        static constexpr std::uint16_t kROMOffset = 0x200;
+        static constexpr std::uint8_t kFontOffset = 0x50;
+        static constexpr std::uint8_t kStackDepth = 16;
+
+        // Lanes in use, and every lane's final instruction (the ROM is the same)
+        LaneMask m_lanes;
+        std::uint16_t m_ROMSize{0};
+        std::uint16_t m_finalInstruction{0};
+
+        // Lanes blocked in AWAIT_KEY, holding a key down in it, and finished
+        LaneMask m_awaitingKey{0};
+        LaneMask m_awaitingKeyPressed{0};
+        LaneMask m_finished{0};
+
+        // Hot state, by register (or stack entry) then lane
+        alignas(64) std::array<Lanes<std::uint8_t>, Chip8::kRegisterAmount> m_registers{};
+        alignas(64) Lanes<std::uint16_t> m_PC{};
+        alignas(64) Lanes<std::uint16_t> m_index{};
+        alignas(64) Lanes<std::uint32_t> m_random{};
+        alignas(64) Lanes<std::uint8_t> m_delayTimer{};
+        alignas(32) Lanes<std::uint8_t> m_soundTimer{};
+        alignas(32) Lanes<std::uint8_t> m_beeping{};
+        alignas(32) Lanes<std::uint8_t> m_stackSize{};
+        alignas(64) std::array<Lanes<std::uint16_t>, kStackDepth> m_stack{};
+        alignas(64) Lanes<std::uint16_t> m_keyStates{};
+        Lanes<std::uint8_t> m_awaitingKeyRegNum{};
+
+        // Memory by address then lane, 128 KB
+        std::unique_ptr<std::array<Lanes<std::uint8_t>, kMemorySize>> m_memory;
+
+        // State the batch was created from, which reset() restores, and by block of
+        // memory the lanes which may hold other bytes than it (written since)
+        static constexpr std::uint16_t kDirtyBlockSize = 64;
+
+        std::unique_ptr<SaveState> m_pristine;
+        std::array<LaneMask, kMemorySize / kDirtyBlockSize> m_dirtyBlocks{};
+
+        // Framebuffers by lane, a lane's DXYN writes only its own
+        std::array<std::array<std::uint8_t, kFrameBufferSize>, kMaxLanes> m_frameBuffers{};
+
+        Lanes<std::uint64_t> m_frameCount{};
+
+        // Instructions executed by each lane, less the steps taken (see getInstructionCount()).
+        // Usually every lane executes in a step and none of these change.
+        Lanes<std::uint64_t> m_instructionCount{};
+
+        Statistics m_statistics;
+
+        // Run one instruction of every lane which can
+        void executeStep();
+
+        // Execute instruction at the PC of every lane in group
+        void execute(std::uint16_t instruction, LaneMask group);
+
+        // Lanes of candidates whose PC is PC and whose instruction there is instruction
+        [[nodiscard]] LaneMask matchInstruction(LaneMask candidates, std::uint16_t PC, std::uint16_t instruction) const;
+
+        // Emulated memory of a lane, through the MemoryBounds policy as in Chip8
+        [[nodiscard]] std::uint8_t readMemory(std::size_t lane, std::uint16_t address) const;
+        void writeMemory(std::size_t lane, std::uint16_t address, std::uint8_t value);
+
+        // Tick the timers of every lane
+        void finishFrame();
+
+        // Load all of state into a lane but its memory
+        void loadStateExceptMemory(std::size_t lane, const SaveState& state);
+
+    public:
+        // lanes (1 to kMaxLanes) copies of chip8's state
+        Chip8Batch(const Chip8& chip8, std::size_t lanes);
+
+        [[nodiscard]] std::size_t getLaneCount() const;
+
+        /*
+         * Emulate frames frames of every lane: kInstructionsPerFrame
+         * instructions each (fewer when blocked in FX0A or finished),
+         * then tick the timers.
+         */
+        void step(std::uint32_t frames = 1);
+
+        /*
+         * Restore a lane to the state the batch was created from, copying
+         * back only the blocks of memory it has written since, e.g. to start
+         * another episode of a game without loading it again.
+         */
+        void reset(std::size_t lane);
+
+        // Per-lane equivalents of Chip8's
+        void setKeyState(std::size_t lane, std::uint8_t key, bool pressed);
+        void setRandomSeed(std::size_t lane, std::uint32_t seed);
+        void saveState(std::size_t lane, SaveState& state) const;
+        void loadState(std::size_t lane, const SaveState& state);
+
+        [[nodiscard]] std::span<const std::uint8_t> getFrameBuffer(std::size_t lane) const;
+        [[nodiscard]] std::uint64_t getInstructionCount(std::size_t lane) const;
+        [[nodiscard]] bool isFinished(std::size_t lane) const;
+
+        [[nodiscard]] const Statistics& getStatistics() const {
+            return m_statistics;
+        }
+};
@@ -0,0 +1,60 @@
+#include "Chip8.h"
+
+/*
+ * AOT engine.
+ *
+ * Runs the blocks hotchip-aot generated for the loaded ROM, linked into the
+ * executable, and interprets everything else through the decode cache:
+ * instructions the recompiler leaves to the interpreter, targets of computed
+ * jumps (BNNN) it couldn't trace and blocks disabled by self-modifying code.
+ */
+std::uint16_t Chip8::runAotEngine(std::uint16_t finalInstruction, std::uint16_t budget) {
+    if (!m_aotProgram)
+        return runThreadedEngine(finalInstruction, budget);
+
+    if (!m_decodeCache)
+        m_decodeCache = std::make_unique<std::array<DecodedInstruction, kMemorySize>>();
+
+    if (!m_aotBlocks) {
+        m_aotBlocks = std::make_unique<AotBlockTable>(*m_aotProgram);
+
+        // Disable blocks whose code was written before the table existed,
+        // by another engine or by loading a save state
+        const std::span<const std::uint8_t> ROM = m_aotProgram->ROM;
+
+        for (std::uint16_t offset{0}; offset < ROM.size(); ++offset) {
+            if (m_memory[kROMOffset + offset] != ROM[offset])
+                m_aotBlocks->invalidate(kROMOffset + offset);
+        }
+    }
+
+    std::array<DecodedInstruction, kMemorySize>& cache = *m_decodeCache;
+    std::uint8_t* const registers = m_registers.getDataView().data();
+
+    std::uint16_t instructionsExecuted{0};
+
+    while (instructionsExecuted < budget && !m_awaitingKey) {
+        if (m_PC > finalInstruction) {
+            // All instructions have completed
+            m_finished = true;
+            break;
+        }
+
+        const AotBlockFunction block = m_aotBlocks->getBlock(m_PC);
+
+        if (block) {
+            const std::uint32_t result = block(
+                registers, &m_index, budget - instructionsExecuted, *m_aotBlocks
+            );
+
+            m_PC = static_cast<std::uint16_t>(result);
+            instructionsExecuted += result >> 16;
+        } else {
+            instructionsExecuted += executeCachedInstruction(
+                cache, finalInstruction, budget - instructionsExecuted
+            );
+        }
+    }
+
+    return instructionsExecuted;
+}
@@ -36,34 +36,25 @@ void Chip8::opcode0(std::uint16_t instruction) {
 
 	switch (lowByte) {
         case opcode::CLEAR_DISPLAY:
-            m_window.clearDisplay();
-	        m_window.pushInstructionHistory("DISPLAY CLEAR");
+            clearDisplay();
             break;
 	    case opcode::RETURN: {
-	        const std::uint16_t preReturnAddress{m_PC};
-
             if (m_stackSize > 0) {
                 // Pop return address from the stack
                 m_PC = m_stack[--m_stackSize];
                 m_PCUpdated = true;
             } else {
+                ++m_faults.emptyReturns;
+
                 if (kDebugEnabled)
-                    std::cout <<
-                        "[ERROR] Return attempted from outside of subroutine. "
-                        << instruction << std::endl;
+                    logMessage(LogLevel::Error, "Return attempted from outside of subroutine at {}", m_PC);
             }
 
-	        m_window.pushInstructionHistory(
-	            std::format("RETURN {} -> {}",
-	                u16toHex(preReturnAddress), u16toHex(m_PC)
-	            )
-	        );
-
             break;
         }
         default:
             if (kDebugEnabled)
-                std::cout << "[DEBUG] Unknown instruction: " << instruction << std::endl;
+                logMessage(LogLevel::Debug, "Unknown instruction: {}", instruction);
     }
 }
 
@@ -72,8 +63,6 @@ void Chip8::opcode1(std::uint16_t instruction) {
     // Update PC to new address from instruction
     m_PC = getAddressFromInstruction(instruction);
     m_PCUpdated = true;
-
-	m_window.pushInstructionHistory(std::format("GOTO {}", u16toHex(instruction)));
 }
 
 // CALL NNN
@@ -89,12 +78,9 @@ void Chip8::opcode2(std::uint16_t instruction) {
         m_PCUpdated = true;
     } else {
         // Output error and continue execution without calling subroutine
-        std::cout <<
-            "[ERROR] Maximum stack depth exceeded!"
-            << instruction << std::endl;
+        ++m_faults.stackOverflows;
+        logMessage(LogLevel::Error, "Maximum stack depth exceeded at {}", m_PC);
     }
-
-	m_window.pushInstructionHistory(std::format("CALL {}", u16toHex(m_PC)));
 }
 
 // if (Vx == NN)
@@ -108,10 +94,6 @@ void Chip8::opcode3(std::uint16_t instruction) {
 
     if (VX == NN)
         m_PC += 2;
-    
-	m_window.pushInstructionHistory(
-	    std::format("IF V{} == {}", u8toHex(regIndex), u8toHex(NN))
-	);
 }
 
 // if (Vx != NN)
@@ -125,10 +107,6 @@ void Chip8::opcode4(std::uint16_t instruction) {
 
     if (VX != NN)
         m_PC += 2;
-    
-    m_window.pushInstructionHistory(
-        std::format("IF V{} != {}", u8toHex(regIndex), u8toHex(NN))
-    );
 }
 
 // if (Vx == Vy)
@@ -143,10 +121,6 @@ void Chip8::opcode5(std::uint16_t instruction) {
 
     if (VX == VY)
         m_PC += 2;
-    
-    m_window.pushInstructionHistory(
-        std::format("IF V{} == V{}", u8toHex(VX_index), u8toHex(VY_index))
-    );
 }
 
 // VX = NN
@@ -159,10 +133,6 @@ void Chip8::opcode6(std::uint16_t instruction) {
 
     // Set VX = NN
     m_registers[VX] = NN;
-
-    m_window.pushInstructionHistory(
-        std::format("V{} = {}", u8toHex(VX), u8toHex(NN))
-    );
 }
 
 // VX += NN
@@ -175,10 +145,6 @@ void Chip8::opcode7(std::uint16_t instruction) {
 
     // Add NN to VX
     m_registers[VX] += NN;
-
-    m_window.pushInstructionHistory(
-        std::format("V{} += {}", u8toHex(VX), u8toHex(NN))
-    );
 }
 
 
@@ -199,31 +165,15 @@ void Chip8::opcode8(std::uint16_t instruction) {
     switch (lastNibble) {
         case opcode::REG_ASSIGNMENT:
             VX = VY;
-
-            m_window.pushInstructionHistory(
-                std::format("V{} = V{}", u8toHex(VX_index), u8toHex(VY_index))
-            );
             break;
         case opcode::REG_OR:
             VX |= VY;
-
-            m_window.pushInstructionHistory(
-                std::format("V{} |= V{}", u8toHex(VX_index), u8toHex(VY_index))
-            );
             break;
         case opcode::REG_AND:
             VX &= VY;
-
-            m_window.pushInstructionHistory(
-                std::format("V{} &= V{}", u8toHex(VX_index), u8toHex(VY_index))
-            );
             break;
         case opcode::REG_XOR:
             VX ^= VY;
-
-            m_window.pushInstructionHistory(
-                std::format("V{} ^= V{}", u8toHex(VX_index), u8toHex(VY_index))
-            );
             break;
         case opcode::REG_ADD:
         {
@@ -238,13 +188,6 @@ void Chip8::opcode8(std::uint16_t instruction) {
             } else {
                 VF = 0;
             }
-
-            m_window.pushInstructionHistory(
-                std::format(
-                    "V{} += V{}, VF = {}",
-                    u8toHex(VX_index), u8toHex(VY_index), u8toHex(VF)
-                )
-            );
             break;
         }
         case opcode::REG_SUBTRACT:
@@ -258,13 +201,6 @@ void Chip8::opcode8(std::uint16_t instruction) {
             } else {
                 VF = 1;
             }
-
-            m_window.pushInstructionHistory(
-                std::format(
-                    "V{} -= V{}, VF = {}",
-                    u8toHex(VX_index), u8toHex(VY_index), u8toHex(VF)
-                )
-            );
             break;
         }
         case opcode::REG_DIFFERENCE:
@@ -278,13 +214,6 @@ void Chip8::opcode8(std::uint16_t instruction) {
             } else {
                 VF = 1;
             }
-
-            m_window.pushInstructionHistory(
-                std::format(
-                    "V{} = V{} - V{}, VF = {}",
-                    u8toHex(VX_index), u8toHex(VY_index), u8toHex(VX_index), u8toHex(VF)
-                )
-            );
             break;
         }
         case opcode::REG_LSHIFT: {
@@ -296,13 +225,6 @@ void Chip8::opcode8(std::uint16_t instruction) {
 
             // Store MSB of VX in VF
             VF = VX_MSB;
-
-            m_window.pushInstructionHistory(
-                std::format(
-                    "V{} = V{} << 1, VF = {}",
-                    u8toHex(VX_index), u8toHex(VY_index), u8toHex(VF)
-                )
-            );
             break;
         }
         case opcode::REG_RSHIFT: {
@@ -314,18 +236,11 @@ void Chip8::opcode8(std::uint16_t instruction) {
 
             // Store LSB of VX in VF
             VF = VX_LSB;
-
-            m_window.pushInstructionHistory(
-                std::format(
-                    "V{} = V{} >> 1, VF = {}",
-                    u8toHex(VX_index), u8toHex(VY_index), u8toHex(VF)
-                )
-            );
             break;
         }
         default:
             if (kDebugEnabled)
-                std::cout << "[DEBUG] Unknown instruction: " << instruction << std::endl;
+                logMessage(LogLevel::Debug, "Unknown instruction: {}", instruction);
     }
 }
 
@@ -342,10 +257,6 @@ void Chip8::opcode9(std::uint16_t instruction) {
 
     if (VX != VY)
         m_PC += 2;
-
-    m_window.pushInstructionHistory(
-        std::format("IF V{} != V{}", u8toHex(VX_index), u8toHex(VY_index))
-    );
 }
 
 // I = NNN
@@ -355,10 +266,6 @@ void Chip8::opcodeA(std::uint16_t instruction) {
 
     // Set I to NNN
     m_index = NNN;
-
-    m_window.pushInstructionHistory(
-        std::format("I = {}", u16toHex(NNN))
-    );
 }
 
 // PC = V0 + NNN
@@ -369,23 +276,16 @@ void Chip8::opcodeB(std::uint16_t instruction) {
     // Set PC to V0 + NNN
     m_PC = V0 + NNN;
     m_PCUpdated = true;
-
-    m_window.pushInstructionHistory(
-        std::format("PC = {} + {}", u8toHex(V0), u16toHex(NNN))
-    );
 }
 
-// VX = rand(0, NN), NN < 256
+// VX = rand() & NN
 void Chip8::opcodeC(std::uint16_t instruction) {
     std::uint8_t regIndex = nibbleAt(instruction, 2);
     std::uint8_t& VX = m_registers[regIndex];
     std::uint8_t NN = getLowByte(instruction);
 
-    VX = m_randUint8(m_mersenneTwister) % NN;
-
-    m_window.pushInstructionHistory(
-        std::format("V{} = {} (RAND)", u8toHex(regIndex), u8toHex(VX))
-    );
+    // Masked rather than taken modulo NN, which would divide by zero for NN == 0
+    VX = m_random.nextByte() & NN;
 }
 
 // draw(Vx, Vy, N)
@@ -403,7 +303,7 @@ void Chip8::opcodeD(std::uint16_t instruction) {
         std::uint8_t rowData = m_memory[m_index + y];
 
         // Update the framebuffer to draw this rowData of pixels
-        bool rowBitFlip = m_window.drawRow(
+        bool rowBitFlip = drawRow(
             VX, VY + y, rowData
         );
 
@@ -418,13 +318,6 @@ void Chip8::opcodeD(std::uint16_t instruction) {
     } else {
         VF = 0;
     }
-
-    m_window.pushInstructionHistory(
-        std::format(
-            "DRAW: ({}, {}), N: {}, VF: ",
-            u8toHex(VX), u8toHex(VY), u8toHex(height), u8toHex(VF)
-        )
-    );
 }
 
 // Skip next instruction if key stored in VX is pressed
@@ -437,25 +330,17 @@ void Chip8::opcodeE(std::uint16_t instruction) {
 
     switch (lowByte) {
         case opcode::IS_KEY_PRESSED:
-            if (m_keyStates[VX])
+            if (isKeyPressed(VX))
                 // Instructions are two bytes, increment by two
                 m_PC += 2;
-
-            m_window.pushInstructionHistory(
-                std::format("SKIP IF {} PRESSED", u8toHex(VX))
-            );
             break;
         case opcode::IS_KEY_NOT_PRESSED:
-            if (!m_keyStates[VX])
+            if (!isKeyPressed(VX))
                 m_PC += 2;
-
-            m_window.pushInstructionHistory(
-                std::format("SKIP IF {} NOT PRESSED", u8toHex(VX))
-            );
             break;
         default:
             if (kDebugEnabled)
-                std::cout << "[DEBUG] Unknown instruction: " << instruction << std::endl;
+                logMessage(LogLevel::Debug, "Unknown instruction: {}", instruction);
     }
 }
 
@@ -471,87 +356,47 @@ void Chip8::opcodeF(std::uint16_t instruction) {
     switch (lowByte) {
         case opcode::TIMER_GET_DELAY:
             VX = m_delayTimer.readTimer();
-
-            m_window.pushInstructionHistory(
-                std::format("GET DELAY TIMER : {}", u8toHex(VX))
-            );
             break;
         case opcode::TIMER_DELAY_SET:
             m_delayTimer.setTimer(VX);
-
-            m_window.pushInstructionHistory(
-               std::format("SET DELAY TIMER: {}", u8toHex(VX))
-            );
             break;
         case opcode::TIMER_SOUND_SET:
-            m_window.pushInstructionHistory(
-              std::format("SET SOUND TIMER: {}", u8toHex(VX))
-            );
 
             m_soundTimer.setTimer(VX);
             break;
         case opcode::AWAIT_KEY:
-            // Behaviour of this instruction takes place in the main event loop in executionLoop()
+            // Behaviour of this instruction takes place in setKeyState(),
+            // execution is blocked until a key is pressed and released.
             m_awaitingKey = true;
-
-            m_window.pushInstructionHistory("AWAITING KEYPRESS");
+            m_awaitingKeyRegNum = VX_index;
             break;
         case opcode::ADD_TO_I:
             m_index += VX;
-
-            m_window.pushInstructionHistory(
-              std::format("I += {}, I = {}", u8toHex(VX), u8toHex(m_index))
-            );
             break;
         case opcode::LOAD_CHAR:
             // Each font consists of five bytes.
             m_index = m_memory[kFontOffset + (VX * 5)];
-
-            m_window.pushInstructionHistory(
-                std::format("LOAD CHAR: {}", u8toHex(VX))
-            );
             break;
         case opcode::BCD_VX:
             // Express VX's value in BCD format (hundreds, tens, ones)
-            m_memory[m_index] = VX / 100;
-            m_memory[m_index + 1] = (VX % 100) / 10;
-            m_memory[m_index + 2] = VX % 10;
-        
-            m_window.pushInstructionHistory(
-                std::format(
-                    "BCD V{} = {} INDEX: {}",
-                    u8toHex(VX_index), u8toHex(VX), u8toHex(m_index)
-                )
-            );
+            storeMemory(m_index, VX / 100);
+            storeMemory(m_index + 1, (VX % 100) / 10);
+            storeMemory(m_index + 2, VX % 10);
             break;
         case opcode::DUMP_REG:
             // Store the value of all registers up to VX, starting at the address of I
             for (std::uint8_t x = 0; x <= VX_index; ++x) {
-                m_memory[m_index + x] = m_registers[x];
+                storeMemory(m_index + x, m_registers[x]);
             }
-
-            m_window.pushInstructionHistory(
-                std::format(
-                    "DUMP REG: VX = {}, I = {}",
-                    u8toHex(VX_index), u8toHex(m_index)
-                )
-            );
             break;
         case opcode::LOAD_REG:
             // Load the values starting at the address of I into registers up to VX
             for (std::uint8_t x = 0; x <= VX_index; ++x) {
                 m_registers[x] = m_memory[m_index + x];
             }
-
-            m_window.pushInstructionHistory(
-                std::format(
-                    "LOAD REG: VX = {}, I = {}",
-                    u8toHex(VX_index), u8toHex(m_index)
-                )
-            );
             break;
         default:
             if (kDebugEnabled)
-                std::cout << "[DEBUG] Unknown instruction: " << instruction << std::endl;
+                logMessage(LogLevel::Debug, "Unknown instruction: {}", instruction);
     }
 }
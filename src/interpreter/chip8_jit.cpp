@@ -0,0 +1,54 @@
+#include "Chip8.h"
+
+/*
+ * JIT engine.
+ *
+ * Runs native traces from the JitCompiler wherever one starts at the PC,
+ * and interprets everything else through the decode cache. Traces are given
+ * the frame's remaining instruction budget and stop when it runs out, so
+ * frames end on exactly the same instruction as the other engines.
+ *
+ * Writes to memory discard the traces containing the written bytes
+ * (see storeMemory()), so self-modifying code is retranslated.
+ */
+std::uint16_t Chip8::runJitEngine(std::uint16_t finalInstruction, std::uint16_t budget) {
+    if constexpr (!kJitSupported)
+        return runThreadedEngine(finalInstruction, budget);
+
+    if (!m_decodeCache)
+        m_decodeCache = std::make_unique<std::array<DecodedInstruction, kMemorySize>>();
+
+    if (!m_jit)
+        m_jit = std::make_unique<JitCompiler>();
+
+    std::array<DecodedInstruction, kMemorySize>& cache = *m_decodeCache;
+    const PagedMemoryView memory = m_memory.getView();
+    std::uint8_t* const registers = m_registers.getDataView().data();
+
+    std::uint16_t instructionsExecuted{0};
+
+    while (instructionsExecuted < budget && !m_awaitingKey) {
+        if (m_PC > finalInstruction) {
+            // All instructions have completed
+            m_finished = true;
+            break;
+        }
+
+        const JitCompiler::Block& block = m_jit->getBlock(memory, m_PC, finalInstruction);
+
+        if (block.length != 0) {
+            const std::uint32_t result = block.code(
+                registers, &m_index, budget - instructionsExecuted
+            );
+
+            m_PC = static_cast<std::uint16_t>(result);
+            instructionsExecuted += result >> 16;
+        } else {
+            instructionsExecuted += executeCachedInstruction(
+                cache, finalInstruction, budget - instructionsExecuted
+            );
+        }
+    }
+
+    return instructionsExecuted;
+}
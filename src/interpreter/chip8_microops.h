@@ -0,0 +1,216 @@
+#pragma once
+
+#include <limits>
+#include "Chip8.h"
+
+/*
+ * Semantics of every micro-op, shared by the engines which execute
+ * pre-decoded instructions. Behaviour matches the opcodeN() handlers in
+ * chip8_execute.cpp exactly, minus the instruction history.
+ *
+ * Unlike decode(), each micro-op updates the PC itself rather than
+ * signalling jumps through m_PCUpdated.
+ */
+template<MicroOp op>
+inline void Chip8::executeMicroOp(const DecodedInstruction& instruction) {
+    // Instructions are two bytes, a skip moves past the next instruction
+    constexpr std::uint16_t kNext = 2;
+    constexpr std::uint16_t kSkip = 4;
+
+    [[maybe_unused]] const std::uint8_t x = instruction.x;
+    [[maybe_unused]] const std::uint8_t y = instruction.y;
+
+    if constexpr (op == MicroOp::CLEAR_DISPLAY) {
+        clearDisplay();
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::RETURN) {
+        if (m_stackSize > 0) {
+            // Pop return address from the stack
+            m_PC = m_stack[--m_stackSize];
+        } else {
+            ++m_faults.emptyReturns;
+
+            if (kDebugEnabled)
+                logMessage(LogLevel::Error, "Return attempted from outside of subroutine at {}", m_PC);
+
+            m_PC += kNext;
+        }
+    } else if constexpr (op == MicroOp::GOTO) {
+        m_PC = instruction.nnn;
+    } else if constexpr (op == MicroOp::CALL) {
+        // Stack limited to a maximum subroutine depth of 16.
+        if (m_stackSize < 16) {
+            m_stack[m_stackSize++] = m_PC + kNext;
+            m_PC = instruction.nnn;
+        } else {
+            ++m_faults.stackOverflows;
+            logMessage(LogLevel::Error, "Maximum stack depth exceeded at {}", m_PC);
+            m_PC += kNext;
+        }
+    } else if constexpr (op == MicroOp::SKIP_EQ_IMM) {
+        m_PC += (m_registers[x] == instruction.nn) ? kSkip : kNext;
+    } else if constexpr (op == MicroOp::SKIP_NE_IMM) {
+        m_PC += (m_registers[x] != instruction.nn) ? kSkip : kNext;
+    } else if constexpr (op == MicroOp::SKIP_EQ_REG) {
+        m_PC += (m_registers[x] == m_registers[y]) ? kSkip : kNext;
+    } else if constexpr (op == MicroOp::SKIP_NE_REG) {
+        m_PC += (m_registers[x] != m_registers[y]) ? kSkip : kNext;
+    } else if constexpr (op == MicroOp::SET_IMM) {
+        m_registers[x] = instruction.nn;
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::ADD_IMM) {
+        m_registers[x] += instruction.nn;
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::REG_ASSIGNMENT) {
+        m_registers[x] = m_registers[y];
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::REG_OR) {
+        m_registers[x] |= m_registers[y];
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::REG_AND) {
+        m_registers[x] &= m_registers[y];
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::REG_XOR) {
+        m_registers[x] ^= m_registers[y];
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::REG_ADD) {
+        const std::uint16_t sum = m_registers[x] + m_registers[y];
+
+        // VX is written before VF, so VF wins when X is F
+        m_registers[x] = sum;
+        m_registers[0xF] = sum > std::numeric_limits<std::uint8_t>::max();
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::REG_SUBTRACT) {
+        const bool underflow = m_registers[x] < m_registers[y];
+
+        m_registers[x] -= m_registers[y];
+        m_registers[0xF] = !underflow;
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::REG_DIFFERENCE) {
+        const bool underflow = m_registers[y] < m_registers[x];
+
+        m_registers[x] = m_registers[y] - m_registers[x];
+        m_registers[0xF] = !underflow;
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::REG_LSHIFT) {
+        // QUIRK
+        const std::uint8_t VY = m_registers[y];
+
+        m_registers[x] = VY << 1;
+        m_registers[0xF] = (VY & kMSBMask) >> 7;
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::REG_RSHIFT) {
+        // QUIRK
+        const std::uint8_t VY = m_registers[y];
+
+        m_registers[x] = VY >> 1;
+        m_registers[0xF] = VY & 1;
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::SET_INDEX) {
+        m_index = instruction.nnn;
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::JUMP_V0) {
+        m_PC = m_registers[0] + instruction.nnn;
+    } else if constexpr (op == MicroOp::RAND) {
+        m_registers[x] = m_random.nextByte() & instruction.nn;
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::DRAW) {
+        const std::uint8_t VX = m_registers[x];
+        const std::uint8_t VY = m_registers[y];
+        bool bitFlipped = false;
+
+        for (std::uint8_t row {0}; row < instruction.n; ++row)
+            bitFlipped = drawRow(VX, VY + row, m_memory[m_index + row]) || bitFlipped;
+
+        m_registers[0xF] = bitFlipped;
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::IS_KEY_PRESSED) {
+        m_PC += isKeyPressed(m_registers[x]) ? kSkip : kNext;
+    } else if constexpr (op == MicroOp::IS_KEY_NOT_PRESSED) {
+        m_PC += !isKeyPressed(m_registers[x]) ? kSkip : kNext;
+    } else if constexpr (op == MicroOp::TIMER_GET_DELAY) {
+        m_registers[x] = m_delayTimer.readTimer();
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::TIMER_DELAY_SET) {
+        m_delayTimer.setTimer(m_registers[x]);
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::TIMER_SOUND_SET) {
+        m_soundTimer.setTimer(m_registers[x]);
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::AWAIT_KEY) {
+        m_awaitingKey = true;
+        m_awaitingKeyRegNum = x;
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::ADD_TO_I) {
+        m_index += m_registers[x];
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::LOAD_CHAR) {
+        // Each font consists of five bytes.
+        m_index = m_memory[kFontOffset + (m_registers[x] * 5)];
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::BCD_VX) {
+        const std::uint8_t VX = m_registers[x];
+
+        storeMemory(m_index, VX / 100);
+        storeMemory(m_index + 1, (VX % 100) / 10);
+        storeMemory(m_index + 2, VX % 10);
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::DUMP_REG) {
+        for (std::uint8_t reg = 0; reg <= x; ++reg)
+            storeMemory(m_index + reg, m_registers[reg]);
+
+        m_PC += kNext;
+    } else if constexpr (op == MicroOp::LOAD_REG) {
+        for (std::uint8_t reg = 0; reg <= x; ++reg)
+            m_registers[reg] = m_memory[m_index + reg];
+
+        m_PC += kNext;
+    } else {
+        // UNKNOWN: no effect besides advancing the PC
+        if (kDebugEnabled)
+            logMessage(LogLevel::Debug, "Unknown instruction at: {}", m_PC);
+
+        m_PC += kNext;
+    }
+}
+
+template<MicroOp op>
+inline std::uint8_t Chip8::executeFused(const DecodedInstruction& instruction, std::uint16_t budget) {
+    constexpr std::uint16_t kNext = 2;
+
+    if (budget < fusedLength(op)) {
+        executeMicroOp<fusedFirstOp(op)>(instruction);
+        return 1;
+    }
+
+    const std::uint8_t x = instruction.x;
+
+    if constexpr (op == MicroOp::SET_INDEX_DRAW) {
+        m_index = instruction.nnn;
+        m_PC += kNext;
+        executeMicroOp<MicroOp::DRAW>(instruction);
+        return 2;
+    } else if constexpr (op == MicroOp::SET_IMM_PAIR) {
+        // The second write wins when both set the same register
+        m_registers[x] = instruction.nn;
+        m_registers[instruction.y] = instruction.n;
+        m_PC += 2 * kNext;
+        return 2;
+    } else if constexpr (op == MicroOp::ADD_SKIP_LOOP) {
+        m_registers[x] += instruction.nn;
+
+        // The skip leaves the loop past its 1NNN, otherwise the jump is taken
+        if (m_registers[x] == instruction.n) {
+            m_PC += 3 * kNext;
+            return 2;
+        }
+
+        m_PC = instruction.nnn;
+        return 3;
+    } else {
+        // DELAY_SKIP
+        m_registers[x] = m_delayTimer.readTimer();
+        m_PC += (m_registers[x] == instruction.nn) ? 3 * kNext : 2 * kNext;
+        return 2;
+    }
+}
@@ -0,0 +1,106 @@
+#include "chip8_microops.h"
+
+/*
+ * Pre-decoded engine.
+ *
+ * Each address is decoded into a DecodedInstruction the first time it is
+ * executed, after which the cached record is dispatched directly.
+ * Frequent sequences are fused into one entry (see fuseMicroOps()).
+ * FX33, FX55 and writeMemory() reset the entries they overwrite.
+ */
+std::uint16_t Chip8::runPreDecodedEngine(std::uint16_t finalInstruction, std::uint16_t budget) {
+    if (!m_decodeCache)
+        m_decodeCache = std::make_unique<std::array<DecodedInstruction, kMemorySize>>();
+
+    std::array<DecodedInstruction, kMemorySize>& cache = *m_decodeCache;
+
+    std::uint16_t instructionsExecuted{0};
+
+    // finalInstruction is at most kMemorySize - 2, so this bound check
+    // also keeps the fetch of the instruction's second byte in range.
+    while (instructionsExecuted < budget && !m_awaitingKey) {
+        if (m_PC > finalInstruction) {
+            // All instructions have completed
+            m_finished = true;
+            break;
+        }
+
+        instructionsExecuted += executeCachedInstruction(
+            cache, finalInstruction, budget - instructionsExecuted
+        );
+    }
+
+    return instructionsExecuted;
+}
+
+DecodedInstruction Chip8::decodeCacheEntry(std::uint16_t address, std::uint16_t finalInstruction) {
+    const auto decodeAt = [&](std::uint16_t offset) {
+        // Bytes past the ROM aren't code, they are never fused
+        if (address + offset > finalInstruction)
+            return DecodedInstruction{};
+
+        return decodeMicroOp(
+            static_cast<std::uint16_t>(m_memory[address + offset]) << 8 | m_memory[address + offset + 1]
+        );
+    };
+
+    return fuseMicroOps(decodeAt(0), decodeAt(2), decodeAt(4));
+}
+
+/*
+ * Execute the instruction at the PC through the decode cache.
+ * Also used by the JIT and AOT engines for instructions they don't compile.
+ */
+std::uint8_t Chip8::executeCachedInstruction(
+    std::array<DecodedInstruction, kMemorySize>& cache, std::uint16_t finalInstruction,
+    std::uint16_t budget
+) {
+    DecodedInstruction& instruction = cache[m_PC];
+
+    if (instruction.op == MicroOp::UNDECODED)
+        instruction = decodeCacheEntry(m_PC, finalInstruction);
+
+    switch (instruction.op) {
+        case MicroOp::SET_INDEX_DRAW: return executeFused<MicroOp::SET_INDEX_DRAW>(instruction, budget);
+        case MicroOp::SET_IMM_PAIR: return executeFused<MicroOp::SET_IMM_PAIR>(instruction, budget);
+        case MicroOp::ADD_SKIP_LOOP: return executeFused<MicroOp::ADD_SKIP_LOOP>(instruction, budget);
+        case MicroOp::DELAY_SKIP: return executeFused<MicroOp::DELAY_SKIP>(instruction, budget);
+        case MicroOp::CLEAR_DISPLAY: executeMicroOp<MicroOp::CLEAR_DISPLAY>(instruction); break;
+        case MicroOp::RETURN: executeMicroOp<MicroOp::RETURN>(instruction); break;
+        case MicroOp::GOTO: executeMicroOp<MicroOp::GOTO>(instruction); break;
+        case MicroOp::CALL: executeMicroOp<MicroOp::CALL>(instruction); break;
+        case MicroOp::SKIP_EQ_IMM: executeMicroOp<MicroOp::SKIP_EQ_IMM>(instruction); break;
+        case MicroOp::SKIP_NE_IMM: executeMicroOp<MicroOp::SKIP_NE_IMM>(instruction); break;
+        case MicroOp::SKIP_EQ_REG: executeMicroOp<MicroOp::SKIP_EQ_REG>(instruction); break;
+        case MicroOp::SET_IMM: executeMicroOp<MicroOp::SET_IMM>(instruction); break;
+        case MicroOp::ADD_IMM: executeMicroOp<MicroOp::ADD_IMM>(instruction); break;
+        case MicroOp::REG_ASSIGNMENT: executeMicroOp<MicroOp::REG_ASSIGNMENT>(instruction); break;
+        case MicroOp::REG_OR: executeMicroOp<MicroOp::REG_OR>(instruction); break;
+        case MicroOp::REG_AND: executeMicroOp<MicroOp::REG_AND>(instruction); break;
+        case MicroOp::REG_XOR: executeMicroOp<MicroOp::REG_XOR>(instruction); break;
+        case MicroOp::REG_ADD: executeMicroOp<MicroOp::REG_ADD>(instruction); break;
+        case MicroOp::REG_SUBTRACT: executeMicroOp<MicroOp::REG_SUBTRACT>(instruction); break;
+        case MicroOp::REG_RSHIFT: executeMicroOp<MicroOp::REG_RSHIFT>(instruction); break;
+        case MicroOp::REG_DIFFERENCE: executeMicroOp<MicroOp::REG_DIFFERENCE>(instruction); break;
+        case MicroOp::REG_LSHIFT: executeMicroOp<MicroOp::REG_LSHIFT>(instruction); break;
+        case MicroOp::SKIP_NE_REG: executeMicroOp<MicroOp::SKIP_NE_REG>(instruction); break;
+        case MicroOp::SET_INDEX: executeMicroOp<MicroOp::SET_INDEX>(instruction); break;
+        case MicroOp::JUMP_V0: executeMicroOp<MicroOp::JUMP_V0>(instruction); break;
+        case MicroOp::RAND: executeMicroOp<MicroOp::RAND>(instruction); break;
+        case MicroOp::DRAW: executeMicroOp<MicroOp::DRAW>(instruction); break;
+        case MicroOp::IS_KEY_PRESSED: executeMicroOp<MicroOp::IS_KEY_PRESSED>(instruction); break;
+        case MicroOp::IS_KEY_NOT_PRESSED: executeMicroOp<MicroOp::IS_KEY_NOT_PRESSED>(instruction); break;
+        case MicroOp::TIMER_GET_DELAY: executeMicroOp<MicroOp::TIMER_GET_DELAY>(instruction); break;
+        case MicroOp::TIMER_DELAY_SET: executeMicroOp<MicroOp::TIMER_DELAY_SET>(instruction); break;
+        case MicroOp::TIMER_SOUND_SET: executeMicroOp<MicroOp::TIMER_SOUND_SET>(instruction); break;
+        case MicroOp::AWAIT_KEY: executeMicroOp<MicroOp::AWAIT_KEY>(instruction); break;
+        case MicroOp::ADD_TO_I: executeMicroOp<MicroOp::ADD_TO_I>(instruction); break;
+        case MicroOp::LOAD_CHAR: executeMicroOp<MicroOp::LOAD_CHAR>(instruction); break;
+        case MicroOp::BCD_VX: executeMicroOp<MicroOp::BCD_VX>(instruction); break;
+        case MicroOp::DUMP_REG: executeMicroOp<MicroOp::DUMP_REG>(instruction); break;
+        case MicroOp::LOAD_REG: executeMicroOp<MicroOp::LOAD_REG>(instruction); break;
+        default: executeMicroOp<MicroOp::UNKNOWN>(instruction); break;
+    }
+
+    return 1;
+}
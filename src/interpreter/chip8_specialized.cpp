@@ -0,0 +1,58 @@
+#include "Chip8.h"
+
+/*
+ * Specialized engine.
+ *
+ * One handler exists per 16 bit instruction word (65,536 in total), each
+ * instantiated with the word as a template argument. Decoding happens
+ * entirely at compile time: the handler is executeMicroOp() with the micro-op
+ * and its X, Y, N, NN and NNN operands folded in as constants. Fetch and
+ * dispatch are a table lookup, with nothing cached, so self-modifying code
+ * needs no invalidation.
+ *
+ * The handlers cost several MB of code and a long compile, so they are only
+ * built with the HOTCHIP_SPECIALIZED_TABLE option (see specialized/).
+ */
+#if defined(HOTCHIP_SPECIALIZED_TABLE)
+
+std::uint16_t Chip8::runSpecializedEngine(std::uint16_t finalInstruction, std::uint16_t budget) {
+    // Handler tables by instruction prefix, constant initialised in their own files
+    static constexpr std::array<const std::array<SpecializedHandler, 0x1000>*, 16> kHandlers = {
+        &kSpecializedHandlers<0x0>, &kSpecializedHandlers<0x1>, &kSpecializedHandlers<0x2>,
+        &kSpecializedHandlers<0x3>, &kSpecializedHandlers<0x4>, &kSpecializedHandlers<0x5>,
+        &kSpecializedHandlers<0x6>, &kSpecializedHandlers<0x7>, &kSpecializedHandlers<0x8>,
+        &kSpecializedHandlers<0x9>, &kSpecializedHandlers<0xA>, &kSpecializedHandlers<0xB>,
+        &kSpecializedHandlers<0xC>, &kSpecializedHandlers<0xD>, &kSpecializedHandlers<0xE>,
+        &kSpecializedHandlers<0xF>
+    };
+
+    const PagedMemoryView memory = m_memory.getView();
+
+    std::uint16_t instructionsExecuted{0};
+
+    // finalInstruction is at most kMemorySize - 2, so this bound check
+    // also keeps the fetch of the instruction's second byte in range.
+    while (instructionsExecuted < budget && !m_awaitingKey) {
+        if (m_PC > finalInstruction) {
+            // All instructions have completed
+            m_finished = true;
+            break;
+        }
+
+        const std::uint8_t high = memory[m_PC];
+        const std::uint8_t low = memory[m_PC + 1];
+
+        (*kHandlers[high >> 4])[(high & 0xF) << 8 | low](*this);
+        instructionsExecuted++;
+    }
+
+    return instructionsExecuted;
+}
+
+#else
+
+std::uint16_t Chip8::runSpecializedEngine(std::uint16_t finalInstruction, std::uint16_t budget) {
+    return runThreadedEngine(finalInstruction, budget);
+}
+
+#endif
@@ -0,0 +1,281 @@
+#include "chip8_microops.h"
+
+/*
+ * Threaded engine.
+ *
+ * Executes the same pre-decoded micro-ops as the pre-decoded engine, but
+ * without a central dispatch switch. Every handler ends by fetching the
+ * next instruction and jumping straight to its handler through a table of
+ * label addresses (computed goto), so each handler gets its own indirect
+ * branch and the branch predictor can learn which op follows which.
+ *
+ * The PC update is folded into each handler by executeMicroOp().
+ * Computed goto is a GCC/Clang extension, other compilers fall back to
+ * the pre-decoded engine.
+ */
+std::uint16_t Chip8::runThreadedEngine(std::uint16_t finalInstruction, std::uint16_t budget) {
+#if defined(__GNUC__)
+    if (!m_decodeCache)
+        m_decodeCache = std::make_unique<std::array<DecodedInstruction, kMemorySize>>();
+
+    std::array<DecodedInstruction, kMemorySize>& cache = *m_decodeCache;
+
+    // Handler for every micro-op, in MicroOp order
+    static void* const kDispatchTable[] = {
+        &&op_UNDECODED,
+        &&op_UNKNOWN,
+        &&op_CLEAR_DISPLAY,
+        &&op_RETURN,
+        &&op_GOTO,
+        &&op_CALL,
+        &&op_SKIP_EQ_IMM,
+        &&op_SKIP_NE_IMM,
+        &&op_SKIP_EQ_REG,
+        &&op_SET_IMM,
+        &&op_ADD_IMM,
+        &&op_REG_ASSIGNMENT,
+        &&op_REG_OR,
+        &&op_REG_AND,
+        &&op_REG_XOR,
+        &&op_REG_ADD,
+        &&op_REG_SUBTRACT,
+        &&op_REG_RSHIFT,
+        &&op_REG_DIFFERENCE,
+        &&op_REG_LSHIFT,
+        &&op_SKIP_NE_REG,
+        &&op_SET_INDEX,
+        &&op_JUMP_V0,
+        &&op_RAND,
+        &&op_DRAW,
+        &&op_IS_KEY_PRESSED,
+        &&op_IS_KEY_NOT_PRESSED,
+        &&op_TIMER_GET_DELAY,
+        &&op_TIMER_DELAY_SET,
+        &&op_TIMER_SOUND_SET,
+        &&op_AWAIT_KEY,
+        &&op_ADD_TO_I,
+        &&op_LOAD_CHAR,
+        &&op_BCD_VX,
+        &&op_DUMP_REG,
+        &&op_LOAD_REG,
+        &&op_SET_INDEX_DRAW,
+        &&op_SET_IMM_PAIR,
+        &&op_ADD_SKIP_LOOP,
+        &&op_DELAY_SKIP
+    };
+
+    static_assert(
+        std::size(kDispatchTable) == static_cast<std::size_t>(MicroOp::COUNT),
+        "Dispatch table must have a handler for every micro-op"
+    );
+
+    std::uint16_t instructionsExecuted{0};
+    DecodedInstruction* instruction{nullptr};
+
+    // Execution stays blocked while an AWAIT_KEY is pending
+    if (m_awaitingKey)
+        return 0;
+
+    /*
+     * Count the instruction that just completed, then fetch the next
+     * instruction and jump to its handler. finalInstruction is at most
+     * kMemorySize - 2, so its bound check also keeps the fetch of the
+     * instruction's second byte in range.
+     */
+    #define DISPATCH()                                                          \
+        do {                                                                    \
+            if (++instructionsExecuted == budget)                              \
+                return instructionsExecuted;                                    \
+            FETCH();                                                            \
+        } while (false)
+
+    #define FETCH()                                                             \
+        do {                                                                    \
+            if (m_PC > finalInstruction) {                                      \
+                m_finished = true;                                              \
+                return instructionsExecuted;                                    \
+            }                                                                   \
+            instruction = &cache[m_PC];                                         \
+            goto *kDispatchTable[static_cast<std::size_t>(instruction->op)];    \
+        } while (false)
+
+    FETCH();
+
+    op_UNDECODED:
+        // Decode on first execution (or after being overwritten), then run it
+        *instruction = decodeCacheEntry(m_PC, finalInstruction);
+        goto *kDispatchTable[static_cast<std::size_t>(instruction->op)];
+
+    op_UNKNOWN:
+        executeMicroOp<MicroOp::UNKNOWN>(*instruction);
+        DISPATCH();
+
+    op_CLEAR_DISPLAY:
+        executeMicroOp<MicroOp::CLEAR_DISPLAY>(*instruction);
+        DISPATCH();
+
+    op_RETURN:
+        executeMicroOp<MicroOp::RETURN>(*instruction);
+        DISPATCH();
+
+    op_GOTO:
+        executeMicroOp<MicroOp::GOTO>(*instruction);
+        DISPATCH();
+
+    op_CALL:
+        executeMicroOp<MicroOp::CALL>(*instruction);
+        DISPATCH();
+
+    op_SKIP_EQ_IMM:
+        executeMicroOp<MicroOp::SKIP_EQ_IMM>(*instruction);
+        DISPATCH();
+
+    op_SKIP_NE_IMM:
+        executeMicroOp<MicroOp::SKIP_NE_IMM>(*instruction);
+        DISPATCH();
+
+    op_SKIP_EQ_REG:
+        executeMicroOp<MicroOp::SKIP_EQ_REG>(*instruction);
+        DISPATCH();
+
+    op_SET_IMM:
+        executeMicroOp<MicroOp::SET_IMM>(*instruction);
+        DISPATCH();
+
+    op_ADD_IMM:
+        executeMicroOp<MicroOp::ADD_IMM>(*instruction);
+        DISPATCH();
+
+    op_REG_ASSIGNMENT:
+        executeMicroOp<MicroOp::REG_ASSIGNMENT>(*instruction);
+        DISPATCH();
+
+    op_REG_OR:
+        executeMicroOp<MicroOp::REG_OR>(*instruction);
+        DISPATCH();
+
+    op_REG_AND:
+        executeMicroOp<MicroOp::REG_AND>(*instruction);
+        DISPATCH();
+
+    op_REG_XOR:
+        executeMicroOp<MicroOp::REG_XOR>(*instruction);
+        DISPATCH();
+
+    op_REG_ADD:
+        executeMicroOp<MicroOp::REG_ADD>(*instruction);
+        DISPATCH();
+
+    op_REG_SUBTRACT:
+        executeMicroOp<MicroOp::REG_SUBTRACT>(*instruction);
+        DISPATCH();
+
+    op_REG_RSHIFT:
+        executeMicroOp<MicroOp::REG_RSHIFT>(*instruction);
+        DISPATCH();
+
+    op_REG_DIFFERENCE:
+        executeMicroOp<MicroOp::REG_DIFFERENCE>(*instruction);
+        DISPATCH();
+
+    op_REG_LSHIFT:
+        executeMicroOp<MicroOp::REG_LSHIFT>(*instruction);
+        DISPATCH();
+
+    op_SKIP_NE_REG:
+        executeMicroOp<MicroOp::SKIP_NE_REG>(*instruction);
+        DISPATCH();
+
+    op_SET_INDEX:
+        executeMicroOp<MicroOp::SET_INDEX>(*instruction);
+        DISPATCH();
+
+    op_JUMP_V0:
+        executeMicroOp<MicroOp::JUMP_V0>(*instruction);
+        DISPATCH();
+
+    op_RAND:
+        executeMicroOp<MicroOp::RAND>(*instruction);
+        DISPATCH();
+
+    op_DRAW:
+        executeMicroOp<MicroOp::DRAW>(*instruction);
+        DISPATCH();
+
+    op_IS_KEY_PRESSED:
+        executeMicroOp<MicroOp::IS_KEY_PRESSED>(*instruction);
+        DISPATCH();
+
+    op_IS_KEY_NOT_PRESSED:
+        executeMicroOp<MicroOp::IS_KEY_NOT_PRESSED>(*instruction);
+        DISPATCH();
+
+    op_TIMER_GET_DELAY:
+        executeMicroOp<MicroOp::TIMER_GET_DELAY>(*instruction);
+        DISPATCH();
+
+    op_TIMER_DELAY_SET:
+        executeMicroOp<MicroOp::TIMER_DELAY_SET>(*instruction);
+        DISPATCH();
+
+    op_TIMER_SOUND_SET:
+        executeMicroOp<MicroOp::TIMER_SOUND_SET>(*instruction);
+        DISPATCH();
+
+    op_ADD_TO_I:
+        executeMicroOp<MicroOp::ADD_TO_I>(*instruction);
+        DISPATCH();
+
+    op_LOAD_CHAR:
+        executeMicroOp<MicroOp::LOAD_CHAR>(*instruction);
+        DISPATCH();
+
+    op_BCD_VX:
+        executeMicroOp<MicroOp::BCD_VX>(*instruction);
+        DISPATCH();
+
+    op_DUMP_REG:
+        executeMicroOp<MicroOp::DUMP_REG>(*instruction);
+        DISPATCH();
+
+    op_LOAD_REG:
+        executeMicroOp<MicroOp::LOAD_REG>(*instruction);
+        DISPATCH();
+
+    // Fused micro-ops count all but one of their instructions here, DISPATCH() the last.
+    // They never run past the frame's budget, so DISPATCH() still ends it on time.
+    op_SET_INDEX_DRAW:
+        instructionsExecuted += executeFused<MicroOp::SET_INDEX_DRAW>(
+            *instruction, budget - instructionsExecuted
+        ) - 1;
+        DISPATCH();
+
+    op_SET_IMM_PAIR:
+        instructionsExecuted += executeFused<MicroOp::SET_IMM_PAIR>(
+            *instruction, budget - instructionsExecuted
+        ) - 1;
+        DISPATCH();
+
+    op_ADD_SKIP_LOOP:
+        instructionsExecuted += executeFused<MicroOp::ADD_SKIP_LOOP>(
+            *instruction, budget - instructionsExecuted
+        ) - 1;
+        DISPATCH();
+
+    op_DELAY_SKIP:
+        instructionsExecuted += executeFused<MicroOp::DELAY_SKIP>(
+            *instruction, budget - instructionsExecuted
+        ) - 1;
+        DISPATCH();
+
+    op_AWAIT_KEY:
+        // Execution blocks until setKeyState() releases the awaited key
+        executeMicroOp<MicroOp::AWAIT_KEY>(*instruction);
+        return instructionsExecuted + 1;
+
+    #undef DISPATCH
+    #undef FETCH
+#else
+    return runPreDecodedEngine(finalInstruction, budget);
+#endif
+}
@@ -0,0 +1,514 @@
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <bit>
+#include "JitCompiler.h"
+#include "../MicroOp.h"
+
+#if defined(_WIN32)
+    #include <Windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+#endif
+
+using Register = X86Emitter::Register;
+using AluOp = X86Emitter::AluOp;
+using Condition = X86Emitter::Condition;
+
+// Host registers available to hold V registers within a trace, caller-saved first.
+// RAX and RDX are scratch, R13 holds the budget, R14 &index and R15 the V register file.
+static constexpr std::array<Register, 9> kRegisterPool = {
+    Register::R8, Register::R9, Register::R10, Register::R11, Register::RSI,
+    Register::RDI, Register::RBX, Register::RBP, Register::R12
+};
+
+// Whether the ABI requires a register to be preserved across calls
+static constexpr bool isCalleeSaved(Register reg) {
+    switch (reg) {
+        case Register::RBX:
+        case Register::RBP:
+        case Register::R12:
+        case Register::R13:
+        case Register::R14:
+        case Register::R15:
+            return true;
+        #if defined(_WIN32)
+            case Register::RSI:
+            case Register::RDI:
+                return true;
+        #endif
+        default:
+            return false;
+    }
+}
+
+// Value returned by a trace: instructions executed and the next address
+static constexpr std::uint32_t exitValue(std::uint32_t instructions, std::uint16_t nextPC) {
+    return instructions << 16 | nextPC;
+}
+
+// How an instruction is handled by the JIT
+enum class Translation : std::uint8_t {
+    // Straight-line instruction, compiled into the trace
+    BODY,
+    // Control flow instruction, leaving the trace when it branches
+    TERMINATOR,
+    // Left to the interpreter, the trace ends before it
+    INTERPRETED
+};
+
+static Translation classify(MicroOp op) {
+    switch (op) {
+        case MicroOp::SET_IMM:
+        case MicroOp::ADD_IMM:
+        case MicroOp::REG_ASSIGNMENT:
+        case MicroOp::REG_OR:
+        case MicroOp::REG_AND:
+        case MicroOp::REG_XOR:
+        case MicroOp::REG_ADD:
+        case MicroOp::REG_SUBTRACT:
+        case MicroOp::REG_RSHIFT:
+        case MicroOp::REG_DIFFERENCE:
+        case MicroOp::REG_LSHIFT:
+        case MicroOp::SET_INDEX:
+        case MicroOp::ADD_TO_I:
+            return Translation::BODY;
+        case MicroOp::GOTO:
+        case MicroOp::SKIP_EQ_IMM:
+        case MicroOp::SKIP_NE_IMM:
+        case MicroOp::SKIP_EQ_REG:
+        case MicroOp::SKIP_NE_REG:
+        case MicroOp::JUMP_V0:
+            return Translation::TERMINATOR;
+        default:
+            return Translation::INTERPRETED;
+    }
+}
+
+static bool isSkip(MicroOp op) {
+    return op == MicroOp::SKIP_EQ_IMM || op == MicroOp::SKIP_NE_IMM
+        || op == MicroOp::SKIP_EQ_REG || op == MicroOp::SKIP_NE_REG;
+}
+
+// Bit mask of the V registers an instruction reads or writes
+static std::uint16_t registersUsed(const DecodedInstruction& instruction) {
+    const std::uint16_t VX = 1 << instruction.x;
+    const std::uint16_t VY = 1 << instruction.y;
+    constexpr std::uint16_t V0 = 1;
+    constexpr std::uint16_t VF = 1 << 0xF;
+
+    switch (instruction.op) {
+        case MicroOp::SET_IMM:
+        case MicroOp::ADD_IMM:
+        case MicroOp::ADD_TO_I:
+        case MicroOp::SKIP_EQ_IMM:
+        case MicroOp::SKIP_NE_IMM:
+            return VX;
+        case MicroOp::REG_ASSIGNMENT:
+        case MicroOp::REG_OR:
+        case MicroOp::REG_AND:
+        case MicroOp::REG_XOR:
+        case MicroOp::SKIP_EQ_REG:
+        case MicroOp::SKIP_NE_REG:
+            return VX | VY;
+        case MicroOp::REG_ADD:
+        case MicroOp::REG_SUBTRACT:
+        case MicroOp::REG_RSHIFT:
+        case MicroOp::REG_DIFFERENCE:
+        case MicroOp::REG_LSHIFT:
+            return VX | VY | VF;
+        case MicroOp::JUMP_V0:
+            return V0;
+        default:
+            return 0;
+    }
+}
+
+// Bit mask of the V registers an instruction writes
+static std::uint16_t registersModified(const DecodedInstruction& instruction) {
+    switch (instruction.op) {
+        case MicroOp::SET_IMM:
+        case MicroOp::ADD_IMM:
+        case MicroOp::REG_ASSIGNMENT:
+        case MicroOp::REG_OR:
+        case MicroOp::REG_AND:
+        case MicroOp::REG_XOR:
+            return 1 << instruction.x;
+        case MicroOp::REG_ADD:
+        case MicroOp::REG_SUBTRACT:
+        case MicroOp::REG_RSHIFT:
+        case MicroOp::REG_DIFFERENCE:
+        case MicroOp::REG_LSHIFT:
+            return 1 << instruction.x | 1 << 0xF;
+        default:
+            return 0;
+    }
+}
+
+JitCompiler::JitCompiler() {
+    #if defined(_WIN32)
+        m_codeBuffer = static_cast<std::uint8_t*>(VirtualAlloc(
+            nullptr, kCodeBufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE
+        ));
+    #elif defined(__unix__) || defined(__APPLE__)
+        void* buffer = mmap(
+            nullptr, kCodeBufferSize, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+        );
+
+        if (buffer != MAP_FAILED)
+            m_codeBuffer = static_cast<std::uint8_t*>(buffer);
+    #endif
+
+    if (!m_codeBuffer)
+        throw std::runtime_error("Failed to allocate JIT code buffer.");
+
+    m_emitter.reserve(kMaxTraceCodeSize);
+}
+
+JitCompiler::~JitCompiler() {
+    #if defined(_WIN32)
+        VirtualFree(m_codeBuffer, 0, MEM_RELEASE);
+    #elif defined(__unix__) || defined(__APPLE__)
+        munmap(m_codeBuffer, kCodeBufferSize);
+    #endif
+}
+
+void JitCompiler::protect(bool executable) {
+    // Pages are never writable and executable at the same time (W^X)
+    #if defined(_WIN32)
+        DWORD oldProtection;
+        VirtualProtect(
+            m_codeBuffer, kCodeBufferSize,
+            executable ? PAGE_EXECUTE_READ : PAGE_READWRITE, &oldProtection
+        );
+    #elif defined(__unix__) || defined(__APPLE__)
+        mprotect(
+            m_codeBuffer, kCodeBufferSize,
+            executable ? PROT_READ | PROT_EXEC : PROT_READ | PROT_WRITE
+        );
+    #else
+        (void)executable;
+    #endif
+}
+
+JitCompiler::BlockFunction JitCompiler::commit() {
+    const std::vector<std::uint8_t>& code = m_emitter.code();
+
+    if (m_codeUsed + code.size() > kCodeBufferSize)
+        return nullptr;
+
+    std::uint8_t* entry = m_codeBuffer + m_codeUsed;
+
+    protect(false);
+    std::memcpy(entry, code.data(), code.size());
+    protect(true);
+
+    m_codeUsed += code.size();
+
+    return reinterpret_cast<BlockFunction>(entry);
+}
+
+void JitCompiler::cover(const Block& block, int amount) {
+    // Instructions never start past the ROM's final instruction, so both bytes are in range
+    for (const std::uint16_t instruction : block.addresses()) {
+        m_covered[instruction] += amount;
+        m_covered[instruction + 1] += amount;
+    }
+}
+
+std::uint8_t JitCompiler::translate(
+    const PagedMemoryView& memory, std::uint16_t address,
+    std::uint16_t finalInstruction
+) {
+    std::array<DecodedInstruction, kMaxBlockLength> instructions{};
+    Block block{nullptr, 0, true, {}};
+    bool terminated = false;
+
+    // Host register holding each V register used by the trace
+    std::array<Register, 16> hostRegister{};
+    std::uint16_t usedRegisters{0};
+    std::uint16_t modifiedRegisters{0};
+    std::uint8_t allocated{0};
+
+    // Gather the trace: stop at the ROM's end, an interpreted instruction,
+    // BNNN or when host registers run out. Jumps within the ROM are followed.
+    std::uint16_t PC = address;
+    const bool selfModifying = m_retranslations[address] >= kMaxRetranslations;
+
+    while (!selfModifying && block.length < kMaxBlockLength && PC <= finalInstruction) {
+        const DecodedInstruction instruction = decodeMicroOp(
+            static_cast<std::uint16_t>(memory[PC]) << 8 | memory[PC + 1]
+        );
+
+        if (classify(instruction.op) == Translation::INTERPRETED)
+            break;
+
+        const std::uint16_t newRegisters = registersUsed(instruction) & ~usedRegisters;
+
+        if (allocated + std::popcount(newRegisters) > static_cast<int>(kRegisterPool.size()))
+            break;
+
+        for (std::uint8_t reg{0}; reg < 16; ++reg) {
+            if (newRegisters & (1 << reg))
+                hostRegister[reg] = kRegisterPool[allocated++];
+        }
+
+        usedRegisters |= newRegisters;
+        modifiedRegisters |= registersModified(instruction);
+        instructions[block.length] = instruction;
+        block.instructions[block.length++] = PC;
+
+        if (instruction.op == MicroOp::GOTO && instruction.nnn <= finalInstruction) {
+            PC = instruction.nnn;
+            continue;
+        }
+
+        if (classify(instruction.op) == Translation::TERMINATOR && !isSkip(instruction.op)) {
+            terminated = true;
+            break;
+        }
+
+        PC += 2;
+    }
+
+    if (block.length == 0) {
+        // Depends only on the instruction at this address, see invalidate()
+        m_blocks[address] = std::move(block);
+        return 0;
+    }
+
+    // -- Emit the trace --
+    X86Emitter& e = m_emitter;
+    e.clear();
+
+    // Nothing in here allocates, so retranslation stays allocation-free
+    std::array<Register, 3 + kRegisterPool.size()> savedRegisters{Register::R13, Register::R14, Register::R15};
+    std::uint8_t savedCount{3};
+
+    for (std::uint8_t i{0}; i < allocated; ++i) {
+        if (isCalleeSaved(kRegisterPool[i]))
+            savedRegisters[savedCount++] = kRegisterPool[i];
+    }
+
+    for (std::uint8_t i{0}; i < savedCount; ++i)
+        e.push(savedRegisters[i]);
+
+    // Move the arguments out of the way of the register pool
+    #if defined(_WIN32)
+        e.mov64(Register::R15, Register::RCX);
+        e.mov64(Register::R14, Register::RDX);
+        e.mov64(Register::R13, Register::R8);
+    #else
+        e.mov64(Register::R15, Register::RDI);
+        e.mov64(Register::R14, Register::RSI);
+        e.mov64(Register::R13, Register::RDX);
+    #endif
+
+    for (std::uint8_t reg{0}; reg < 16; ++reg) {
+        if (usedRegisters & (1 << reg))
+            e.loadByte(hostRegister[reg], Register::R15, reg);
+    }
+
+    // Side exits, emitted after the trace: jump displacement and return value.
+    // At most a budget check and a skip per instruction.
+    std::array<std::pair<std::size_t, std::uint32_t>, 2 * kMaxBlockLength> exits{};
+    std::size_t exitCount{0};
+
+    for (std::uint8_t i{0}; i < block.length; ++i) {
+        const DecodedInstruction& instruction = instructions[i];
+        const std::uint16_t instructionPC = block.instructions[i];
+        const Register X = hostRegister[instruction.x];
+        const Register Y = hostRegister[instruction.y];
+        const Register VF = hostRegister[0xF];
+
+        // Leave once the frame's instruction budget is used up
+        if (i > 0) {
+            e.aluImmediate(AluOp::CMP, Register::R13, i);
+            exits[exitCount++] = {e.jcc(Condition::BE), exitValue(i, instructionPC)};
+        }
+
+        switch (instruction.op) {
+            case MicroOp::SET_IMM:
+                e.movImmediate(X, instruction.nn);
+                break;
+            case MicroOp::ADD_IMM:
+                e.aluImmediate(AluOp::ADD, X, instruction.nn);
+                e.aluImmediate(AluOp::AND, X, 0xFF);
+                break;
+            case MicroOp::REG_ASSIGNMENT:
+                e.mov(X, Y);
+                break;
+            case MicroOp::REG_OR:
+                e.alu(AluOp::OR, X, Y);
+                break;
+            case MicroOp::REG_AND:
+                e.alu(AluOp::AND, X, Y);
+                break;
+            case MicroOp::REG_XOR:
+                e.alu(AluOp::XOR, X, Y);
+                break;
+            case MicroOp::REG_ADD:
+                // VX is written before VF, so VF wins when X is F
+                e.mov(Register::RAX, X);
+                e.alu(AluOp::ADD, Register::RAX, Y);
+                e.mov(X, Register::RAX);
+                e.aluImmediate(AluOp::AND, X, 0xFF);
+                e.shr(Register::RAX, 8);
+                e.mov(VF, Register::RAX);
+                break;
+            case MicroOp::REG_SUBTRACT:
+                // VF = 1 when there is no borrow
+                e.mov(Register::RAX, X);
+                e.alu(AluOp::SUB, Register::RAX, Y);
+                e.setNotCarry(Register::RDX);
+                e.aluImmediate(AluOp::AND, Register::RAX, 0xFF);
+                e.mov(X, Register::RAX);
+                e.mov(VF, Register::RDX);
+                break;
+            case MicroOp::REG_DIFFERENCE:
+                e.mov(Register::RAX, Y);
+                e.alu(AluOp::SUB, Register::RAX, X);
+                e.setNotCarry(Register::RDX);
+                e.aluImmediate(AluOp::AND, Register::RAX, 0xFF);
+                e.mov(X, Register::RAX);
+                e.mov(VF, Register::RDX);
+                break;
+            case MicroOp::REG_RSHIFT:
+                // QUIRK: VX = VY >> 1, VF = shifted out bit
+                e.mov(Register::RAX, Y);
+                e.mov(Register::RDX, Register::RAX);
+                e.aluImmediate(AluOp::AND, Register::RDX, 1);
+                e.shr(Register::RAX, 1);
+                e.mov(X, Register::RAX);
+                e.mov(VF, Register::RDX);
+                break;
+            case MicroOp::REG_LSHIFT:
+                // QUIRK: VX = VY << 1, VF = shifted out bit
+                e.mov(Register::RAX, Y);
+                e.mov(Register::RDX, Register::RAX);
+                e.shr(Register::RDX, 7);
+                e.shl(Register::RAX, 1);
+                e.aluImmediate(AluOp::AND, Register::RAX, 0xFF);
+                e.mov(X, Register::RAX);
+                e.mov(VF, Register::RDX);
+                break;
+            case MicroOp::SET_INDEX:
+                e.storeWordImmediate(Register::R14, instruction.nnn);
+                break;
+            case MicroOp::ADD_TO_I:
+                e.loadWord(Register::RAX, Register::R14);
+                e.alu(AluOp::ADD, Register::RAX, X);
+                e.storeWord(Register::R14, Register::RAX);
+                break;
+            case MicroOp::GOTO:
+                // Followed by the trace unless it leaves the ROM
+                if (terminated && i == block.length - 1)
+                    e.movImmediate(Register::RAX, exitValue(i + 1, instruction.nnn));
+                break;
+            case MicroOp::SKIP_EQ_IMM:
+            case MicroOp::SKIP_NE_IMM:
+                e.aluImmediate(AluOp::CMP, X, instruction.nn);
+                exits[exitCount++] = {
+                    e.jcc(instruction.op == MicroOp::SKIP_EQ_IMM ? Condition::E : Condition::NE),
+                    exitValue(i + 1, instructionPC + 4)
+                };
+                break;
+            case MicroOp::SKIP_EQ_REG:
+            case MicroOp::SKIP_NE_REG:
+                e.alu(AluOp::CMP, X, Y);
+                exits[exitCount++] = {
+                    e.jcc(instruction.op == MicroOp::SKIP_EQ_REG ? Condition::E : Condition::NE),
+                    exitValue(i + 1, instructionPC + 4)
+                };
+                break;
+            case MicroOp::JUMP_V0:
+                e.mov(Register::RAX, hostRegister[0]);
+                e.aluImmediate(AluOp::ADD, Register::RAX, instruction.nnn);
+                e.aluImmediate(AluOp::OR, Register::RAX, exitValue(i + 1, 0));
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Fall through to the instruction after the trace
+    if (!terminated)
+        e.movImmediate(Register::RAX, exitValue(block.length, PC));
+
+    const std::size_t epilogue = e.size();
+
+    for (std::uint8_t reg{0}; reg < 16; ++reg) {
+        if (modifiedRegisters & (1 << reg))
+            e.storeByte(Register::R15, reg, hostRegister[reg]);
+    }
+
+    for (std::uint8_t i = savedCount; i-- > 0;)
+        e.pop(savedRegisters[i]);
+
+    e.ret();
+
+    // Out of line, so the trace itself runs straight through
+    for (std::size_t exit{0}; exit < exitCount; ++exit) {
+        const auto& [displacement, value] = exits[exit];
+        e.patch(displacement, e.size());
+        e.movImmediate(Register::RAX, value);
+        e.patch(e.jmp(), epilogue);
+    }
+
+    block.code = commit();
+
+    // Out of code space: start over with an empty buffer
+    if (!block.code) {
+        flush();
+        block.code = commit();
+    }
+
+    const std::uint8_t length = block.length;
+
+    cover(block, 1);
+    m_blocks[address] = std::move(block);
+
+    return length;
+}
+
+void JitCompiler::invalidate(std::uint16_t address) {
+    if (address >= kMemorySize)
+        return;
+
+    // Failed translations of an instruction containing this byte
+    for (const int start : {address - 1, static_cast<int>(address)}) {
+        if (start >= 0 && m_blocks[start].translated && m_blocks[start].length == 0)
+            m_blocks[start] = Block{};
+    }
+
+    // Writes to data which no trace contains are the common case
+    for (std::uint16_t start{0}; start < kMemorySize && m_covered[address] != 0; ++start) {
+        Block& block = m_blocks[start];
+
+        if (block.length == 0)
+            continue;
+
+        const bool contains = std::ranges::any_of(block.addresses(), [address](std::uint16_t instruction) {
+            return instruction == address || instruction + 1 == address;
+        });
+
+        if (!contains)
+            continue;
+
+        if (m_retranslations[start] < kMaxRetranslations)
+            ++m_retranslations[start];
+
+        cover(block, -1);
+        block = Block{};
+    }
+}
+
+void JitCompiler::flush() {
+    for (Block& block : m_blocks)
+        block = Block{};
+
+    m_covered.fill(0);
+    m_retranslations.fill(0);
+    m_codeUsed = 0;
+}
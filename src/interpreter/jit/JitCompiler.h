@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+#include "X86Emitter.h"
+#include "../../utils/PagedMemory.h"
+
+// The JIT emits x86-64 code and needs an OS API to map executable memory
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__unix__) || defined(__APPLE__) || defined(_WIN32))
+    inline constexpr bool kJitSupported = true;
+#else
+    inline constexpr bool kJitSupported = false;
+#endif
+
+/*
+ * Dynamic recompiler translating CHIP-8 code into x86-64 traces.
+ *
+ * A trace starts at any address and runs register and index instructions
+ * (6XNN, 7XNN, 8XYN, ANNN, FX1E). Unconditional jumps (1NNN) are followed,
+ * so small loops are unrolled into one trace, and skips (3XNN, 4XNN, 5XY0,
+ * 9XY0) leave the trace when taken. BNNN always ends it. The V registers a
+ * trace uses are loaded into host registers on entry and written back on exit.
+ *
+ * Everything else (2NNN/00EE, DXYN, FX0A, timers, memory, RNG and key
+ * instructions) ends the trace before it and is left to the interpreter.
+ */
+class JitCompiler {
+    public:
+        // Size of emulated memory, one potential trace entry per address
+        static constexpr std::uint16_t kMemorySize = 0x1000;
+
+        // Longest trace translated, in instructions
+        static constexpr std::uint8_t kMaxBlockLength = 64;
+
+        /*
+         * A compiled trace: takes the V register file, the index register and
+         * the most instructions it may execute (at least one). Returns the
+         * amount of instructions executed in the upper 16 bits and the
+         * address of the next instruction in the lower 16 bits.
+         */
+        using BlockFunction = std::uint32_t (*)(
+            std::uint8_t* registers, std::uint16_t* index, std::uint32_t budget
+        );
+
+        struct Block {
+            BlockFunction code{nullptr};
+
+            // Amount of CHIP-8 instructions in the trace.
+            // Zero if the instruction at this address can't be compiled.
+            std::uint8_t length{0};
+
+            // Whether the address has been looked at since it was last written
+            bool translated{false};
+
+            // Address of every instruction in the trace, to find it on invalidation.
+            // Fixed size, so retranslating self-modifying code doesn't allocate.
+            std::array<std::uint16_t, kMaxBlockLength> instructions{};
+
+            [[nodiscard]] std::span<const std::uint16_t> addresses() const {
+                return {instructions.data(), length};
+            }
+        };
+
+    private:
+        // Traces invalidated this many times stay interpreted, so code
+        // rewritten every iteration isn't recompiled every iteration
+        static constexpr std::uint8_t kMaxRetranslations = 8;
+
+        // Executable code buffer, flushed entirely when full
+        static constexpr std::size_t kCodeBufferSize = 256 * 1024;
+
+        // Upper bound of a trace's code size, reserved for the emitter up front
+        static constexpr std::size_t kMaxTraceCodeSize = 8 * 1024;
+
+        std::uint8_t* m_codeBuffer{nullptr};
+        std::size_t m_codeUsed{0};
+
+        // Trace entry for every memory address
+        std::array<Block, kMemorySize> m_blocks{};
+
+        // Amount of compiled trace instructions containing each memory byte
+        std::array<std::uint32_t, kMemorySize> m_covered{};
+
+        // Times the trace at each address has been invalidated
+        std::array<std::uint8_t, kMemorySize> m_retranslations{};
+
+        X86Emitter m_emitter;
+
+        // Translate the trace starting at address, returning its instruction count
+        std::uint8_t translate(
+            const PagedMemoryView& memory, std::uint16_t address,
+            std::uint16_t finalInstruction
+        );
+
+        // Copy the emitted code into the executable buffer
+        BlockFunction commit();
+
+        // Switch the code buffer between writable and executable
+        void protect(bool executable);
+
+        // Add (or remove) a trace's instructions to m_covered
+        void cover(const Block& block, int amount);
+
+    public:
+        JitCompiler();
+        ~JitCompiler();
+
+        // The code buffer is owned exclusively by this object
+        JitCompiler(const JitCompiler&) = delete;
+        JitCompiler& operator=(const JitCompiler&) = delete;
+
+        /*
+         * Get the trace starting at address, translating it on first use.
+         * finalInstruction is the last address the ROM may execute,
+         * traces never run past it.
+         */
+        const Block& getBlock(
+            const PagedMemoryView& memory, std::uint16_t address,
+            std::uint16_t finalInstruction
+        ) {
+            const Block& block = m_blocks[address];
+
+            if (block.translated)
+                return block;
+
+            translate(memory, address, finalInstruction);
+            return m_blocks[address];
+        }
+
+        // Discard traces containing the byte at address, after a write to it
+        void invalidate(std::uint16_t address);
+
+        // Discard every trace
+        void flush();
+};
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Minimal x86-64 machine code emitter for the JIT.
+ *
+ * Only the handful of instructions the block compiler needs are provided.
+ * Register operations use 32 bit operand size, which zero extends into the
+ * full 64 bit register. Encodings follow the Intel SDM, volume 2.
+ */
+class X86Emitter {
+    std::vector<std::uint8_t> m_code;
+
+    // REX prefix: W = 64 bit operand, R extends ModRM.reg, B extends ModRM.rm
+    void rex(bool wide, std::uint8_t reg, std::uint8_t rm, bool force = false) {
+        const std::uint8_t prefix = 0x40
+            | (wide ? 0x08 : 0)
+            | ((reg & 8) ? 0x04 : 0)
+            | ((rm & 8) ? 0x01 : 0);
+
+        if (prefix != 0x40 || force)
+            emit(prefix);
+    }
+
+    // ModRM byte for a register to register operation
+    void modRMDirect(std::uint8_t reg, std::uint8_t rm) {
+        emit(0xC0 | (reg & 7) << 3 | (rm & 7));
+    }
+
+    public:
+        // x86-64 general purpose register numbers
+        enum Register : std::uint8_t {
+            RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+            R8, R9, R10, R11, R12, R13, R14, R15
+        };
+
+        // Condition codes of jcc (0F 80+cc rel32)
+        enum class Condition : std::uint8_t {
+            E = 0x4, NE = 0x5, BE = 0x6
+        };
+
+        // Opcodes of two-operand ALU instructions (op r/m32, r32)
+        enum class AluOp : std::uint8_t {
+            ADD = 0x01, OR = 0x09, AND = 0x21, SUB = 0x29, XOR = 0x31, CMP = 0x39
+        };
+
+        // ModRM.reg extension of the matching ALU immediate forms (op r/m32, imm32)
+        static constexpr std::uint8_t aluImmediateExtension(AluOp op) {
+            switch (op) {
+                case AluOp::ADD: return 0;
+                case AluOp::OR: return 1;
+                case AluOp::AND: return 4;
+                case AluOp::SUB: return 5;
+                case AluOp::XOR: return 6;
+                case AluOp::CMP: return 7;
+            }
+
+            return 0;
+        }
+
+        void emit(std::uint8_t byte) {
+            m_code.push_back(byte);
+        }
+
+        void emit32(std::uint32_t value) {
+            for (int byte{0}; byte < 4; ++byte)
+                emit(static_cast<std::uint8_t>(value >> (byte * 8)));
+        }
+
+        [[nodiscard]] const std::vector<std::uint8_t>& code() const {
+            return m_code;
+        }
+
+        // Clears the code but keeps its capacity, see reserve()
+        void clear() {
+            m_code.clear();
+        }
+
+        void reserve(std::size_t size) {
+            m_code.reserve(size);
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return m_code.size();
+        }
+
+        // jcc rel32 / jmp rel32 with a zero displacement.
+        // Returns the offset of the displacement, to be filled in by patch().
+        std::size_t jcc(Condition condition) {
+            emit(0x0F); emit(0x80 | static_cast<std::uint8_t>(condition));
+            emit32(0);
+            return m_code.size() - 4;
+        }
+
+        std::size_t jmp() {
+            emit(0xE9);
+            emit32(0);
+            return m_code.size() - 4;
+        }
+
+        // Point the jump whose displacement is at offset to target
+        void patch(std::size_t offset, std::size_t target) {
+            const auto displacement = static_cast<std::uint32_t>(target - (offset + 4));
+
+            for (int byte{0}; byte < 4; ++byte)
+                m_code[offset + byte] = static_cast<std::uint8_t>(displacement >> (byte * 8));
+        }
+
+        // push r64
+        void push(Register reg) {
+            rex(false, 0, reg);
+            emit(0x50 | (reg & 7));
+        }
+
+        // pop r64
+        void pop(Register reg) {
+            rex(false, 0, reg);
+            emit(0x58 | (reg & 7));
+        }
+
+        void ret() {
+            emit(0xC3);
+        }
+
+        // mov r64, r64
+        void mov64(Register dst, Register src) {
+            rex(true, src, dst);
+            emit(0x89);
+            modRMDirect(src, dst);
+        }
+
+        // mov r32, r32
+        void mov(Register dst, Register src) {
+            rex(false, src, dst);
+            emit(0x89);
+            modRMDirect(src, dst);
+        }
+
+        // mov r32, imm32
+        void movImmediate(Register dst, std::uint32_t value) {
+            rex(false, 0, dst);
+            emit(0xB8 | (dst & 7));
+            emit32(value);
+        }
+
+        // op r32, r32
+        void alu(AluOp op, Register dst, Register src) {
+            rex(false, src, dst);
+            emit(static_cast<std::uint8_t>(op));
+            modRMDirect(src, dst);
+        }
+
+        // op r32, imm32
+        void aluImmediate(AluOp op, Register dst, std::uint32_t value) {
+            rex(false, 0, dst);
+            emit(0x81);
+            modRMDirect(aluImmediateExtension(op), dst);
+            emit32(value);
+        }
+
+        // shl r32, imm8
+        void shl(Register dst, std::uint8_t amount) {
+            rex(false, 0, dst);
+            emit(0xC1);
+            modRMDirect(4, dst);
+            emit(amount);
+        }
+
+        // shr r32, imm8
+        void shr(Register dst, std::uint8_t amount) {
+            rex(false, 0, dst);
+            emit(0xC1);
+            modRMDirect(5, dst);
+            emit(amount);
+        }
+
+        // setae r8 followed by movzx r32, r8 (dst = carry flag clear)
+        // Only for RAX-RBX, whose low bytes need no REX prefix.
+        void setNotCarry(Register dst) {
+            emit(0x0F); emit(0x93); modRMDirect(0, dst);
+            emit(0x0F); emit(0xB6); modRMDirect(dst, dst);
+        }
+
+        // cmove r32, r32 / cmovne r32, r32
+        void cmove(Register dst, Register src) {
+            rex(false, dst, src);
+            emit(0x0F); emit(0x44);
+            modRMDirect(dst, src);
+        }
+
+        void cmovne(Register dst, Register src) {
+            rex(false, dst, src);
+            emit(0x0F); emit(0x45);
+            modRMDirect(dst, src);
+        }
+
+        // movzx r32, byte [base + disp8]
+        // base must not be RSP/R12 or RBP/R13, which need other encodings.
+        void loadByte(Register dst, Register base, std::uint8_t displacement) {
+            rex(false, dst, base);
+            emit(0x0F); emit(0xB6);
+            emit(0x40 | (dst & 7) << 3 | (base & 7));
+            emit(displacement);
+        }
+
+        // mov byte [base + disp8], r8
+        // The REX prefix is forced so SPL-DIL aren't read as AH-BH.
+        void storeByte(Register base, std::uint8_t displacement, Register src) {
+            rex(false, src, base, true);
+            emit(0x88);
+            emit(0x40 | (src & 7) << 3 | (base & 7));
+            emit(displacement);
+        }
+
+        // movzx r32, word [base]
+        void loadWord(Register dst, Register base) {
+            rex(false, dst, base);
+            emit(0x0F); emit(0xB7);
+            emit((dst & 7) << 3 | (base & 7));
+        }
+
+        // mov word [base], r16
+        void storeWord(Register base, Register src) {
+            emit(0x66);
+            rex(false, src, base);
+            emit(0x89);
+            emit((src & 7) << 3 | (base & 7));
+        }
+
+        // mov word [base], imm16
+        void storeWordImmediate(Register base, std::uint16_t value) {
+            emit(0x66);
+            rex(false, 0, base);
+            emit(0xC7);
+            emit(base & 7);
+            emit(static_cast<std::uint8_t>(value));
+            emit(static_cast<std::uint8_t>(value >> 8));
+        }
+};
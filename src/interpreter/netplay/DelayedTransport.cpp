@@ -0,0 +1,44 @@
+#include <algorithm>
+#include "NetplayTransport.h"
+
+DelayedTransport::DelayedTransport(
+    NetplayTransport& transport, std::chrono::milliseconds latency, double lossPercent
+)
+    : m_transport{transport}
+    , m_latency{latency}
+    , m_lossThreshold{static_cast<std::uint32_t>(std::clamp(lossPercent, 0.0, 100.0) / 100 * UINT32_MAX)}
+    , m_random{static_cast<std::uint32_t>(Clock::now().time_since_epoch().count())}
+    , m_held(kMaxHeldPackets)
+    , m_heldData(kMaxHeldPackets * kMaxPacketSize)
+{
+}
+
+void DelayedTransport::send(std::span<const std::uint8_t> packet) {
+    flush();
+
+    if (m_random.next() < m_lossThreshold || m_count == kMaxHeldPackets || packet.size() > kMaxPacketSize)
+        return;
+
+    const std::size_t slot = (m_first + m_count) % kMaxHeldPackets;
+    m_held[slot] = HeldPacket{Clock::now() + m_latency, packet.size()};
+    std::ranges::copy(packet, m_heldData.begin() + static_cast<std::ptrdiff_t>(slot * kMaxPacketSize));
+    ++m_count;
+}
+
+std::optional<std::size_t> DelayedTransport::receive(std::span<std::uint8_t, kMaxPacketSize> buffer) {
+    flush();
+    return m_transport.receive(buffer);
+}
+
+void DelayedTransport::flush() {
+    const Clock::time_point now = Clock::now();
+
+    while (m_count > 0 && m_held[m_first].sendTime <= now) {
+        m_transport.send(std::span<const std::uint8_t>{m_heldData}.subspan(
+            m_first * kMaxPacketSize, m_held[m_first].size
+        ));
+
+        m_first = (m_first + 1) % kMaxHeldPackets;
+        --m_count;
+    }
+}
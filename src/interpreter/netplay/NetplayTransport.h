@@ -0,0 +1,73 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "../../utils/Xorshift32.h"
+
+/*
+ * Unreliable datagrams to and from the other player of a netplay session
+ * (see RollbackSession). Packets may be lost or reordered, never corrupted
+ * or split.
+ */
+class NetplayTransport {
+    public:
+        // Largest packet sent or received
+        static constexpr std::size_t kMaxPacketSize = 512;
+
+        virtual void send(std::span<const std::uint8_t> packet) = 0;
+
+        // Receive the next packet into buffer and return its size,
+        // or nothing if none has arrived. Never blocks.
+        virtual std::optional<std::size_t> receive(std::span<std::uint8_t, kMaxPacketSize> buffer) = 0;
+
+        virtual ~NetplayTransport() = default;
+};
+
+/*
+ * Adds artificial latency and packet loss to the packets sent through
+ * another transport, for testing rollback over loopback. Applied by both
+ * players, the round trip takes twice the latency.
+ *
+ * Packets are held in a ring allocated up front and sent once their
+ * latency has passed, whenever send() or receive() is called.
+ */
+class DelayedTransport final : public NetplayTransport {
+    public:
+        // Packets held at once, more are dropped
+        static constexpr std::size_t kMaxHeldPackets = 256;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct HeldPacket {
+            Clock::time_point sendTime;
+            std::size_t size;
+        };
+
+        NetplayTransport& m_transport;
+        Clock::duration m_latency;
+
+        // Chance of dropping a packet, out of 2^32
+        std::uint32_t m_lossThreshold;
+        Xorshift32 m_random;
+
+        // Ring of held packets in the order sent, their bytes kMaxPacketSize apart
+        std::vector<HeldPacket> m_held;
+        std::vector<std::uint8_t> m_heldData;
+        std::size_t m_first{0};
+        std::size_t m_count{0};
+
+        // Send the held packets whose latency has passed
+        void flush();
+
+    public:
+        // Delay packets sent through transport by latency and drop lossPercent of them
+        DelayedTransport(NetplayTransport& transport, std::chrono::milliseconds latency, double lossPercent);
+
+        void send(std::span<const std::uint8_t> packet) override;
+        std::optional<std::size_t> receive(std::span<std::uint8_t, kMaxPacketSize> buffer) override;
+};
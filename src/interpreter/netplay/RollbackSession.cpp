@@ -0,0 +1,381 @@
+#include <string>
+#include <stdexcept>
+#include "RollbackSession.h"
+#include "../Lockstep.h"
+
+/*
+ * Packets start with "HCNP", the protocol version and the packet type.
+ * Integers are little-endian.
+ *
+ * Hello: player (1 byte), seed (4), hash of the seeded starting state (8)
+ * Inputs: frames of the other player's input received (4), first frame (4),
+ *         frame count (1), the keys of each frame (2 each),
+ *         latest frame checked for desyncs (4) and its state hash (8)
+ */
+static constexpr std::array<std::uint8_t, 4> kMagic = {'H', 'C', 'N', 'P'};
+static constexpr std::uint8_t kProtocolVersion = 1;
+
+enum class PacketType : std::uint8_t {
+    Hello,
+    Inputs
+};
+
+// Most frames of input in a packet
+static constexpr std::uint32_t kMaxInputsPerPacket = 64;
+
+// Writes a packet into a fixed buffer
+class PacketWriter {
+    std::span<std::uint8_t> m_buffer;
+    std::size_t m_size{0};
+
+    public:
+        explicit PacketWriter(std::span<std::uint8_t> buffer) : m_buffer{buffer} {}
+
+        template<typename Integer>
+        void put(Integer value) {
+            for (std::size_t byte{0}; byte < sizeof(Integer); ++byte)
+                m_buffer[m_size++] = static_cast<std::uint8_t>(static_cast<std::uint64_t>(value) >> byte * 8);
+        }
+
+        [[nodiscard]] std::span<const std::uint8_t> getPacket() const {
+            return m_buffer.first(m_size);
+        }
+};
+
+// Reads the fields written by PacketWriter, reading zeros and becoming invalid past the end
+class PacketReader {
+    std::span<const std::uint8_t> m_packet;
+    std::size_t m_position{0};
+    bool m_valid{true};
+
+    public:
+        explicit PacketReader(std::span<const std::uint8_t> packet) : m_packet{packet} {}
+
+        template<typename Integer>
+        Integer get() {
+            if (m_packet.size() - m_position < sizeof(Integer)) {
+                m_valid = false;
+                return 0;
+            }
+
+            std::uint64_t value{0};
+
+            for (std::size_t byte{0}; byte < sizeof(Integer); ++byte)
+                value |= static_cast<std::uint64_t>(m_packet[m_position++]) << byte * 8;
+
+            return static_cast<Integer>(value);
+        }
+
+        [[nodiscard]] bool isValid() const {
+            return m_valid;
+        }
+};
+
+static std::uint64_t hashState(const Chip8& chip8) {
+    SaveState state;
+    chip8.saveState(state);
+    return hashSaveState(state);
+}
+
+RollbackSession::RollbackSession(
+    Chip8& chip8, NetplayTransport& transport, std::uint8_t player, std::uint32_t inputDelay
+)
+    : m_chip8{chip8}
+    , m_transport{transport}
+    , m_player{player}
+    , m_inputDelay{inputDelay}
+    , m_seed{static_cast<std::uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count())}
+{
+    if (player > 1)
+        throw std::runtime_error("Netplay is for players 1 and 2, not " + std::to_string(player + 1));
+
+    if (inputDelay > kMaxInputDelay)
+        throw std::runtime_error(
+            "Input delay can be at most " + std::to_string(kMaxInputDelay) + " frames: " + std::to_string(inputDelay)
+        );
+
+    // The first player's seed is sent to the second
+    if (m_player == 0) {
+        m_chip8.setRandomSeed(m_seed);
+        m_startHash = hashState(m_chip8);
+    }
+
+    // Keys pressed during the delay apply after it, no keys before
+    m_localFrames = m_inputDelay;
+}
+
+bool RollbackSession::connect() {
+    receive();
+
+    // The second player answers each greeting of the first, until the first has connected
+    if (m_player == 0 && !m_connected)
+        sendHello();
+
+    return m_connected;
+}
+
+void RollbackSession::setKeyState(std::uint8_t key, bool pressed) {
+    const auto keyBit = static_cast<std::uint16_t>(1 << (key & 0xF));
+    m_keys = static_cast<std::uint16_t>(pressed ? m_keys | keyBit : m_keys & ~keyBit);
+}
+
+bool RollbackSession::step() {
+    if (!m_connected)
+        return false;
+
+    ++m_framesSinceReceive;
+    receive();
+
+    if (m_rollbackFrame != UINT32_MAX)
+        rollBack();
+
+    // Wait for the other player rather than predicting further than can be rolled back,
+    // or sending more inputs than fit in a packet
+    if (m_frame >= m_remoteFrames + kMaxRollbackFrames
+        || m_localFrames - m_localAcknowledged >= kMaxInputsPerPacket) {
+        ++m_statistics.stalledFrames;
+        sendInputs();
+        return false;
+    }
+
+    // This frame's keys are for the frame the delay later
+    m_localInputs[m_localFrames % kInputHistory] = m_keys;
+    ++m_localFrames;
+
+    sendInputs();
+    runFrame();
+    checkDesync();
+
+    return true;
+}
+
+void RollbackSession::poll() {
+    if (!m_connected)
+        return;
+
+    receive();
+
+    if (m_rollbackFrame != UINT32_MAX)
+        rollBack();
+
+    checkDesync();
+    sendInputs();
+}
+
+void RollbackSession::sendHello() {
+    std::array<std::uint8_t, NetplayTransport::kMaxPacketSize> buffer;
+    PacketWriter writer{buffer};
+
+    for (const std::uint8_t byte : kMagic)
+        writer.put(byte);
+
+    writer.put(kProtocolVersion);
+    writer.put(PacketType::Hello);
+    writer.put(m_player);
+    writer.put(m_seed);
+    writer.put(m_startHash);
+
+    m_transport.send(writer.getPacket());
+}
+
+void RollbackSession::sendInputs() {
+    std::array<std::uint8_t, NetplayTransport::kMaxPacketSize> buffer;
+    PacketWriter writer{buffer};
+
+    for (const std::uint8_t byte : kMagic)
+        writer.put(byte);
+
+    writer.put(kProtocolVersion);
+    writer.put(PacketType::Inputs);
+    writer.put(m_remoteFrames);
+
+    // Every input not yet acknowledged, the other player skips those it has
+    const std::uint32_t count = std::min(m_localFrames - m_localAcknowledged, kMaxInputsPerPacket);
+    writer.put(m_localAcknowledged);
+    writer.put(static_cast<std::uint8_t>(count));
+
+    for (std::uint32_t frame = m_localAcknowledged; frame < m_localAcknowledged + count; ++frame)
+        writer.put(m_localInputs[frame % kInputHistory]);
+
+    writer.put(m_latestCheck.frame);
+    writer.put(m_latestCheck.hash);
+
+    m_transport.send(writer.getPacket());
+}
+
+void RollbackSession::receive() {
+    while (const std::optional<std::size_t> size = m_transport.receive(m_packet)) {
+        handlePacket(std::span<const std::uint8_t>{m_packet}.first(*size));
+        m_framesSinceReceive = 0;
+    }
+}
+
+void RollbackSession::handlePacket(std::span<const std::uint8_t> packet) {
+    PacketReader reader{packet};
+
+    for (const std::uint8_t byte : kMagic) {
+        if (reader.get<std::uint8_t>() != byte)
+            return;
+    }
+
+    const auto version = reader.get<std::uint8_t>();
+    const auto type = static_cast<PacketType>(reader.get<std::uint8_t>());
+
+    if (type == PacketType::Hello) {
+        const auto player = reader.get<std::uint8_t>();
+        const auto seed = reader.get<std::uint32_t>();
+        const auto hash = reader.get<std::uint64_t>();
+
+        if (!reader.isValid())
+            return;
+
+        if (version != kProtocolVersion)
+            throw std::runtime_error("The other player runs another version of netplay");
+
+        if (player == m_player)
+            throw std::runtime_error("Both players are player " + std::to_string(m_player + 1));
+
+        // Start from the first player's seed
+        if (m_player == 1 && !m_connected) {
+            m_seed = seed;
+            m_chip8.setRandomSeed(m_seed);
+            m_startHash = hashState(m_chip8);
+        }
+
+        if (seed != m_seed || hash != m_startHash)
+            throw std::runtime_error("The other player is running a different ROM");
+
+        m_connected = true;
+
+        if (m_player == 1)
+            sendHello();
+
+        return;
+    }
+
+    if (type != PacketType::Inputs || version != kProtocolVersion)
+        return;
+
+    const auto acknowledged = reader.get<std::uint32_t>();
+    const auto firstFrame = reader.get<std::uint32_t>();
+    const auto count = reader.get<std::uint8_t>();
+
+    std::array<std::uint16_t, kMaxInputsPerPacket> inputs;
+
+    for (std::uint32_t input{0}; input < std::min<std::uint32_t>(count, kMaxInputsPerPacket); ++input)
+        inputs[input] = reader.get<std::uint16_t>();
+
+    const auto checkFrame = reader.get<std::uint32_t>();
+    const auto checkHash = reader.get<std::uint64_t>();
+
+    if (!reader.isValid() || count > kMaxInputsPerPacket)
+        return;
+
+    if (acknowledged > m_localAcknowledged && acknowledged <= m_localFrames)
+        m_localAcknowledged = acknowledged;
+
+    // Take inputs continuing those received, the other player can't be further ahead than the history
+    for (std::uint32_t input{0}; input < count; ++input) {
+        const std::uint32_t frame = firstFrame + input;
+
+        if (frame != m_remoteFrames || frame >= m_frame + kInputHistory / 2)
+            continue;
+
+        const std::uint16_t keys = inputs[input];
+        m_remoteInputs[frame % kInputHistory] = keys;
+        ++m_remoteFrames;
+
+        // Run with a wrong prediction, roll back to it
+        if (frame < m_frame && m_usedRemoteInputs[frame % kInputHistory] != keys)
+            m_rollbackFrame = std::min(m_rollbackFrame, frame);
+    }
+
+    if (checkFrame != UINT32_MAX && (m_remoteCheck.frame == UINT32_MAX || checkFrame > m_remoteCheck.frame)) {
+        m_remoteCheck = Check{checkFrame, checkHash};
+        compareChecks();
+    }
+}
+
+void RollbackSession::rollBack() {
+    const auto start = std::chrono::steady_clock::now();
+
+    const std::uint32_t frames = m_frame - m_rollbackFrame;
+    const std::uint32_t targetFrame = m_frame;
+
+    // Wrong predictions are within the frames stalling allows, so their start is still cloned
+    m_states[m_rollbackFrame % kStateHistory]->cloneInto(m_chip8);
+    m_frame = m_rollbackFrame;
+    m_rollbackFrame = UINT32_MAX;
+
+    while (m_frame < targetFrame)
+        runFrame();
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ++m_statistics.rollbacks;
+    m_statistics.framesResimulated += frames;
+    m_statistics.maxRollbackFrames = std::max(m_statistics.maxRollbackFrames, frames);
+    m_statistics.maxRollbackTime = std::max(
+        m_statistics.maxRollbackTime, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+    );
+}
+
+void RollbackSession::runFrame() {
+    std::optional<Chip8>& state = m_states[m_frame % kStateHistory];
+
+    if (state)
+        m_chip8.cloneInto(*state);
+    else
+        state.emplace(m_chip8.fork());
+
+    // Predict the other player still holds the last keys received
+    std::uint16_t remoteKeys{0};
+
+    if (m_frame < m_remoteFrames)
+        remoteKeys = m_remoteInputs[m_frame % kInputHistory];
+    else if (m_remoteFrames > 0)
+        remoteKeys = m_remoteInputs[(m_remoteFrames - 1) % kInputHistory];
+
+    m_usedRemoteInputs[m_frame % kInputHistory] = remoteKeys;
+
+    // Press and release the keys which changed since the last frame, in the same order for both players
+    const auto keypad = static_cast<std::uint16_t>(m_localInputs[m_frame % kInputHistory] | remoteKeys);
+    const std::uint16_t previousKeypad = m_frame > 0 ? m_keypads[(m_frame - 1) % kInputHistory] : 0;
+
+    for (std::uint8_t key{0}; key < 16; ++key) {
+        if (((keypad ^ previousKeypad) >> key & 1) != 0)
+            m_chip8.setKeyState(key, (keypad >> key & 1) != 0);
+    }
+
+    m_keypads[m_frame % kInputHistory] = keypad;
+
+    m_chip8.step();
+    ++m_frame;
+}
+
+void RollbackSession::checkDesync() {
+    // The latest frame to check whose start both players have confirmed
+    const std::uint32_t frame = getConfirmedFrames() / kDesyncCheckInterval * kDesyncCheckInterval;
+
+    if (frame == 0 || (m_latestCheck.frame != UINT32_MAX && frame <= m_latestCheck.frame))
+        return;
+
+    if (frame == m_frame) {
+        m_latestCheck = Check{frame, hashState(m_chip8)};
+    } else if (m_frame - frame < kStateHistory) {
+        m_latestCheck = Check{frame, hashState(*m_states[frame % kStateHistory])};
+    } else {
+        return;
+    }
+
+    m_checks[frame / kDesyncCheckInterval % m_checks.size()] = m_latestCheck;
+    compareChecks();
+}
+
+void RollbackSession::compareChecks() {
+    // Both players hash the same frames, each is compared once both have hashed it
+    const Check& check = m_checks[m_remoteCheck.frame / kDesyncCheckInterval % m_checks.size()];
+
+    if (m_remoteCheck.frame != UINT32_MAX && check.frame == m_remoteCheck.frame && check.hash != m_remoteCheck.hash)
+        m_desynced = true;
+}
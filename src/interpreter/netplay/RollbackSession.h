@@ -0,0 +1,174 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "NetplayTransport.h"
+#include "../Chip8.h"
+
+/*
+ * Rollback netplay between two players, each running the same ROM in their
+ * own process, in the style of GGPO.
+ *
+ * Every frame, the local player's keys are sent to the other player, and
+ * the machine runs on the other player's keys predicted to be the last ones
+ * received. The keypad is the keys of both players combined, so ROMs reading
+ * each player's keys with EX9E/EXA1 work unchanged. The machine is cloned
+ * at the start of every frame (see Chip8::cloneInto()). When the other
+ * player's keys for a frame arrive and differ from the prediction, the
+ * machine rolls back to that frame and runs the frames since with the
+ * correct keys, within one call to step().
+ *
+ * Packets repeat every input the other player hasn't acknowledged, so lost
+ * packets are recovered by the next one. Play stalls (step() returns false)
+ * when the other player falls kMaxRollbackFrames frames behind. Players
+ * exchange a hash of the state of frames both have confirmed, to detect
+ * desyncs. The first player chooses the seed of the random numbers.
+ */
+class RollbackSession {
+    public:
+        // Most frames re-run by a rollback, the furthest play runs ahead of the other player
+        static constexpr std::uint32_t kMaxRollbackFrames = 8;
+
+        // Most frames the local keys are delayed by, to lower how often predictions are wrong
+        static constexpr std::uint32_t kMaxInputDelay = 8;
+
+        // Frames between checks of the state hash for desyncs
+        static constexpr std::uint32_t kDesyncCheckInterval = 60;
+
+        // Frames to stall without hearing from the other player before disconnecting
+        static constexpr std::uint32_t kDisconnectFrames = 5 * 60;
+
+        struct Statistics {
+            std::uint64_t rollbacks{0};
+            std::uint64_t framesResimulated{0};
+            std::uint32_t maxRollbackFrames{0};
+            std::chrono::nanoseconds maxRollbackTime{0};
+            std::uint64_t stalledFrames{0};
+        };
+
+    private:
+        // Frames of input history, more than can be in flight between the players
+        static constexpr std::uint32_t kInputHistory = 128;
+
+        // Clones of the machine at the start of each of the latest frames
+        static constexpr std::uint32_t kStateHistory = kMaxRollbackFrames + 2;
+
+        Chip8& m_chip8;
+        NetplayTransport& m_transport;
+
+        // This player, 0 or 1, and how many frames its keys are delayed by
+        std::uint8_t m_player;
+        std::uint32_t m_inputDelay;
+
+        // Seed of the random numbers, chosen by the first player,
+        // and the hash of the seeded state both players start from
+        std::uint32_t m_seed;
+        std::uint64_t m_startHash{0};
+
+        bool m_connected{false};
+        bool m_desynced{false};
+
+        // The next frame to run
+        std::uint32_t m_frame{0};
+
+        // Keys this player pressed for frames below m_localFrames, and the
+        // other player's for frames below m_remoteFrames. Indexed by frame % kInputHistory.
+        std::array<std::uint16_t, kInputHistory> m_localInputs{};
+        std::array<std::uint16_t, kInputHistory> m_remoteInputs{};
+        std::uint32_t m_localFrames{0};
+        std::uint32_t m_remoteFrames{0};
+
+        // Frames of local input the other player has
+        std::uint32_t m_localAcknowledged{0};
+
+        // The other player's keys and the keypad each run frame used
+        std::array<std::uint16_t, kInputHistory> m_usedRemoteInputs{};
+        std::array<std::uint16_t, kInputHistory> m_keypads{};
+
+        // The earliest frame run with a wrong prediction, UINT32_MAX if none
+        std::uint32_t m_rollbackFrame{UINT32_MAX};
+
+        // Keys currently held by this player
+        std::uint16_t m_keys{0};
+
+        std::array<std::optional<Chip8>, kStateHistory> m_states;
+
+        // State hash of a frame checked for desyncs, the frame UINT32_MAX if none
+        struct Check {
+            std::uint32_t frame{UINT32_MAX};
+            std::uint64_t hash{0};
+        };
+
+        // This player's latest checks, by frame / kDesyncCheckInterval, and the other player's latest
+        std::array<Check, 4> m_checks{};
+        Check m_latestCheck;
+        Check m_remoteCheck;
+
+        std::uint32_t m_framesSinceReceive{0};
+        Statistics m_statistics;
+
+        // Packets read from the transport
+        std::array<std::uint8_t, NetplayTransport::kMaxPacketSize> m_packet{};
+
+        void sendHello();
+        void sendInputs();
+
+        // Read every packet received, noting wrong predictions
+        void receive();
+        void handlePacket(std::span<const std::uint8_t> packet);
+
+        // Re-run the frames since the earliest wrong prediction
+        void rollBack();
+
+        // Run frame m_frame, cloning the machine at its start
+        void runFrame();
+
+        // Hash the state at the start of every kDesyncCheckInterval-th frame once confirmed by both players
+        void checkDesync();
+
+        // Compare the other player's latest check with this player's of the same frame
+        void compareChecks();
+
+    public:
+        // Play as player (0 or 1) on chip8, freshly loaded with the same ROM as the other player's
+        RollbackSession(Chip8& chip8, NetplayTransport& transport, std::uint8_t player, std::uint32_t inputDelay);
+
+        // Exchange greetings with the other player, true once both are connected.
+        // Call every frame until it is. Throws std::runtime_error if the players' ROMs differ.
+        bool connect();
+
+        // Update the pressed state of this player's key (0x0-0xF) for the next frame
+        void setKeyState(std::uint8_t key, bool pressed);
+
+        // Run the next frame, rolling back first if a prediction was wrong.
+        // Returns false without running it while waiting for the other player.
+        bool step();
+
+        // Receive and roll back without running a frame, e.g. to settle the final frames
+        void poll();
+
+        // The next frame to run
+        [[nodiscard]] std::uint32_t getFrame() const {
+            return m_frame;
+        }
+
+        // Frames run with the other player's actual keys, so final unless desynced
+        [[nodiscard]] std::uint32_t getConfirmedFrames() const {
+            return std::min(m_frame, m_remoteFrames);
+        }
+
+        [[nodiscard]] bool isDesynced() const {
+            return m_desynced;
+        }
+
+        [[nodiscard]] bool isDisconnected() const {
+            return m_framesSinceReceive >= kDisconnectFrames;
+        }
+
+        [[nodiscard]] const Statistics& getStatistics() const {
+            return m_statistics;
+        }
+};
@@ -0,0 +1,122 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include "UdpTransport.h"
+
+#if defined(_WIN32)
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+#else
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <unistd.h>
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+#endif
+
+#if defined(_WIN32)
+    using NativeSocket = SOCKET;
+    static constexpr NativeSocket kInvalidSocket = INVALID_SOCKET;
+
+    // Winsock is started once for the process, and never cleaned up
+    static void startSockets() {
+        static const bool started = [] {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+
+        if (!started)
+            throw std::runtime_error("Failed to start Winsock");
+    }
+
+    static void closeSocket(NativeSocket socket) {
+        closesocket(socket);
+    }
+#else
+    using NativeSocket = int;
+    static constexpr NativeSocket kInvalidSocket = -1;
+
+    static void startSockets() {}
+
+    static void closeSocket(NativeSocket socket) {
+        close(socket);
+    }
+#endif
+
+UdpTransport::UdpTransport(std::uint16_t localPort, const std::string& peerHost, std::uint16_t peerPort) {
+    startSockets();
+
+    // Resolve the peer first, so a bad host doesn't leave a socket open
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+
+    if (getaddrinfo(peerHost.c_str(), nullptr, &hints, &result) != 0 || result == nullptr)
+        throw std::runtime_error("Can't resolve netplay peer: " + peerHost);
+
+    m_peerAddress = reinterpret_cast<const sockaddr_in*>(result->ai_addr)->sin_addr.s_addr;
+    m_peerPort = htons(peerPort);
+    freeaddrinfo(result);
+
+    const NativeSocket native = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (native == kInvalidSocket)
+        throw std::runtime_error(std::string{"Can't open a UDP socket: "} + std::strerror(errno));
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(localPort);
+
+    #if defined(_WIN32)
+        u_long nonBlocking = 1;
+        const bool configured = ioctlsocket(native, FIONBIO, &nonBlocking) == 0;
+    #else
+        const bool configured = fcntl(native, F_SETFL, fcntl(native, F_GETFL) | O_NONBLOCK) == 0;
+    #endif
+
+    if (!configured || bind(native, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0) {
+        closeSocket(native);
+        throw std::runtime_error("Can't bind UDP port " + std::to_string(localPort));
+    }
+
+    m_socket = static_cast<std::intptr_t>(native);
+}
+
+UdpTransport::~UdpTransport() {
+    closeSocket(static_cast<NativeSocket>(m_socket));
+}
+
+void UdpTransport::send(std::span<const std::uint8_t> packet) {
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+    peer.sin_addr.s_addr = m_peerAddress;
+    peer.sin_port = m_peerPort;
+
+    // Failures are lost packets, which rollback recovers from like any other
+    (void) sendto(
+        static_cast<NativeSocket>(m_socket), reinterpret_cast<const char*>(packet.data()),
+        static_cast<int>(packet.size()), 0, reinterpret_cast<const sockaddr*>(&peer), sizeof(peer)
+    );
+}
+
+std::optional<std::size_t> UdpTransport::receive(std::span<std::uint8_t, kMaxPacketSize> buffer) {
+    while (true) {
+        sockaddr_in sender{};
+        socklen_t senderSize = sizeof(sender);
+
+        const auto size = recvfrom(
+            static_cast<NativeSocket>(m_socket), reinterpret_cast<char*>(buffer.data()),
+            static_cast<int>(buffer.size()), 0, reinterpret_cast<sockaddr*>(&sender), &senderSize
+        );
+
+        // Nothing waiting (or an error, e.g. the peer's port isn't open yet)
+        if (size < 0)
+            return std::nullopt;
+
+        if (sender.sin_addr.s_addr == m_peerAddress && sender.sin_port == m_peerPort)
+            return static_cast<std::size_t>(size);
+    }
+}
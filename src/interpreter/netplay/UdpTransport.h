@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "NetplayTransport.h"
+
+/*
+ * Netplay over a non-blocking UDP socket (IPv4), bound to a local port and
+ * exchanging packets with one peer. Packets from any other address are
+ * ignored.
+ */
+class UdpTransport final : public NetplayTransport {
+    // Native socket handle (a SOCKET on Windows)
+    std::intptr_t m_socket;
+
+    // Peer address and port in network byte order
+    std::uint32_t m_peerAddress{0};
+    std::uint16_t m_peerPort{0};
+
+    public:
+        // Bind localPort on every interface and send to peerHost:peerPort.
+        // Throws std::runtime_error if the socket can't be opened or the host resolved.
+        UdpTransport(std::uint16_t localPort, const std::string& peerHost, std::uint16_t peerPort);
+        ~UdpTransport() override;
+
+        UdpTransport(const UdpTransport&) = delete;
+        UdpTransport& operator=(const UdpTransport&) = delete;
+
+        void send(std::span<const std::uint8_t> packet) override;
+        std::optional<std::size_t> receive(std::span<std::uint8_t, kMaxPacketSize> buffer) override;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../chip8_microops.h"
+
+/*
+ * Handler instantiation for the specialized engine.
+ *
+ * Each handler is executeMicroOp() for one instruction word, decoded at
+ * compile time so the micro-op and its operands are constants. Instantiating
+ * all 65,536 is slow, so every prefix gets its own translation unit
+ * (handlers_0.cpp to handlers_F.cpp) defining its table with
+ * HOTCHIP_SPECIALIZED_HANDLERS().
+ */
+#if defined(HOTCHIP_SPECIALIZED_TABLE)
+
+template<std::uint16_t instruction>
+void Chip8::executeSpecialized(Chip8& chip8) {
+    static constexpr DecodedInstruction kInstruction = decodeMicroOp(instruction);
+    chip8.executeMicroOp<kInstruction.op>(kInstruction);
+}
+
+template<std::uint8_t prefix, std::uint16_t... suffixes>
+constexpr std::array<Chip8::SpecializedHandler, 0x1000> Chip8::makeSpecializedTable(
+    std::integer_sequence<std::uint16_t, suffixes...>
+) {
+    return {&Chip8::executeSpecialized<static_cast<std::uint16_t>(prefix << 12 | suffixes)>...};
+}
+
+#define HOTCHIP_SPECIALIZED_HANDLERS(prefix)                                                       \
+    template<>                                                                                     \
+    constinit const std::array<Chip8::SpecializedHandler, 0x1000> Chip8::kSpecializedHandlers<prefix> = \
+        Chip8::makeSpecializedTable<prefix>(std::make_integer_sequence<std::uint16_t, 0x1000>{});
+
+#else
+
+#define HOTCHIP_SPECIALIZED_HANDLERS(prefix)
+
+#endif
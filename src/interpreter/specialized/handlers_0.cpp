@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0x0000-0x0FFF
+HOTCHIP_SPECIALIZED_HANDLERS(0x0)
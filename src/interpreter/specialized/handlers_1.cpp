@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0x1000-0x1FFF
+HOTCHIP_SPECIALIZED_HANDLERS(0x1)
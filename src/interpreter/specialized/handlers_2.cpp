@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0x2000-0x2FFF
+HOTCHIP_SPECIALIZED_HANDLERS(0x2)
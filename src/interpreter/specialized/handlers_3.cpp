@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0x3000-0x3FFF
+HOTCHIP_SPECIALIZED_HANDLERS(0x3)
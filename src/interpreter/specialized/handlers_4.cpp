@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0x4000-0x4FFF
+HOTCHIP_SPECIALIZED_HANDLERS(0x4)
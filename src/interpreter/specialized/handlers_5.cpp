@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0x5000-0x5FFF
+HOTCHIP_SPECIALIZED_HANDLERS(0x5)
@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0x6000-0x6FFF
+HOTCHIP_SPECIALIZED_HANDLERS(0x6)
@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0x7000-0x7FFF
+HOTCHIP_SPECIALIZED_HANDLERS(0x7)
@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0x8000-0x8FFF
+HOTCHIP_SPECIALIZED_HANDLERS(0x8)
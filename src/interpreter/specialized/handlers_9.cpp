@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0x9000-0x9FFF
+HOTCHIP_SPECIALIZED_HANDLERS(0x9)
@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0xA000-0xAFFF
+HOTCHIP_SPECIALIZED_HANDLERS(0xA)
@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0xB000-0xBFFF
+HOTCHIP_SPECIALIZED_HANDLERS(0xB)
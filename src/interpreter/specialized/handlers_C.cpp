@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0xC000-0xCFFF
+HOTCHIP_SPECIALIZED_HANDLERS(0xC)
@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0xD000-0xDFFF
+HOTCHIP_SPECIALIZED_HANDLERS(0xD)
@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0xE000-0xEFFF
+HOTCHIP_SPECIALIZED_HANDLERS(0xE)
@@ -0,0 +1,4 @@
+#include "SpecializedHandlers.h"
+
+// Instructions 0xF000-0xFFFF
+HOTCHIP_SPECIALIZED_HANDLERS(0xF)
@@ -1,25 +1,33 @@
 #pragma once
 
-#include <SDL.h>
 #include "Timer.h"
 
-// Sound timer is write only
+// Sound timer is write only.
+// The beep itself is produced by the frontend while isBeeping() is true.
 class SoundTimer : public Timer {
-    static constexpr std::uint8_t kTimerFrequency = 60;
-    static constexpr std::uint8_t kAudioPlay = 0;
-    static constexpr std::uint8_t kAudioPause = 1;
+    bool m_isBeeping = false;
 
-    SDL_AudioSpec m_desired{}, m_obtained{};
+    public:
+        [[nodiscard]] bool isBeeping() const {
+            return m_isBeeping;
+        }
 
-    // Initialised in constructor
-    // https://wiki.libsdl.org/SDL2/SDL_OpenAudioDevice
-    SDL_AudioDeviceID m_audioDevice;
+        // Restore the beeping state of a save state
+        void setBeeping(bool beeping) {
+            m_isBeeping = beeping;
+        }
 
-    bool m_isBeeping = false;
+        void tickTimer() override {
+            // Beep when timer is non-zero
+            m_isBeeping = m_timer > 0;
 
-    public:
-        SoundTimer();
-        ~SoundTimer() override;
-        void tickTimer() override;
-        void reset() override;
+            if (m_timer > 0)
+                --m_timer;
+        }
+
+        void reset() override {
+            // Reset state
+            m_timer = 0;
+            m_isBeeping = false;
+        }
 };
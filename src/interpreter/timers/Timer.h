@@ -1,6 +1,6 @@
 #pragma once
 
-#include <thread>
+#include <cstdint>
 
 class Timer {
     protected:
@@ -11,6 +11,10 @@ class Timer {
             m_timer = value;
         }
 
+        [[nodiscard]] std::uint8_t getTimer() const {
+            return m_timer;
+        }
+
         // Require derived timer classes to provide methods to tick and reset the timer
         virtual void tickTimer() = 0;
         virtual void reset() = 0;
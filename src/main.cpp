@@ -1,25 +1,137 @@
-#include "interpreter/Chip8.h"
+#include <iostream>
+#include "window/SDLFrontend.h"
 
 int main(int argc, char** argv) {
     if (argc > 1) {
         std::string ROMPath{argv[1]};
 
+        /*
+         * Optionally select the interpreter engine at startup.
+         * Only the decode engine reports instruction history to the debug UI.
+         */
+        Chip8::Engine engine = Chip8::Engine::Decode;
+
+        // Frames to run ahead of the emulated one (see RunAhead)
+        std::uint32_t runAheadFrames{0};
+
+        // Movie files to record the session to or play back (see InputMovie)
+        std::string recordMoviePath;
+        std::string playMoviePath;
+
+        // Netplay player (1 or 2), local port and the other player's address (see RollbackSession)
+        std::uint8_t netplayPlayer{0};
+        std::uint16_t netplayPort{0};
+        std::string peerHost;
+        std::uint16_t peerPort{0};
+        std::uint32_t inputDelay{0};
+
+        for (int i{2}; i + 1 < argc; i += 2) {
+            const std::string_view option{argv[i]};
+
+            if (option == "--engine") {
+                const std::optional<Chip8::Engine> parsed = Chip8::parseEngine(argv[i + 1]);
+
+                if (!parsed) {
+                    std::cout << "Unknown engine: " << argv[i + 1] << std::endl;
+                    return 1;
+                }
+
+                engine = *parsed;
+            } else if (option == "--run-ahead") {
+                runAheadFrames = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+
+                if (runAheadFrames > RunAhead::kMaxFrames) {
+                    std::cout << "Can run at most " << RunAhead::kMaxFrames << " frames ahead" << std::endl;
+                    return 1;
+                }
+            } else if (option == "--record-movie") {
+                recordMoviePath = argv[i + 1];
+            } else if (option == "--play-movie") {
+                playMoviePath = argv[i + 1];
+            } else if (option == "--player") {
+                netplayPlayer = static_cast<std::uint8_t>(std::stoul(argv[i + 1]));
+            } else if (option == "--port") {
+                netplayPort = static_cast<std::uint16_t>(std::stoul(argv[i + 1]));
+            } else if (option == "--peer") {
+                const std::string_view peer{argv[i + 1]};
+                const std::size_t colon = peer.rfind(':');
+
+                if (colon == std::string_view::npos) {
+                    std::cout << "The peer must be HOST:PORT" << std::endl;
+                    return 1;
+                }
+
+                peerHost = peer.substr(0, colon);
+                peerPort = static_cast<std::uint16_t>(std::stoul(std::string{peer.substr(colon + 1)}));
+            } else if (option == "--input-delay") {
+                inputDelay = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+            }
+        }
+
+        const bool netplay = netplayPlayer != 0 || !peerHost.empty();
+
+        if (netplay) {
+            if (netplayPlayer < 1 || netplayPlayer > 2 || netplayPort == 0 || peerHost.empty()) {
+                std::cout << "Netplay needs --player 1|2, --port and --peer HOST:PORT" << std::endl;
+                return 1;
+            }
+
+            if (inputDelay > RollbackSession::kMaxInputDelay) {
+                std::cout << "Input can be delayed by at most " << RollbackSession::kMaxInputDelay << " frames" << std::endl;
+                return 1;
+            }
+
+            // The session runs every frame and owns the keypad
+            if (runAheadFrames != 0 || !recordMoviePath.empty() || !playMoviePath.empty()) {
+                std::cout << "Run-ahead and movies can't be used in netplay" << std::endl;
+                return 1;
+            }
+        }
+
         /*
          * Create a window to use as a display.
          *
          * Window holds the ROMPath selected by the user,
-         * Chip8 retrieves this on initialisation and when
-         * a ROM change occurs.
+         * the frontend checks this every frame to detect
+         * when a ROM change occurs.
          */
         MainWindow window = MainWindow(ROMPath);
 
-        // Create a CHIP-8 interpreter with window passed by reference
-        Chip8 interpreter = Chip8(window);
+        // Create the frontend that drives the interpreter in real time
+        SDLFrontend frontend = SDLFrontend(window);
+        frontend.setRunAheadFrames(runAheadFrames);
+
+        if (!recordMoviePath.empty())
+            frontend.recordMovie(recordMoviePath);
+
+        if (!playMoviePath.empty()) {
+            try {
+                frontend.playMovie(playMoviePath);
+            } catch (const std::runtime_error& error) {
+                std::cout << error.what() << std::endl;
+                return 1;
+            }
+        }
+
+        if (netplay) {
+            try {
+                frontend.playNetplay(
+                    static_cast<std::uint8_t>(netplayPlayer - 1), netplayPort, peerHost, peerPort, inputDelay
+                );
+            } catch (const std::runtime_error& error) {
+                std::cout << error.what() << std::endl;
+                return 1;
+            }
+        }
+
+        // Create a CHIP-8 interpreter with frontend passed by reference
+        Chip8 interpreter = Chip8(ROMPath, frontend);
+        interpreter.setEngine(engine);
 
-        interpreter.start();
+        frontend.start(interpreter);
     } else {
         std::cout << "No ROM provided." << std::endl;
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,507 @@
+#include <map>
+#include <set>
+#include <deque>
+#include <vector>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <filesystem>
+#include <string_view>
+#include "../interpreter/MicroOp.h"
+
+/*
+ * hotchip-aot: statically recompile a ROM to a C++ translation unit.
+ *
+ * Traces the code reachable from 0x200 and emits one function per basic
+ * block, plus an AotProgram registering them. Compile the output into an
+ * executable linking hotchip_core (see HOTCHIP_AOT_ROMS in CMakeLists.txt)
+ * and select the "aot" engine to run it.
+ *
+ * Only register and index instructions and static control flow are
+ * compiled. Blocks end before any other instruction, which the engine
+ * interprets before entering the next block. Blocks with a static
+ * successor call it directly instead of returning to the engine.
+ *
+ * Usage: hotchip-aot <ROM> [-o output.cpp]
+ */
+
+static constexpr std::uint16_t kROMOffset = 0x200;
+static constexpr std::uint16_t kMaxROMSize = 0x1000 - kROMOffset;
+
+static void printUsage() {
+    std::cerr << "Usage: hotchip-aot <ROM> [-o output.cpp]" << std::endl;
+}
+
+// Whether a micro-op is compiled, rather than left to the interpreter
+static bool isCompiled(MicroOp op) {
+    switch (op) {
+        case MicroOp::SET_IMM:
+        case MicroOp::ADD_IMM:
+        case MicroOp::REG_ASSIGNMENT:
+        case MicroOp::REG_OR:
+        case MicroOp::REG_AND:
+        case MicroOp::REG_XOR:
+        case MicroOp::REG_ADD:
+        case MicroOp::REG_SUBTRACT:
+        case MicroOp::REG_RSHIFT:
+        case MicroOp::REG_DIFFERENCE:
+        case MicroOp::REG_LSHIFT:
+        case MicroOp::SET_INDEX:
+        case MicroOp::ADD_TO_I:
+        case MicroOp::GOTO:
+        case MicroOp::SKIP_EQ_IMM:
+        case MicroOp::SKIP_NE_IMM:
+        case MicroOp::SKIP_EQ_REG:
+        case MicroOp::SKIP_NE_REG:
+        case MicroOp::JUMP_V0:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Whether a micro-op ends a basic block
+static bool endsBlock(MicroOp op) {
+    return !isCompiled(op)
+        || op == MicroOp::GOTO || op == MicroOp::JUMP_V0
+        || op == MicroOp::SKIP_EQ_IMM || op == MicroOp::SKIP_NE_IMM
+        || op == MicroOp::SKIP_EQ_REG || op == MicroOp::SKIP_NE_REG;
+}
+
+class Recompiler {
+    std::vector<std::uint8_t> m_ROM;
+
+    // The memory location of the ROM's final valid instruction
+    std::uint16_t m_finalInstruction;
+
+    // Addresses starting a basic block
+    std::set<std::uint16_t> m_leaders;
+
+    // Compiled blocks: start address to the address after the block
+    std::map<std::uint16_t, std::uint16_t> m_blocks;
+
+    [[nodiscard]] bool inROM(std::uint16_t address) const {
+        return address >= kROMOffset && address <= m_finalInstruction;
+    }
+
+    [[nodiscard]] DecodedInstruction decodeAt(std::uint16_t address) const {
+        const std::size_t offset = address - kROMOffset;
+        return decodeMicroOp(static_cast<std::uint16_t>(m_ROM[offset]) << 8 | m_ROM[offset + 1]);
+    }
+
+    // Follow every static path from 0x200, recording where basic blocks start
+    void findLeaders() {
+        std::deque<std::uint16_t> worklist{kROMOffset};
+        std::set<std::uint16_t> visited;
+
+        const auto addLeader = [&](std::uint16_t address) {
+            if (inROM(address) && m_leaders.insert(address).second)
+                worklist.push_back(address);
+        };
+
+        m_leaders.insert(kROMOffset);
+
+        while (!worklist.empty()) {
+            std::uint16_t PC = worklist.front();
+            worklist.pop_front();
+
+            while (inROM(PC) && visited.insert(PC).second) {
+                const DecodedInstruction instruction = decodeAt(PC);
+
+                switch (instruction.op) {
+                    case MicroOp::GOTO:
+                        addLeader(instruction.nnn);
+                        break;
+                    case MicroOp::CALL:
+                        addLeader(instruction.nnn);
+                        addLeader(PC + 2);
+                        break;
+                    case MicroOp::SKIP_EQ_IMM:
+                    case MicroOp::SKIP_NE_IMM:
+                    case MicroOp::SKIP_EQ_REG:
+                    case MicroOp::SKIP_NE_REG:
+                    case MicroOp::IS_KEY_PRESSED:
+                    case MicroOp::IS_KEY_NOT_PRESSED:
+                        addLeader(PC + 2);
+                        addLeader(PC + 4);
+                        break;
+                    case MicroOp::RETURN:
+                    case MicroOp::JUMP_V0:
+                        // Targets only known at run time
+                        break;
+                    default:
+                        // Interpreted instructions end a block, execution resumes after them
+                        if (!isCompiled(instruction.op))
+                            addLeader(PC + 2);
+
+                        PC += 2;
+                        continue;
+                }
+
+                break;
+            }
+        }
+    }
+
+    // Emit the C++ statement(s) executing a straight-line instruction
+    static std::string emitInstruction(const DecodedInstruction& instruction) {
+        const unsigned x = instruction.x;
+        const unsigned y = instruction.y;
+
+        // Operations of a register with itself are folded, compilers warn about self-comparisons
+        if (x == y) {
+            switch (instruction.op) {
+                case MicroOp::REG_ASSIGNMENT:
+                    return std::format("// v{:X} = v{:X}", x, y);
+                case MicroOp::REG_SUBTRACT:
+                case MicroOp::REG_DIFFERENCE:
+                    return std::format("v{:X} = 0; vF = 1;", x);
+                default:
+                    break;
+            }
+        }
+
+        switch (instruction.op) {
+            case MicroOp::SET_IMM:
+                return std::format("v{:X} = 0x{:02X};", x, instruction.nn);
+            case MicroOp::ADD_IMM:
+                return std::format("v{:X} = (v{:X} + 0x{:02X}) & 0xFF;", x, x, instruction.nn);
+            case MicroOp::REG_ASSIGNMENT:
+                return std::format("v{:X} = v{:X};", x, y);
+            case MicroOp::REG_OR:
+                return std::format("v{:X} |= v{:X};", x, y);
+            case MicroOp::REG_AND:
+                return std::format("v{:X} &= v{:X};", x, y);
+            case MicroOp::REG_XOR:
+                return std::format("v{:X} ^= v{:X};", x, y);
+            // VX is written before VF, so VF wins when X is F
+            case MicroOp::REG_ADD:
+                return std::format(
+                    "{{ const unsigned sum = v{:X} + v{:X}; v{:X} = sum & 0xFF; vF = sum >> 8; }}", x, y, x
+                );
+            case MicroOp::REG_SUBTRACT:
+                return std::format(
+                    "{{ const unsigned flag = v{0:X} >= v{1:X}; v{0:X} = (v{0:X} - v{1:X}) & 0xFF; vF = flag; }}", x, y
+                );
+            case MicroOp::REG_DIFFERENCE:
+                return std::format(
+                    "{{ const unsigned flag = v{1:X} >= v{0:X}; v{0:X} = (v{1:X} - v{0:X}) & 0xFF; vF = flag; }}", x, y
+                );
+            // QUIRK: shifts read VY
+            case MicroOp::REG_RSHIFT:
+                return std::format(
+                    "{{ const unsigned VY = v{1:X}; v{0:X} = VY >> 1; vF = VY & 1; }}", x, y
+                );
+            case MicroOp::REG_LSHIFT:
+                return std::format(
+                    "{{ const unsigned VY = v{1:X}; v{0:X} = (VY << 1) & 0xFF; vF = VY >> 7; }}", x, y
+                );
+            case MicroOp::SET_INDEX:
+                return std::format("*index = 0x{:03X};", instruction.nnn);
+            case MicroOp::ADD_TO_I:
+                return std::format("*index = static_cast<std::uint16_t>(*index + v{:X});", x);
+            default:
+                return {};
+        }
+    }
+
+    // Bit mask of the V registers an instruction reads or writes
+    static std::uint16_t registersUsed(const DecodedInstruction& instruction) {
+        switch (instruction.op) {
+            case MicroOp::SET_IMM:
+            case MicroOp::ADD_IMM:
+            case MicroOp::ADD_TO_I:
+            case MicroOp::SKIP_EQ_IMM:
+            case MicroOp::SKIP_NE_IMM:
+                return 1 << instruction.x;
+            case MicroOp::SKIP_EQ_REG:
+            case MicroOp::SKIP_NE_REG:
+                // Folded when comparing a register with itself
+                return instruction.x == instruction.y ? 0 : 1 << instruction.x | 1 << instruction.y;
+            case MicroOp::REG_ASSIGNMENT:
+            case MicroOp::REG_OR:
+            case MicroOp::REG_AND:
+            case MicroOp::REG_XOR:
+                return 1 << instruction.x | 1 << instruction.y;
+            case MicroOp::REG_ADD:
+            case MicroOp::REG_SUBTRACT:
+            case MicroOp::REG_RSHIFT:
+            case MicroOp::REG_DIFFERENCE:
+            case MicroOp::REG_LSHIFT:
+                return 1 << instruction.x | 1 << instruction.y | 1 << 0xF;
+            case MicroOp::JUMP_V0:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    // Bit mask of the V registers an instruction writes
+    static std::uint16_t registersModified(const DecodedInstruction& instruction) {
+        switch (instruction.op) {
+            case MicroOp::SET_IMM:
+            case MicroOp::ADD_IMM:
+            case MicroOp::REG_ASSIGNMENT:
+            case MicroOp::REG_OR:
+            case MicroOp::REG_AND:
+            case MicroOp::REG_XOR:
+                return 1 << instruction.x;
+            case MicroOp::REG_ADD:
+            case MicroOp::REG_SUBTRACT:
+            case MicroOp::REG_RSHIFT:
+            case MicroOp::REG_DIFFERENCE:
+            case MicroOp::REG_LSHIFT:
+                return 1 << instruction.x | 1 << 0xF;
+            default:
+                return 0;
+        }
+    }
+
+    // Instructions of the block starting at start. A block runs until
+    // its terminator, the next leader or an interpreted instruction.
+    [[nodiscard]] std::vector<DecodedInstruction> blockAt(std::uint16_t start) const {
+        std::vector<DecodedInstruction> instructions;
+        std::uint16_t PC = start;
+
+        while (inROM(PC)) {
+            const DecodedInstruction instruction = decodeAt(PC);
+
+            if (!isCompiled(instruction.op))
+                break;
+
+            instructions.push_back(instruction);
+            PC += 2;
+
+            if (endsBlock(instruction.op) || m_leaders.contains(PC))
+                break;
+        }
+
+        return instructions;
+    }
+
+    /*
+     * Emit leaving the block after executed instructions, continuing at target.
+     * Blocks call their successor directly while there is budget left and the
+     * successor hasn't been disabled by self-modifying code.
+     */
+    void emitExit(
+        std::ostream& out, std::string_view indent, std::size_t executed,
+        std::uint16_t target, bool& chained
+    ) const {
+        if (m_blocks.contains(target)) {
+            chained = true;
+            out << std::format(
+                "{0}if (budget > {1} && blocks.getBlock(0x{2:03X}) == block{2:03X}) {{\n"
+                "{0}    const std::uint32_t executed = leave({1}, 0);\n"
+                "{0}    return executed + block{2:03X}(V, index, budget - {1}, blocks);\n"
+                "{0}}}\n",
+                indent, executed, target
+            );
+        }
+
+        out << std::format("{}return leave({}, 0x{:03X});\n", indent, executed, target);
+    }
+
+    // Emit the function of the block starting at start
+    void emitBlock(std::ostream& out, std::uint16_t start) const {
+        const std::vector<DecodedInstruction> instructions = blockAt(start);
+
+        std::uint16_t used{0};
+        std::uint16_t modified{0};
+        bool usesIndex = false;
+
+        for (const DecodedInstruction& instruction : instructions) {
+            used |= registersUsed(instruction);
+            modified |= registersModified(instruction);
+            usesIndex |= instruction.op == MicroOp::SET_INDEX || instruction.op == MicroOp::ADD_TO_I;
+        }
+
+        // Emit the body first, the parameters it needs are only known afterwards
+        std::ostringstream body;
+        std::uint16_t PC = start;
+        bool chained = false;
+
+        for (std::size_t i{0}; i < instructions.size(); ++i, PC += 2) {
+            const DecodedInstruction& instruction = instructions[i];
+            const unsigned x = instruction.x;
+            const unsigned y = instruction.y;
+
+            // Leave once the frame's instruction budget is used up
+            if (i > 0)
+                body << std::format("    if (budget <= {0}) return leave({0}, 0x{1:03X});\n", i, PC);
+
+            switch (instruction.op) {
+                case MicroOp::GOTO:
+                    emitExit(body, "    ", i + 1, instruction.nnn, chained);
+                    break;
+                case MicroOp::JUMP_V0:
+                    body << std::format("    return leave({}, v0 + 0x{:03X});\n", i + 1, instruction.nnn);
+                    break;
+                case MicroOp::SKIP_EQ_IMM:
+                case MicroOp::SKIP_NE_IMM:
+                case MicroOp::SKIP_EQ_REG:
+                case MicroOp::SKIP_NE_REG: {
+                    const bool equal =
+                        instruction.op == MicroOp::SKIP_EQ_IMM || instruction.op == MicroOp::SKIP_EQ_REG;
+                    const bool immediate =
+                        instruction.op == MicroOp::SKIP_EQ_IMM || instruction.op == MicroOp::SKIP_NE_IMM;
+                    const std::string rhs = immediate
+                        ? std::format("0x{:02X}", instruction.nn)
+                        : std::format("v{:X}", y);
+
+                    // A register always equals itself
+                    if (!immediate && x == y) {
+                        emitExit(body, "    ", i + 1, equal ? PC + 4 : PC + 2, chained);
+                        break;
+                    }
+
+                    body << std::format("    if (v{:X} {} {}) {{\n", x, equal ? "==" : "!=", rhs);
+                    emitExit(body, "        ", i + 1, PC + 4, chained);
+                    body << "    }\n";
+                    emitExit(body, "    ", i + 1, PC + 2, chained);
+                    break;
+                }
+                default:
+                    body << "    " << emitInstruction(instruction) << '\n';
+                    break;
+            }
+        }
+
+        // Fall through to the next block or interpreted instruction
+        if (!endsBlock(instructions.back().op))
+            emitExit(body, "    ", instructions.size(), PC, chained);
+
+        const bool usesBudget = instructions.size() > 1 || chained;
+
+        out << std::format("// 0x{:03X}-0x{:03X}\n", start, PC - 1);
+        out << std::format(
+            "std::uint32_t block{:03X}(std::uint8_t*{}, std::uint16_t*{}, std::uint32_t{}, const AotBlockTable&{}) {{\n",
+            start, used || chained ? " V" : "", usesIndex || chained ? " index" : "",
+            usesBudget ? " budget" : "", chained ? " blocks" : ""
+        );
+
+        for (std::uint8_t reg{0}; reg < 16; ++reg) {
+            if (used & (1 << reg))
+                out << std::format("    unsigned v{0:X} = V[0x{0:X}];\n", reg);
+        }
+
+        // Write back modified registers and pack the result
+        out << "    const auto leave = [&](std::uint32_t executed, std::uint32_t next) {\n";
+
+        for (std::uint8_t reg{0}; reg < 16; ++reg) {
+            if (modified & (1 << reg))
+                out << std::format("        V[0x{0:X}] = static_cast<std::uint8_t>(v{0:X});\n", reg);
+        }
+
+        out << "        return executed << 16 | next;\n";
+        out << "    };\n";
+        out << body.str();
+        out << "}\n\n";
+    }
+
+    public:
+        explicit Recompiler(std::vector<std::uint8_t> ROM) :
+            m_ROM{std::move(ROM)},
+            m_finalInstruction{static_cast<std::uint16_t>(kROMOffset + m_ROM.size() - 2)}
+        {
+            findLeaders();
+
+            for (const std::uint16_t leader : m_leaders) {
+                const std::size_t length = blockAt(leader).size();
+
+                if (length != 0)
+                    m_blocks.emplace(leader, leader + length * 2);
+            }
+        }
+
+        void emit(std::ostream& out, std::string_view name) const {
+            out << std::format("// Generated by hotchip-aot from {}, do not edit.\n", name);
+            out << "#include <array>\n";
+            out << "#include <cstdint>\n";
+            out << "#include \"interpreter/aot/AotProgram.h\"\n\n";
+            out << "namespace {\n\n";
+
+            out << std::format("constexpr std::array<std::uint8_t, {}> kROM = {{", m_ROM.size());
+
+            for (std::size_t i{0}; i < m_ROM.size(); ++i)
+                out << (i % 16 == 0 ? "\n    " : " ") << std::format("0x{:02X},", m_ROM[i]);
+
+            out << "\n};\n\n";
+
+            // Blocks call each other directly
+            for (const auto& [start, end] : m_blocks)
+                out << std::format("std::uint32_t block{:03X}(std::uint8_t*, std::uint16_t*, std::uint32_t, const AotBlockTable&);\n", start);
+
+            out << '\n';
+
+            for (const auto& [start, end] : m_blocks)
+                emitBlock(out, start);
+
+            out << std::format("constexpr std::array<AotBlock, {}> kBlocks = {{{{\n", m_blocks.size());
+
+            for (const auto& [start, end] : m_blocks)
+                out << std::format("    {{0x{0:03X}, 0x{1:03X}, block{0:03X}}},\n", start, end);
+
+            out << "}};\n\n";
+            out << std::format("constexpr AotProgram kProgram{{\"{}\", kROM, kBlocks}};\n", name);
+            out << "const AotRegistration kRegistration{kProgram};\n\n";
+            out << "}\n";
+        }
+};
+
+int main(int argc, char** argv) {
+    std::string_view ROMPath;
+    std::string_view outputPath;
+
+    for (int i{1}; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+
+        if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (ROMPath.empty() && !arg.starts_with("-")) {
+            ROMPath = arg;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (ROMPath.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    std::ifstream inFS{std::string{ROMPath}, std::ifstream::binary};
+
+    if (!inFS.is_open()) {
+        std::cerr << "Failed to open ROM: " << ROMPath << std::endl;
+        return 1;
+    }
+
+    std::vector<std::uint8_t> ROM{std::istreambuf_iterator<char>{inFS}, {}};
+
+    if (ROM.size() < 2 || ROM.size() > kMaxROMSize) {
+        std::cerr << "ROM size must be between 2 and 3584 bytes: " << ROMPath << std::endl;
+        return 1;
+    }
+
+    const Recompiler recompiler{std::move(ROM)};
+    const std::string name = std::filesystem::path{ROMPath}.filename().string();
+
+    if (outputPath.empty()) {
+        recompiler.emit(std::cout, name);
+        return 0;
+    }
+
+    std::ofstream outFS{std::string{outputPath}};
+
+    if (!outFS.is_open()) {
+        std::cerr << "Failed to open output: " << outputPath << std::endl;
+        return 1;
+    }
+
+    recompiler.emit(outFS, name);
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include <chrono>
+#include <format>
+#include <memory>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include "../interpreter/Chip8.h"
+#include "../interpreter/Lockstep.h"
+#include "../interpreter/batch/Chip8Batch.h"
+
+/*
+ * hotchip-bench: compare the throughput of the interpreter engines.
+ *
+ * Runs a ROM headless for a number of frames with each engine and
+ * reports frames per second and millions of instructions per second (MIPS).
+ *
+ * With --instances N, N interpreters of the ROM run interleaved a frame at a
+ * time, as a server hosting many sessions on one core would. Frames per second
+ * are then summed over all instances, and the last column gives how many
+ * instances the core could run at 60 frames per second.
+ *
+ * With --batch N, N lanes of the ROM also run in a Chip8Batch, each seeded
+ * with its index, and are checked against as many scalar interpreters
+ * afterwards. Compare with --instances N for the same amount of sessions.
+ *
+ * Usage: hotchip-bench <ROM> [--frames N] [--instances N] [--batch N] [--engine NAME]...
+ */
+
+static constexpr std::uint32_t kDefaultFrames = 100000;
+
+// Each engine is timed several times, the fastest run is reported
+static constexpr int kRuns = 3;
+
+// Frame rate of a CHIP-8 running in real time
+static constexpr double kRealTimeFPS = 60;
+
+static void printUsage() {
+    std::cerr << "Usage: hotchip-bench <ROM> [--frames N] [--instances N] [--batch N] [--engine NAME]..." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string_view ROMPath;
+    std::uint32_t frames = kDefaultFrames;
+    std::uint32_t instanceCount = 1;
+    std::uint32_t laneCount{0};
+    std::vector<Chip8::Engine> engines;
+
+    for (int i{1}; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+
+        if (arg == "--frames" && i + 1 < argc) {
+            frames = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--instances" && i + 1 < argc) {
+            instanceCount = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--batch" && i + 1 < argc) {
+            laneCount = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--engine" && i + 1 < argc) {
+            const std::optional<Chip8::Engine> parsed = Chip8::parseEngine(argv[++i]);
+
+            if (!parsed) {
+                std::cerr << "Unknown engine: " << argv[i] << std::endl;
+                return 1;
+            }
+
+            engines.push_back(*parsed);
+        } else if (ROMPath.empty() && !arg.starts_with("--")) {
+            ROMPath = arg;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (ROMPath.empty() || instanceCount == 0 || laneCount > Chip8Batch::kMaxLanes) {
+        printUsage();
+        return 1;
+    }
+
+    // Benchmark every engine by default
+    if (engines.empty()) {
+        for (std::size_t engine{0}; engine < Chip8::kEngineNames.size(); ++engine)
+            engines.push_back(static_cast<Chip8::Engine>(engine));
+    }
+
+    try {
+        std::cout << std::format(
+            "{:<12} {:>14} {:>10} {:>9} {:>10}\n", "engine", "frames/s", "MIPS", "speedup", "60Hz/core"
+        );
+
+        double baselineMIPS{0};
+
+        for (const Chip8::Engine engine : engines) {
+            double bestSeconds{0};
+            std::uint64_t instructions{0};
+
+            for (int run{0}; run < kRuns; ++run) {
+                std::vector<std::unique_ptr<Chip8>> instances;
+
+                for (std::uint32_t instance{0}; instance < instanceCount; ++instance) {
+                    instances.push_back(std::make_unique<Chip8>(ROMPath));
+                    instances.back()->setEngine(engine);
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+
+                if (instanceCount == 1) {
+                    instances.front()->step(frames);
+                } else {
+                    for (std::uint32_t frame{0}; frame < frames; ++frame) {
+                        for (const std::unique_ptr<Chip8>& interpreter : instances)
+                            interpreter->step();
+                    }
+                }
+
+                const double seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start
+                ).count();
+
+                if (run == 0 || seconds < bestSeconds)
+                    bestSeconds = seconds;
+
+                instructions = 0;
+
+                for (const std::unique_ptr<Chip8>& interpreter : instances)
+                    instructions += interpreter->getInstructionCount();
+            }
+
+            const double framesPerSecond = static_cast<double>(frames) * instanceCount / bestSeconds;
+
+            const double MIPS = static_cast<double>(instructions) / bestSeconds / 1e6;
+
+            // Speedups are relative to the first engine benchmarked
+            if (baselineMIPS == 0)
+                baselineMIPS = MIPS;
+
+            std::cout << std::format(
+                "{:<12} {:>14.0f} {:>10.2f} {:>8.2f}x {:>10.0f}\n",
+                Chip8::kEngineNames[static_cast<std::size_t>(engine)],
+                framesPerSecond, MIPS, MIPS / baselineMIPS, framesPerSecond / kRealTimeFPS
+            );
+        }
+
+        if (laneCount != 0) {
+            const Chip8 ROM{ROMPath};
+            double bestSeconds{0};
+            std::unique_ptr<Chip8Batch> batch;
+
+            for (int run{0}; run < kRuns; ++run) {
+                batch = std::make_unique<Chip8Batch>(ROM, laneCount);
+
+                for (std::uint32_t lane{0}; lane < laneCount; ++lane)
+                    batch->setRandomSeed(lane, lane + 1);
+
+                const auto start = std::chrono::steady_clock::now();
+                batch->step(frames);
+
+                const double seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start
+                ).count();
+
+                if (run == 0 || seconds < bestSeconds)
+                    bestSeconds = seconds;
+            }
+
+            const Chip8Batch::Statistics& statistics = batch->getStatistics();
+            const double framesPerSecond = static_cast<double>(frames) * laneCount / bestSeconds;
+            const double MIPS = static_cast<double>(statistics.instructions) / bestSeconds / 1e6;
+
+            if (baselineMIPS == 0)
+                baselineMIPS = MIPS;
+
+            std::cout << std::format(
+                "{:<12} {:>14.0f} {:>10.2f} {:>8.2f}x {:>10.0f}\n",
+                std::format("batch x{}", laneCount),
+                framesPerSecond, MIPS, MIPS / baselineMIPS, framesPerSecond / kRealTimeFPS
+            );
+
+            // How many lanes ran each instruction together, laneCount unless they diverged
+            std::cout << std::format(
+                "{:.2f} lanes per instruction\n",
+                statistics.groups != 0
+                    ? static_cast<double>(statistics.instructions) / static_cast<double>(statistics.groups) : 0.0
+            );
+
+            // Every lane must end as a scalar interpreter of the same seed does
+            const auto expected = std::make_unique<SaveState>();
+            const auto actual = std::make_unique<SaveState>();
+            std::uint32_t differed{0};
+
+            for (std::uint32_t lane{0}; lane < laneCount; ++lane) {
+                Chip8 chip8 = ROM.fork();
+                chip8.setRandomSeed(lane + 1);
+                chip8.step(frames);
+
+                chip8.saveState(*expected);
+                batch->saveState(lane, *actual);
+
+                if (hashSaveState(*expected) != hashSaveState(*actual))
+                    ++differed;
+            }
+
+            if (differed != 0) {
+                std::cout << std::format("{} of {} lanes differed from a scalar interpreter", differed, laneCount) << std::endl;
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <string_view>
+#include "../interpreter/Chip8.h"
+#include "../interpreter/InstanceRunner.h"
+
+/*
+ * hotchip-farm: run thousands of headless instances on every core, and
+ * report how throughput scales with the amount of threads.
+ *
+ * Instances are dealt round-robin over the ROMs given, so ROMs of uneven
+ * cost (e.g. one waiting for a key, one drawing every frame) share the
+ * threads, balanced by work stealing (see InstanceRunner). Each amount of
+ * threads runs fresh instances, seeded with --seed plus their index, and
+ * their final states must match the first run's.
+ *
+ * Usage: hotchip-farm <ROM>... [--instances N] [--frames N] [--threads N]...
+ *                    [--batch N] [--engine NAME] [--seed N]
+ *
+ * --threads may be repeated, by default 1, 2, 4... up to the hardware's threads.
+ * --batch sets the frames a task runs an instance for before re-queueing it.
+ */
+
+static constexpr std::uint32_t kDefaultInstances = 1024;
+static constexpr std::uint32_t kDefaultFrames = 600;
+
+// Each amount of threads is timed several times, the fastest run is reported
+static constexpr int kRuns = 3;
+
+// Frame rate of a CHIP-8 running in real time
+static constexpr double kRealTimeFPS = 60;
+
+static void printUsage() {
+    std::cerr << "Usage: hotchip-farm <ROM>... [--instances N] [--frames N] [--threads N]... "
+                 "[--batch N] [--engine NAME] [--seed N]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string_view> ROMPaths;
+    std::uint32_t instanceCount = kDefaultInstances;
+    std::uint32_t frames = kDefaultFrames;
+    std::vector<std::uint32_t> threadCounts;
+    std::uint32_t batchFrames = InstanceRunner::kDefaultBatchFrames;
+    Chip8::Engine engine = Chip8::Engine::PreDecoded;
+    std::uint32_t seed{1};
+
+    for (int i{1}; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+
+        if (arg == "--instances" && i + 1 < argc) {
+            instanceCount = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frames = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadCounts.push_back(static_cast<std::uint32_t>(std::stoul(argv[++i])));
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batchFrames = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--engine" && i + 1 < argc) {
+            const std::optional<Chip8::Engine> parsed = Chip8::parseEngine(argv[++i]);
+
+            if (!parsed) {
+                std::cerr << "Unknown engine: " << argv[i] << std::endl;
+                return 1;
+            }
+
+            engine = *parsed;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (!arg.starts_with("--")) {
+            ROMPaths.push_back(arg);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (ROMPaths.empty() || instanceCount == 0 || std::ranges::count(threadCounts, 0u) != 0) {
+        printUsage();
+        return 1;
+    }
+
+    // Powers of two up to every hardware thread by default
+    if (threadCounts.empty()) {
+        const std::uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (std::uint32_t threads{1}; threads < hardwareThreads; threads *= 2)
+            threadCounts.push_back(threads);
+
+        threadCounts.push_back(hardwareThreads);
+    }
+
+    std::ranges::sort(threadCounts);
+
+    try {
+        // One loaded machine per ROM, forked into the instances
+        std::vector<std::unique_ptr<Chip8>> ROMs;
+
+        for (const std::string_view ROMPath : ROMPaths) {
+            ROMs.push_back(std::make_unique<Chip8>(ROMPath));
+            ROMs.back()->setEngine(engine);
+        }
+
+        std::cout << std::format(
+            "{} instances of {} ROMs, {} frames in batches of {}\n",
+            instanceCount, ROMPaths.size(), frames, batchFrames
+        );
+        std::cout << std::format(
+            "{:>8} {:>14} {:>9} {:>11} {:>10} {:>10}\n",
+            "threads", "frames/s", "speedup", "efficiency", "steals", "60Hz"
+        );
+
+        std::vector<std::uint64_t> expectedHashes;
+        std::vector<std::chrono::nanoseconds> ROMTimes(ROMs.size());
+        std::vector<std::uint64_t> ROMFrames(ROMs.size());
+        double baselineFramesPerSecond{0};
+        bool differed = false;
+
+        for (const std::uint32_t threads : threadCounts) {
+            InstanceRunner runner{threads};
+            runner.setBatchFrames(batchFrames);
+
+            double bestSeconds{0};
+            std::uint64_t totalFrames{0};
+            std::uint64_t steals{0};
+
+            for (int run{0}; run < kRuns; ++run) {
+                std::vector<std::unique_ptr<Chip8>> instances;
+                std::vector<Chip8*> machines;
+
+                for (std::uint32_t instance{0}; instance < instanceCount; ++instance) {
+                    instances.push_back(std::make_unique<Chip8>(ROMs[instance % ROMs.size()]->fork()));
+                    instances.back()->setRandomSeed(seed + instance);
+                    machines.push_back(instances.back().get());
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                runner.run(machines, frames);
+
+                const double seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start
+                ).count();
+
+                totalFrames = 0;
+
+                for (std::uint32_t instance{0}; instance < instanceCount; ++instance) {
+                    const InstanceRunner::Result& result = runner.getResults()[instance];
+                    totalFrames += result.frames;
+
+                    // Instances are the same whatever the threads, their final states too
+                    if (expectedHashes.size() < instanceCount) {
+                        expectedHashes.push_back(result.hash);
+                        ROMTimes[instance % ROMs.size()] += result.time;
+                        ROMFrames[instance % ROMs.size()] += result.frames;
+                    } else if (result.hash != expectedHashes[instance]) {
+                        differed = true;
+                    }
+                }
+
+                if (run == 0 || seconds < bestSeconds) {
+                    bestSeconds = seconds;
+                    steals = 0;
+
+                    for (std::uint32_t thread{0}; thread < threads; ++thread)
+                        steals += runner.getStatistics(thread).steals;
+                }
+            }
+
+            const double framesPerSecond = static_cast<double>(totalFrames) / bestSeconds;
+
+            // Speedups are relative to one thread of the fewest
+            if (baselineFramesPerSecond == 0)
+                baselineFramesPerSecond = framesPerSecond / threadCounts.front();
+
+            const double speedup = framesPerSecond / baselineFramesPerSecond;
+
+            std::cout << std::format(
+                "{:>8} {:>14.0f} {:>8.2f}x {:>10.0f}% {:>10} {:>10.0f}\n",
+                threads, framesPerSecond, speedup, speedup / threads * 100, steals, framesPerSecond / kRealTimeFPS
+            );
+        }
+
+        // The uneven costs being balanced
+        std::cout << '\n';
+
+        for (std::size_t ROM{0}; ROM < ROMs.size(); ++ROM) {
+            const double microseconds = std::chrono::duration<double, std::micro>(ROMTimes[ROM]).count();
+
+            std::cout << std::format(
+                "{}: {:.2f} us per frame\n", ROMPaths[ROM],
+                ROMFrames[ROM] != 0 ? microseconds / static_cast<double>(ROMFrames[ROM]) : 0.0
+            );
+        }
+
+        if (differed) {
+            std::cout << "Final states differed between amounts of threads" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,343 @@
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <iterator>
+#include <filesystem>
+#include <string_view>
+#include "../interpreter/Chip8.h"
+#include "../interpreter/Fuzzer.h"
+#include "../interpreter/InputMovie.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+/*
+ * hotchip-fuzz: coverage-guided fuzzing of the interpreter and ROMs.
+ *
+ * Mutates the seed ROMs, and the keys held on each of the frames they run
+ * for, keeping mutations which execute a (PC, opcode) pair no input
+ * executed before (see Fuzzer.h). Every thread runs its own mutations on the
+ * decode engine, sharing the coverage map and corpus.
+ *
+ * Reported, and saved to the output directory as <kind>-<n>.ch8 with the
+ * keys in <kind>-<n>.movie (replay with hotchip-run's --play-movie):
+ *   crash           the interpreter threw an exception
+ *   stack-overflow  CALL with a full stack
+ *   empty-return    RETURN with an empty stack
+ *   out-of-bounds   a memory access outside of memory (checked bounds builds)
+ *   divergence      another engine ended differently than the decode engine
+ * The corpus, inputs which reached new coverage, is saved to corpus/ in the
+ * output directory once fuzzing ends.
+ *
+ * A run which doesn't finish within --timeout milliseconds is saved as a
+ * hang and ends fuzzing, as does a fatal signal, which saves the ROM only.
+ * Fuzzing runs until --executions have run, or until interrupted (Ctrl+C).
+ * Exits with 1 if the interpreter crashed, hung or diverged.
+ *
+ * Usage: hotchip-fuzz <ROM>... [--frames N] [--executions N] [--threads N]
+ *                     [--seed N] [--output DIR] [--timeout MS]
+ */
+
+static constexpr std::uint32_t kDefaultFrames = 10;
+static constexpr std::uint32_t kDefaultTimeout = 1000;
+
+// How often progress is printed, and hangs looked for
+static constexpr auto kReportInterval = std::chrono::seconds{5};
+static constexpr auto kPollInterval = std::chrono::milliseconds{100};
+
+static void printUsage() {
+    std::cerr << "Usage: hotchip-fuzz <ROM>... [--frames N] [--executions N] [--threads N] "
+                 "[--seed N] [--output DIR] [--timeout MS]" << std::endl;
+}
+
+// Set by Ctrl+C, to stop at the next input and report
+static std::atomic<bool> interrupted{false};
+
+static void onInterrupt(int) {
+    interrupted.store(true, std::memory_order_relaxed);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// The worker running on this thread, and where a fatal signal saves its ROM
+static thread_local const FuzzWorker* currentWorker = nullptr;
+static std::string signalPath;
+
+// Only async-signal-safe calls: the ROM is written as is, then the signal handled as it would have been
+static void onFatalSignal(int signal) {
+    if (currentWorker != nullptr) {
+        const std::vector<std::uint8_t>& ROM = currentWorker->getInput().ROM;
+        const int file = ::open(signalPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (file >= 0) {
+            [[maybe_unused]] const auto written = ::write(file, ROM.data(), ROM.size());
+            ::close(file);
+        }
+    }
+
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+#endif
+
+static std::vector<std::uint8_t> readROM(const std::string& path) {
+    std::ifstream file{path, std::ifstream::binary};
+
+    if (!file)
+        throw std::runtime_error("Error opening ROM: " + path);
+
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+/*
+ * Write input's ROM to <path>.ch8 and its keys to <path>.movie. The movie
+ * starts from the ROM's reset with the input's seed, and holds the keys of
+ * each frame as presses and releases.
+ */
+static void saveInput(const std::string& path, const FuzzInput& input) {
+    std::ofstream file{path + ".ch8", std::ofstream::binary};
+    file.write(reinterpret_cast<const char*>(input.ROM.data()), static_cast<std::streamsize>(input.ROM.size()));
+
+    if (!file)
+        throw std::runtime_error("Error writing " + path + ".ch8");
+
+    HeadlessFrontend frontend;
+    Chip8 chip8{frontend};
+    chip8.openROM(input.ROM);
+    chip8.setRandomSeed(input.seed);
+
+    Movie movie = MovieRecorder{chip8}.getMovie();
+    std::uint16_t held{0};
+
+    for (std::uint64_t frame{0}; frame < input.keys.size(); ++frame) {
+        for (std::uint8_t key{0}; key < 16; ++key) {
+            if ((held ^ input.keys[frame]) >> key & 1)
+                movie.events.push_back({frame, key, (input.keys[frame] >> key & 1) != 0});
+        }
+
+        held = input.keys[frame];
+    }
+
+    movie.frameCount = input.keys.size();
+    writeMovieFile(path + ".movie", movie);
+}
+
+// What every thread reports, written by its own thread only
+struct alignas(64) WorkerProgress {
+    std::atomic<std::uint64_t> executions{0};
+    std::atomic<bool> done{false};
+};
+
+int main(int argc, char** argv) {
+    std::vector<std::string> ROMPaths;
+    std::uint32_t frames = kDefaultFrames;
+    std::uint64_t executions{0};
+    std::uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::uint32_t seed{1};
+    std::filesystem::path output{"findings"};
+    std::uint32_t timeout = kDefaultTimeout;
+
+    for (int i{1}; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+
+        if (arg == "--frames" && i + 1 < argc) {
+            frames = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--executions" && i + 1 < argc) {
+            executions = std::stoull(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadCount = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--timeout" && i + 1 < argc) {
+            timeout = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (!arg.starts_with("--")) {
+            ROMPaths.emplace_back(arg);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (ROMPaths.empty() || frames == 0 || threadCount == 0 || timeout == 0) {
+        printUsage();
+        return 1;
+    }
+
+    try {
+        std::filesystem::create_directories(output / "corpus");
+
+        FuzzCorpus corpus{frames};
+        std::vector<std::unique_ptr<FuzzWorker>> workers;
+
+        for (std::uint32_t worker{0}; worker < threadCount; ++worker)
+            workers.push_back(std::make_unique<FuzzWorker>(corpus, seed + worker));
+
+        // Findings of each kind so far, numbering their files
+        std::array<std::atomic<std::uint32_t>, kFuzzFindingNames.size()> findings{};
+        std::mutex outputMutex;
+
+        const auto report = [&](const FuzzWorker& worker, const FuzzResult& result) {
+            for (std::size_t kind{0}; kind < kFuzzFindingNames.size(); ++kind) {
+                if ((result.findings >> kind & 1) == 0)
+                    continue;
+
+                const std::string name = std::format(
+                    "{}-{}", kFuzzFindingNames[kind], findings[kind].fetch_add(1, std::memory_order_relaxed)
+                );
+
+                saveInput((output / name).string(), worker.getInput());
+
+                const std::scoped_lock lock{outputMutex};
+                std::cout << std::format("{}{}{}", name, result.error.empty() ? "" : ": ", result.error) << std::endl;
+            }
+        };
+
+        // Seeds run with no keys held, and join the corpus if they reach anything new
+        for (const std::string& path : ROMPaths) {
+            const FuzzInput input{readROM(path), std::vector<std::uint16_t>(frames, 0), seed};
+
+            if (input.ROM.size() > 0xE00)
+                throw std::runtime_error("ROM size exceeds maximum of 3584 bytes: " + path);
+
+            report(*workers.front(), workers.front()->run(input));
+        }
+
+        if (corpus.getSize() == 0)
+            throw std::runtime_error("No seed ROM executed an instruction");
+
+        std::signal(SIGINT, onInterrupt);
+
+#if defined(__unix__) || defined(__APPLE__)
+        signalPath = (output / "crash-signal.ch8").string();
+
+        for (const int signal : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT})
+            std::signal(signal, onFatalSignal);
+#endif
+
+        std::vector<WorkerProgress> progress(threadCount);
+        std::vector<std::thread> threads;
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint32_t index{0}; index < threadCount; ++index) {
+            // The executions are shared out evenly, the first threads running any remainder
+            const std::uint64_t share = executions / threadCount + (index < executions % threadCount ? 1 : 0);
+
+            threads.emplace_back([&, index, share] {
+                FuzzWorker& worker = *workers[index];
+                std::atomic<std::uint64_t>& executed = progress[index].executions;
+
+#if defined(__unix__) || defined(__APPLE__)
+                currentWorker = &worker;
+#endif
+
+                try {
+                    for (std::uint64_t run{0}; (executions == 0 || run < share) && !interrupted.load(std::memory_order_relaxed); ++run) {
+                        const FuzzResult result = worker.fuzz();
+                        executed.store(run + 1, std::memory_order_relaxed);
+
+                        if (result.findings != 0)
+                            report(worker, result);
+                    }
+                } catch (const std::exception& e) {
+                    const std::scoped_lock lock{outputMutex};
+                    std::cerr << e.what() << std::endl;
+                }
+
+                progress[index].done.store(true, std::memory_order_release);
+            });
+        }
+
+        const auto totalExecutions = [&] {
+            std::uint64_t total{0};
+
+            for (const WorkerProgress& worker : progress)
+                total += worker.executions.load(std::memory_order_relaxed);
+
+            return total;
+        };
+
+        const auto printProgress = [&] {
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            const std::uint64_t total = totalExecutions();
+            std::string line = std::format(
+                "{:>8.1f}s {:>12} runs {:>10.0f}/s  corpus {:>6}  coverage {:>7}",
+                seconds, total, static_cast<double>(total) / seconds, corpus.getSize(), corpus.getCoverage()
+            );
+
+            for (std::size_t kind{0}; kind < kFuzzFindingNames.size(); ++kind)
+                line += std::format("  {} {}", kFuzzFindingNames[kind], findings[kind].load(std::memory_order_relaxed));
+
+            const std::scoped_lock lock{outputMutex};
+            std::cout << line << std::endl;
+        };
+
+        // A thread whose executions haven't moved on for the timeout is hung in one
+        std::vector<std::uint64_t> lastExecutions(threadCount, 0);
+        std::vector<std::chrono::steady_clock::time_point> lastProgress(threadCount, start);
+        auto lastReport = start;
+
+        for (bool running{true}; running;) {
+            std::this_thread::sleep_for(kPollInterval);
+
+            const auto now = std::chrono::steady_clock::now();
+            running = false;
+
+            for (std::uint32_t index{0}; index < threadCount; ++index) {
+                if (progress[index].done.load(std::memory_order_acquire))
+                    continue;
+
+                running = true;
+                const std::uint64_t executed = progress[index].executions.load(std::memory_order_relaxed);
+
+                if (executed != lastExecutions[index]) {
+                    lastExecutions[index] = executed;
+                    lastProgress[index] = now;
+                } else if (now - lastProgress[index] > std::chrono::milliseconds{timeout}) {
+                    // The hung thread can't be stopped, its input is saved and the process ended
+                    saveInput((output / "hang-0").string(), workers[index]->getRunningInput());
+                    printProgress();
+                    std::cout << "hang-0: no progress in " << timeout << " ms" << std::endl;
+                    std::_Exit(1);
+                }
+            }
+
+            if (now - lastReport >= kReportInterval) {
+                lastReport = now;
+                printProgress();
+            }
+        }
+
+        for (std::thread& thread : threads)
+            thread.join();
+
+        printProgress();
+
+        std::vector<FuzzInput> inputs;
+        corpus.copyInputs(0, inputs);
+
+        for (std::size_t input{0}; input < inputs.size(); ++input)
+            saveInput((output / "corpus" / std::to_string(input)).string(), inputs[input]);
+
+        const std::uint32_t interpreterErrors =
+            findings[static_cast<std::size_t>(FuzzFinding::Crash)].load() + findings[static_cast<std::size_t>(FuzzFinding::Divergence)].load();
+
+        return interpreterErrors != 0 ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,325 @@
+#include <format>
+#include <limits>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include "../interpreter/Chip8.h"
+#include "../interpreter/Lockstep.h"
+#include "../interpreter/InputMovie.h"
+
+/*
+ * hotchip-lockstep: prove engines bit-exact by differential execution.
+ *
+ * Runs every ROM given with the reference engine (--engine, decode by default)
+ * in lockstep with each engine to check (--against, every other engine by
+ * default), on the same input, comparing their complete state after every
+ * frame, or every instruction with --every-instruction (see Lockstep.h).
+ * Stops at the first divergence and reports the frame, instruction, PC and
+ * opcode where it happened. Exits with 1 if any engine diverged.
+ *
+ * Usage: hotchip-lockstep <ROM>... [--frames N] [--engine NAME] [--against NAME]...
+ *                         [--seed N] [--play-movie FILE] [--every-instruction]
+ *                         [--write-hashes FILE | --check-hashes FILE]
+ *
+ * Input comes from a movie recorded by the desktop frontend (--play-movie),
+ * otherwise keys are pressed and released at random, the same for every engine.
+ * --seed seeds both the input and the random numbers of CXNN.
+ *
+ * Builds (e.g. debug against release, or two compilers) are compared by
+ * running one ROM with --write-hashes in one build and --check-hashes with the
+ * file in the other, with the same options. The file holds the rolling state
+ * hash at every comparison.
+ */
+
+// Default amount of frames to compare (10 seconds of emulated time)
+static constexpr std::uint64_t kDefaultFrames = 600;
+
+// Without a movie, a random key is pressed or released on average every 8 frames
+static constexpr std::uint8_t kKeyEventChance = 256 / 8;
+
+static void printUsage() {
+    std::cerr << "Usage: hotchip-lockstep <ROM>... [--frames N] [--engine NAME] [--against NAME]... "
+                 "[--seed N] [--play-movie FILE] [--every-instruction] "
+                 "[--write-hashes FILE | --check-hashes FILE]" << std::endl;
+}
+
+// Input and length of a run, the same for each machine
+struct RunSettings {
+    std::optional<std::uint64_t> frames;
+    std::uint32_t seed{1};
+    const Movie* movie{nullptr};
+};
+
+/*
+ * Emulate machine, and other if not null, through lockstep until the
+ * frames are done or they diverge. framesRun is set to the frames compared.
+ */
+static std::optional<Lockstep::Divergence> runLockstep(
+    Lockstep& lockstep, Chip8& machine, Chip8* other, const RunSettings& settings, std::uint64_t& framesRun
+) {
+    std::optional<MoviePlayer> player;
+    std::optional<MoviePlayer> otherPlayer;
+
+    Xorshift32 input{settings.seed};
+    std::uint16_t keyStates{0};
+
+    // Movies start from their own state, including the random numbers
+    if (settings.movie) {
+        player.emplace(*settings.movie, machine);
+
+        if (other)
+            otherPlayer.emplace(*settings.movie, *other);
+    } else {
+        machine.setRandomSeed(settings.seed);
+
+        if (other)
+            other->setRandomSeed(settings.seed);
+    }
+
+    // Movies run to their end, checks of recorded hashes to the end of the hashes
+    std::uint64_t frames = settings.frames.value_or(kDefaultFrames);
+
+    if (!settings.frames && settings.movie)
+        frames = settings.movie->frameCount;
+    else if (!settings.frames && lockstep.hasExpectedHashes())
+        frames = std::numeric_limits<std::uint64_t>::max();
+
+    for (framesRun = 0; framesRun < frames; ++framesRun) {
+        if (frames == std::numeric_limits<std::uint64_t>::max() && !lockstep.hasExpectedHashes())
+            break;
+
+        if (player) {
+            player->beginFrame(machine);
+
+            if (otherPlayer)
+                otherPlayer->beginFrame(*other);
+        } else if (input.nextByte() < kKeyEventChance) {
+            const auto key = static_cast<std::uint8_t>(input.next() >> 28);
+            const bool pressed = (keyStates >> key & 1) == 0;
+
+            keyStates ^= static_cast<std::uint16_t>(1 << key);
+            lockstep.setKeyState(key, pressed);
+        }
+
+        if (std::optional<Lockstep::Divergence> divergence = lockstep.step())
+            return divergence;
+    }
+
+    return std::nullopt;
+}
+
+static std::string describeDivergence(const Lockstep::Divergence& divergence) {
+    if (divergence.instruction == 0 && divergence.part == "unknown") {
+        return std::format(
+            "diverged in frame {} (which started at PC {:03X}, opcode {:04X})",
+            divergence.frame, divergence.PC, divergence.opcode
+        );
+    }
+
+    if (divergence.instruction == 0)
+        return std::format("diverged at the end of frame {}, {} differ", divergence.frame, divergence.part);
+
+    std::string description = std::format(
+        "diverged in frame {} at instruction {} of the frame, PC {:03X} opcode {:04X}",
+        divergence.frame, divergence.instruction, divergence.PC, divergence.opcode
+    );
+
+    if (divergence.part != "unknown")
+        description += std::format(", {} differ", divergence.part);
+
+    return description;
+}
+
+// Hashes as 64 bit little-endian words
+static void writeHashFile(const std::string& path, std::span<const std::uint64_t> hashes) {
+    std::vector<char> data;
+    data.reserve(hashes.size() * 8);
+
+    for (const std::uint64_t hash : hashes) {
+        for (int byte{0}; byte < 8; ++byte)
+            data.push_back(static_cast<char>(hash >> byte * 8));
+    }
+
+    std::ofstream outFS{path, std::ofstream::binary | std::ofstream::trunc};
+    outFS.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+    if (!outFS)
+        throw std::runtime_error("Error writing hashes: " + path);
+}
+
+static std::vector<std::uint64_t> readHashFile(const std::string& path) {
+    std::ifstream inFS{path, std::ifstream::binary};
+
+    if (!inFS.is_open())
+        throw std::runtime_error("Error opening hashes: " + path);
+
+    const std::vector<std::uint8_t> data{std::istreambuf_iterator<char>{inFS}, std::istreambuf_iterator<char>{}};
+
+    if (data.size() % 8 != 0)
+        throw std::runtime_error("Corrupt hashes: " + path);
+
+    std::vector<std::uint64_t> hashes(data.size() / 8);
+
+    for (std::size_t hash{0}; hash < hashes.size(); ++hash) {
+        for (int byte{0}; byte < 8; ++byte)
+            hashes[hash] |= static_cast<std::uint64_t>(data[hash * 8 + byte]) << byte * 8;
+    }
+
+    return hashes;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string_view> ROMPaths;
+    Chip8::Engine engine = Chip8::Engine::Decode;
+    std::vector<Chip8::Engine> candidates;
+    Lockstep::Granularity granularity = Lockstep::Granularity::Frame;
+    RunSettings settings;
+    std::string moviePath;
+    std::string writeHashesPath;
+    std::string checkHashesPath;
+
+    for (int i{1}; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+
+        if ((arg == "--engine" || arg == "--against") && i + 1 < argc) {
+            const std::optional<Chip8::Engine> parsed = Chip8::parseEngine(argv[++i]);
+
+            if (!parsed) {
+                std::cerr << "Unknown engine: " << argv[i] << std::endl;
+                return 1;
+            }
+
+            if (arg == "--engine")
+                engine = *parsed;
+            else
+                candidates.push_back(*parsed);
+        } else if (arg == "--frames" && i + 1 < argc) {
+            settings.frames = std::stoull(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            settings.seed = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--play-movie" && i + 1 < argc) {
+            moviePath = argv[++i];
+        } else if (arg == "--every-instruction") {
+            granularity = Lockstep::Granularity::Instruction;
+        } else if (arg == "--write-hashes" && i + 1 < argc) {
+            writeHashesPath = argv[++i];
+        } else if (arg == "--check-hashes" && i + 1 < argc) {
+            checkHashesPath = argv[++i];
+        } else if (!arg.starts_with("--")) {
+            ROMPaths.push_back(arg);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    // Movies and hashes belong to one ROM, hashes to one engine
+    const bool hashes = !writeHashesPath.empty() || !checkHashesPath.empty();
+
+    if (ROMPaths.empty() || (ROMPaths.size() > 1 && (!moviePath.empty() || hashes))
+        || (hashes && !candidates.empty()) || (!writeHashesPath.empty() && !checkHashesPath.empty())) {
+        printUsage();
+        return 1;
+    }
+
+    // Every other engine by default
+    if (candidates.empty() && !hashes) {
+        for (std::size_t candidate{0}; candidate < Chip8::kEngineNames.size(); ++candidate) {
+            if (static_cast<Chip8::Engine>(candidate) != engine)
+                candidates.push_back(static_cast<Chip8::Engine>(candidate));
+        }
+    }
+
+    const std::string_view engineName = Chip8::kEngineNames[static_cast<std::size_t>(engine)];
+    bool diverged = false;
+
+    try {
+        std::optional<Movie> movie;
+
+        if (!moviePath.empty()) {
+            movie = readMovieFile(moviePath);
+            settings.movie = &*movie;
+        }
+
+        if (hashes) {
+            const std::vector<std::uint64_t> expectedHashes =
+                checkHashesPath.empty() ? std::vector<std::uint64_t>{} : readHashFile(checkHashesPath);
+
+            Chip8 machine{ROMPaths.front()};
+            machine.setEngine(engine);
+
+            Lockstep lockstep{machine, expectedHashes, granularity};
+            lockstep.recordHashes();
+
+            std::uint64_t frames{0};
+            const std::optional<Lockstep::Divergence> divergence = runLockstep(
+                lockstep, machine, nullptr, settings, frames
+            );
+
+            if (divergence) {
+                std::cout << std::format(
+                    "{}: {} {} from the recorded hashes\n", ROMPaths.front(), engineName,
+                    describeDivergence(*divergence)
+                );
+                return 1;
+            }
+
+            if (!writeHashesPath.empty()) {
+                writeHashFile(writeHashesPath, lockstep.getHashes());
+                std::cout << std::format(
+                    "{}: {} recorded {} hashes of {} frames (hash {:016X})\n", ROMPaths.front(), engineName,
+                    lockstep.getHashes().size(), frames, lockstep.getHash()
+                );
+            } else {
+                std::cout << std::format(
+                    "{}: {} matches {} of {} recorded hashes for {} frames (hash {:016X})\n",
+                    ROMPaths.front(), engineName, std::min(lockstep.getHashes().size(), expectedHashes.size()),
+                    expectedHashes.size(), frames, lockstep.getHash()
+                );
+            }
+
+            return 0;
+        }
+
+        for (const std::string_view ROMPath : ROMPaths) {
+            for (const Chip8::Engine candidate : candidates) {
+                Chip8 machine{ROMPath};
+                machine.setEngine(engine);
+
+                Chip8 other{ROMPath};
+                other.setEngine(candidate);
+
+                Lockstep lockstep{machine, other, granularity};
+
+                std::uint64_t frames{0};
+                const std::optional<Lockstep::Divergence> divergence = runLockstep(
+                    lockstep, machine, &other, settings, frames
+                );
+
+                const std::string_view candidateName = Chip8::kEngineNames[static_cast<std::size_t>(candidate)];
+
+                if (divergence) {
+                    std::cout << std::format(
+                        "{}: {} and {} {}\n", ROMPath, engineName, candidateName, describeDivergence(*divergence)
+                    );
+                    diverged = true;
+                } else {
+                    std::cout << std::format(
+                        "{}: {} and {} identical for {} frames (hash {:016X})\n",
+                        ROMPath, engineName, candidateName, frames, lockstep.getHash()
+                    );
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return diverged ? 1 : 0;
+}
@@ -0,0 +1,267 @@
+#include <span>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <iostream>
+#include <string_view>
+#include "../interpreter/Chip8.h"
+#include "../interpreter/Lockstep.h"
+#include "../interpreter/netplay/UdpTransport.h"
+#include "../interpreter/netplay/RollbackSession.h"
+
+/*
+ * hotchip-netplay: play a ROM over rollback netplay headless, in real time,
+ * with random keys, to test sessions between two processes or machines.
+ *
+ * Usage: hotchip-netplay <ROM> --player 1|2 --port N --peer HOST:PORT [options]
+ *        hotchip-netplay <ROM> --loopback [--port N] [options]
+ *
+ * Options: [--frames N] [--input-delay N] [--latency MS] [--loss PERCENT]
+ *          [--keys MASK] [--engine NAME]
+ *
+ * --loopback plays both players in this process over UDP on 127.0.0.1,
+ * ports N and N + 1 (7000 by default), and checks their final states match.
+ * --latency and --loss delay and drop the packets sent (see DelayedTransport),
+ * --keys limits the keys pressed to a mask, e.g. 0x0012 for keys 1 and 4.
+ *
+ * Prints the rollbacks made, the longest one (which must fit in a 60 Hz
+ * frame) and a hash of the final state, equal for both players.
+ */
+
+// Default amount of frames to play (10 seconds)
+static constexpr std::uint32_t kDefaultFrames = 600;
+
+// Frames to keep answering the other player after the last one, so it can finish too
+static constexpr std::uint32_t kLingerFrames = 30;
+
+// A random key is pressed or released on average every 8 frames
+static constexpr std::uint8_t kKeyEventChance = 256 / 8;
+
+static constexpr auto kFrameDuration = std::chrono::duration<double>(1.0 / 60.0);
+
+static void printUsage() {
+    std::cerr << "Usage: hotchip-netplay <ROM> (--player 1|2 --port N --peer HOST:PORT | --loopback [--port N]) "
+                 "[--frames N] [--input-delay N] [--latency MS] [--loss PERCENT] [--keys MASK] [--engine NAME]"
+              << std::endl;
+}
+
+// One player's machine, connection and random keys
+struct Player {
+    Chip8 chip8;
+    UdpTransport socket;
+    DelayedTransport transport;
+    RollbackSession session;
+    Xorshift32 input;
+    std::uint16_t keyMask;
+    std::uint16_t keys{0};
+
+    Player(
+        std::string_view ROMPath, std::optional<Chip8::Engine> engine, std::uint8_t player, std::uint16_t port,
+        const std::string& peerHost, std::uint16_t peerPort, std::chrono::milliseconds latency,
+        double loss, std::uint32_t inputDelay, std::uint16_t keyMask
+    )
+        : chip8{ROMPath}
+        , socket{port, peerHost, peerPort}
+        , transport{socket, latency, loss}
+        , session{chip8, transport, player, inputDelay}
+        , input{static_cast<std::uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count()) + player}
+        , keyMask{keyMask}
+    {
+        if (engine)
+            chip8.setEngine(*engine);
+    }
+
+    // Press or release a random key of the mask now and then
+    void pressRandomKeys() {
+        if (keyMask == 0 || input.nextByte() >= kKeyEventChance)
+            return;
+
+        std::uint8_t key = input.next() >> 28;
+
+        while ((keyMask >> key & 1) == 0)
+            key = (key + 1) & 0xF;
+
+        keys ^= static_cast<std::uint16_t>(1 << key);
+        session.setKeyState(key, (keys >> key & 1) != 0);
+    }
+};
+
+static std::uint64_t hashState(const Chip8& chip8) {
+    SaveState state;
+    chip8.saveState(state);
+    return hashSaveState(state);
+}
+
+/*
+ * Play frames in real time: connect, run frames (stalling when a player is
+ * behind) and settle until every frame is confirmed. Players are paced
+ * together, each call of the loop being one 60 Hz frame.
+ */
+static void play(std::span<Player* const> players, std::uint32_t frames) {
+    auto frameEnd = std::chrono::steady_clock::now();
+    std::uint32_t lingered{0};
+
+    const auto waitForFrame = [&] {
+        frameEnd += std::chrono::duration_cast<std::chrono::steady_clock::duration>(kFrameDuration);
+        std::this_thread::sleep_until(frameEnd);
+    };
+
+    while (true) {
+        bool connected = true;
+
+        for (Player* player : players)
+            connected = player->session.connect() && connected;
+
+        if (connected)
+            break;
+
+        waitForFrame();
+    }
+
+    while (lingered < kLingerFrames) {
+        bool settled = true;
+
+        for (Player* player : players) {
+            RollbackSession& session = player->session;
+
+            if (session.getFrame() < frames) {
+                player->pressRandomKeys();
+                session.step();
+            } else {
+                session.poll();
+            }
+
+            if (session.isDisconnected())
+                throw std::runtime_error("The other player disconnected");
+
+            settled = settled && session.getConfirmedFrames() == frames;
+        }
+
+        if (settled)
+            ++lingered;
+
+        waitForFrame();
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string_view ROMPath;
+    std::optional<Chip8::Engine> engine;
+    std::optional<std::uint8_t> playerNumber;
+    std::uint16_t port{7000};
+    std::string peerHost;
+    std::uint16_t peerPort{0};
+    bool loopback = false;
+    std::uint32_t frames = kDefaultFrames;
+    std::uint32_t inputDelay{0};
+    std::chrono::milliseconds latency{0};
+    double loss{0};
+    std::uint16_t keyMask{0xFFFF};
+
+    for (int i{1}; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+
+        if (arg == "--player" && i + 1 < argc) {
+            playerNumber = static_cast<std::uint8_t>(std::stoul(argv[++i]) - 1);
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = static_cast<std::uint16_t>(std::stoul(argv[++i]));
+        } else if (arg == "--peer" && i + 1 < argc) {
+            const std::string_view peer{argv[++i]};
+            const std::size_t colon = peer.rfind(':');
+
+            if (colon == std::string_view::npos) {
+                printUsage();
+                return 1;
+            }
+
+            peerHost = peer.substr(0, colon);
+            peerPort = static_cast<std::uint16_t>(std::stoul(std::string{peer.substr(colon + 1)}));
+        } else if (arg == "--loopback") {
+            loopback = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frames = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--input-delay" && i + 1 < argc) {
+            inputDelay = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--latency" && i + 1 < argc) {
+            latency = std::chrono::milliseconds{std::stoul(argv[++i])};
+        } else if (arg == "--loss" && i + 1 < argc) {
+            loss = std::stod(argv[++i]);
+        } else if (arg == "--keys" && i + 1 < argc) {
+            keyMask = static_cast<std::uint16_t>(std::stoul(argv[++i], nullptr, 16));
+        } else if (arg == "--engine" && i + 1 < argc) {
+            engine = Chip8::parseEngine(argv[++i]);
+
+            if (!engine) {
+                std::cerr << "Unknown engine: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (ROMPath.empty() && !arg.starts_with("--")) {
+            ROMPath = arg;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (ROMPath.empty() || loopback == (playerNumber || !peerHost.empty())
+        || (!loopback && (!playerNumber || peerHost.empty()))) {
+        printUsage();
+        return 1;
+    }
+
+    try {
+        std::vector<std::unique_ptr<Player>> players;
+
+        if (loopback) {
+            for (std::uint8_t player{0}; player < 2; ++player) {
+                players.push_back(std::make_unique<Player>(
+                    ROMPath, engine, player, static_cast<std::uint16_t>(port + player), "127.0.0.1",
+                    static_cast<std::uint16_t>(port + 1 - player), latency, loss, inputDelay, keyMask
+                ));
+            }
+        } else {
+            players.push_back(std::make_unique<Player>(
+                ROMPath, engine, *playerNumber, port, peerHost, peerPort, latency, loss, inputDelay, keyMask
+            ));
+        }
+
+        std::vector<Player*> playing;
+
+        for (const std::unique_ptr<Player>& player : players)
+            playing.push_back(player.get());
+
+        play(playing, frames);
+
+        bool failed = false;
+
+        for (std::size_t player{0}; player < players.size(); ++player) {
+            const RollbackSession& session = players[player]->session;
+            const RollbackSession::Statistics& statistics = session.getStatistics();
+            const auto rollbackTime = std::chrono::duration<double, std::micro>(statistics.maxRollbackTime);
+
+            std::cout << std::format(
+                "Player {}: {} frames, {} rollbacks re-running {} frames (at most {} frames in {:.1f} us), "
+                "{} frames stalled, state hash {:016X}{}\n",
+                loopback ? player + 1 : *playerNumber + 1u, session.getFrame(), statistics.rollbacks,
+                statistics.framesResimulated, statistics.maxRollbackFrames, rollbackTime.count(),
+                statistics.stalledFrames, hashState(players[player]->chip8),
+                session.isDesynced() ? ", desynced" : ""
+            );
+
+            failed = failed || session.isDesynced() || statistics.maxRollbackTime > kFrameDuration;
+        }
+
+        if (loopback && hashState(players[0]->chip8) != hashState(players[1]->chip8)) {
+            std::cout << "Players ended in different states" << std::endl;
+            failed = true;
+        }
+
+        return failed ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
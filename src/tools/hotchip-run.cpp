@@ -0,0 +1,234 @@
+#include <chrono>
+#include <format>
+#include <string>
+#include <iostream>
+#include <string_view>
+#include "../interpreter/Chip8.h"
+#include "../interpreter/RunAhead.h"
+#include "../interpreter/InputMovie.h"
+
+/*
+ * hotchip-run: run a ROM headless, without a window, audio device
+ * or frame limiting, then dump the final machine state.
+ *
+ * Usage: hotchip-run <ROM> [--frames N] [--engine NAME] [--seed N]
+ *                   [--load-state FILE] [--save-state FILE] [--run-ahead N]
+ *                   [--play-movie FILE [--seek FRAME]] [--check-allocations]
+ *
+ * Builds with HOTCHIP_COUNT_ALLOCATIONS also report the heap allocations made
+ * by frames after warm-up. --check-allocations fails if there are any.
+ *
+ * --seed fixes the random numbers of CXNN, so runs of ROMs using them can be
+ * compared between engines.
+ *
+ * --load-state starts from a save state instead of the start of the ROM,
+ * --save-state saves the final state (e.g. to load it in the desktop frontend).
+ *
+ * --run-ahead emulates every frame through RunAhead and prints the framebuffer
+ * N frames ahead of the final state, as the desktop frontend would show it.
+ *
+ * --play-movie replays a movie recorded by the desktop frontend, by default
+ * to its end. --seek starts playing at a frame, from the keyframe before it.
+ */
+
+// Default amount of frames to emulate (10 seconds of emulated time)
+static constexpr std::uint32_t kDefaultFrames = 600;
+
+// Frames allowed to allocate (decode caches, JIT buffers) before the frame loop
+// must be allocation-free (1 second of emulated time)
+static constexpr std::uint32_t kAllocationWarmupFrames = 60;
+
+static void printUsage() {
+    std::cerr << "Usage: hotchip-run <ROM> [--frames N] [--engine NAME] [--seed N] "
+                 "[--load-state FILE] [--save-state FILE] [--run-ahead N] "
+                 "[--play-movie FILE [--seek FRAME]] [--check-allocations]" << std::endl;
+}
+
+static void dumpRegisters(const Chip8DebugData& debugInfo) {
+    std::cout << std::format("PC: {:04X}  I: {:04X}\n", debugInfo.PC, debugInfo.index);
+
+    for (std::uint8_t reg{0}; reg < Chip8::kRegisterAmount; ++reg) {
+        std::cout << std::format(
+            "V{:X}: {:02X}{}", reg, debugInfo.registers[reg],
+            reg % 8 == 7 ? '\n' : ' '
+        );
+    }
+}
+
+// Print the framebuffer as text, one character per pixel
+static void dumpFrameBuffer(std::span<const std::uint8_t> frameBuffer) {
+    std::string line;
+
+    for (int y{0}; y < Chip8::kScreenHeight; ++y) {
+        line.clear();
+
+        for (int x{0}; x < Chip8::kScreenWidth; ++x) {
+            const std::uint8_t byte = frameBuffer[y * Chip8::kScreenPitch + x / 8];
+            const bool pixel = (byte >> (7 - x % 8)) & 1;
+            line += pixel ? '#' : '.';
+        }
+
+        std::cout << line << '\n';
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string_view ROMPath;
+    std::optional<std::uint32_t> frames;
+    Chip8::Engine engine = Chip8::Engine::PreDecoded;
+    bool checkAllocations = false;
+    std::optional<std::uint32_t> seed;
+    std::string loadStatePath;
+    std::string saveStatePath;
+    std::uint32_t runAheadFrames{0};
+    std::string moviePath;
+    std::optional<std::uint64_t> seekFrame;
+
+    for (int i{1}; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+
+        if (arg == "--frames" && i + 1 < argc) {
+            frames = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--engine" && i + 1 < argc) {
+            const std::optional<Chip8::Engine> parsed = Chip8::parseEngine(argv[++i]);
+
+            if (!parsed) {
+                std::cerr << "Unknown engine: " << argv[i] << std::endl;
+                return 1;
+            }
+
+            engine = *parsed;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--load-state" && i + 1 < argc) {
+            loadStatePath = argv[++i];
+        } else if (arg == "--save-state" && i + 1 < argc) {
+            saveStatePath = argv[++i];
+        } else if (arg == "--run-ahead" && i + 1 < argc) {
+            runAheadFrames = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--play-movie" && i + 1 < argc) {
+            moviePath = argv[++i];
+        } else if (arg == "--seek" && i + 1 < argc) {
+            seekFrame = std::stoull(argv[++i]);
+        } else if (arg == "--check-allocations") {
+            checkAllocations = true;
+        } else if (ROMPath.empty() && !arg.starts_with("--")) {
+            ROMPath = arg;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    // A movie starts from its own state
+    if (ROMPath.empty() || (!moviePath.empty() && (seed || !loadStatePath.empty()))
+        || (seekFrame && moviePath.empty())) {
+        printUsage();
+        return 1;
+    }
+
+    if (checkAllocations && !kAllocationCounting) {
+        std::cerr << "--check-allocations requires a build with -DHOTCHIP_COUNT_ALLOCATIONS=ON" << std::endl;
+        return 1;
+    }
+
+    try {
+        Chip8 interpreter{ROMPath};
+        interpreter.setEngine(engine);
+
+        RunAhead runAhead{runAheadFrames};
+
+        if (seed)
+            interpreter.setRandomSeed(*seed);
+
+        if (!loadStatePath.empty())
+            interpreter.loadState(readSaveStateFile(loadStatePath));
+
+        std::optional<Movie> movie;
+        std::optional<MoviePlayer> player;
+
+        if (!moviePath.empty()) {
+            movie = readMovieFile(moviePath);
+            player.emplace(*movie, interpreter);
+
+            if (seekFrame)
+                player->seek(interpreter, *seekFrame);
+
+            // Play to the end of the movie unless told otherwise
+            if (!frames)
+                frames = static_cast<std::uint32_t>(movie->frameCount - player->getFrame());
+        }
+
+        const std::uint32_t framesToRun = frames.value_or(kDefaultFrames);
+
+        // Allocations and frames allocating after warm-up
+        std::uint64_t steadyAllocations{0};
+        std::uint32_t allocatingFrames{0};
+
+        // The framebuffer shown after the last frame, ahead of the machine's with --run-ahead
+        std::span<const std::uint8_t> frameBuffer = interpreter.getFrameBuffer();
+
+        const auto start = std::chrono::steady_clock::now();
+
+        const auto emulateFrame = [&] {
+            if (player)
+                player->beginFrame(interpreter);
+
+            frameBuffer = runAhead.step(interpreter);
+        };
+
+        if constexpr (kAllocationCounting) {
+            for (std::uint32_t frame{0}; frame < framesToRun; ++frame) {
+                // Includes the frames run ahead
+                const std::uint64_t allocationsBefore = allocationCount();
+                emulateFrame();
+                const std::uint64_t frameAllocations = allocationCount() - allocationsBefore;
+
+                if (frame >= kAllocationWarmupFrames && frameAllocations != 0) {
+                    steadyAllocations += frameAllocations;
+                    ++allocatingFrames;
+                }
+            }
+        } else if (runAheadFrames != 0 || player) {
+            for (std::uint32_t frame{0}; frame < framesToRun; ++frame)
+                emulateFrame();
+        } else {
+            interpreter.step(framesToRun);
+        }
+
+        const auto elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        std::cout << std::format(
+            "{} frames in {:.3f}s ({:.0f} frames/s)\n",
+            interpreter.getFrameCount(), elapsed,
+            static_cast<double>(framesToRun) / elapsed
+        );
+
+        if constexpr (kAllocationCounting) {
+            std::cout << std::format(
+                "{} allocations after warm-up, in {} frames\n", steadyAllocations, allocatingFrames
+            );
+        }
+
+        dumpRegisters(interpreter.getDebugData());
+        dumpFrameBuffer(frameBuffer);
+
+        if (!saveStatePath.empty()) {
+            SaveState state;
+            interpreter.saveState(state);
+            writeSaveStateFile(saveStatePath, state);
+        }
+
+        if (checkAllocations && allocatingFrames != 0) {
+            std::cerr << "Frame loop allocated after warm-up" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
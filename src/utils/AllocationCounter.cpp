@@ -0,0 +1,101 @@
+#include <new>
+#include <cstdlib>
+#if defined(_WIN32)
+    #include <malloc.h>
+#endif
+#include "AllocationCounter.h"
+
+/*
+ * Replacements of the global allocation functions, counting every call.
+ * Compiled in only for HOTCHIP_COUNT_ALLOCATIONS builds.
+ *
+ * Counted per thread, so a frame only counts the allocations of the thread
+ * emulating it, not those another thread (e.g. the logger's) makes meanwhile.
+ */
+
+static thread_local std::uint64_t s_allocations{0};
+
+std::uint64_t allocationCount() {
+    return s_allocations;
+}
+
+static void* countedAllocate(std::size_t size) noexcept {
+    ++s_allocations;
+
+    // malloc(0) may return nullptr, operator new must not
+    return std::malloc(size != 0 ? size : 1);
+}
+
+static void* countedAllocate(std::size_t size, std::align_val_t alignment) noexcept {
+    ++s_allocations;
+
+    // aligned_alloc requires the size to be a multiple of the alignment
+    const auto align = static_cast<std::size_t>(alignment);
+    const std::size_t alignedSize = (size + align - 1) / align * align;
+
+#if defined(_WIN32)
+    return _aligned_malloc(alignedSize != 0 ? alignedSize : align, align);
+#else
+    return std::aligned_alloc(align, alignedSize != 0 ? alignedSize : align);
+#endif
+}
+
+static void alignedFree(void* memory) noexcept {
+#if defined(_WIN32)
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+void* operator new(std::size_t size) {
+    if (void* memory = countedAllocate(size))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* memory = countedAllocate(size, alignment))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAllocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAllocate(size, alignment);
+}
+
+// Memory comes from the C allocator (see countedAllocate())
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { alignedFree(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { alignedFree(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { alignedFree(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { alignedFree(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(memory); }
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Count of heap allocations made through the global operator new, for
+ * finding allocations in the emulation hot path.
+ *
+ * Only counted when built with -DHOTCHIP_COUNT_ALLOCATIONS=ON, which links
+ * AllocationCounter.cpp's replacement operator new/delete. Otherwise the
+ * count is always zero and costs nothing.
+ */
+#if defined(HOTCHIP_COUNT_ALLOCATIONS)
+    inline constexpr bool kAllocationCounting = true;
+
+    // Allocations made so far by the calling thread
+    std::uint64_t allocationCount();
+#else
+    inline constexpr bool kAllocationCounting = false;
+
+    inline std::uint64_t allocationCount() {
+        return 0;
+    }
+#endif
@@ -0,0 +1,31 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <filesystem>
+#include <system_error>
+#include "AtomicFile.h"
+
+void writeFileAtomically(const std::string& path, std::span<const std::uint8_t> data, std::string_view description) {
+    const std::string temporaryPath = path + ".tmp";
+    std::ofstream outFS{temporaryPath, std::ofstream::binary | std::ofstream::trunc};
+    outFS.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    outFS.close();
+
+    // A partly written file is removed rather than left next to path
+    std::error_code ignored;
+
+    if (!outFS) {
+        const std::string reason = std::strerror(errno);
+        std::filesystem::remove(temporaryPath, ignored);
+        throw std::runtime_error("Error writing " + std::string{description} + ": " + temporaryPath + ", " + reason);
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+
+    if (error) {
+        std::filesystem::remove(temporaryPath, ignored);
+        throw std::runtime_error("Error writing " + std::string{description} + ": " + path + ", " + error.message());
+    }
+}
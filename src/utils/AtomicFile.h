@@ -0,0 +1,14 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+/*
+ * Write data to path through a temporary file next to it, renamed over path
+ * once complete, so a failed write leaves any previous file intact. The
+ * temporary file is removed on failure, and failures are thrown as a
+ * std::runtime_error: "Error writing <description>: <path>, <reason>".
+ */
+void writeFileAtomically(const std::string& path, std::span<const std::uint8_t> data, std::string_view description);
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <bit>
+#include <span>
+#include <array>
+#include <cstdint>
+#include "Logger.h"
+
+/*
+ * Bounds strategies of GuestMemory, chosen at compile time.
+ *
+ * wrap() gives the byte an address reaches (or an address >= size if the
+ * access is discarded), access() the reference to read or write through.
+ * allows() tells whether an access to a wrapped address goes ahead, for
+ * memories without a byte to return a reference to (PagedGuestMemory).
+ * Policies without state are empty and take no space in GuestMemory.
+ */
+
+// Out-of-bounds accesses are logged, reads give zero and writes are discarded
+struct CheckedBounds {
+    // Out-of-bounds accesses made by the calling thread, e.g. for a fuzzer to detect
+    static inline thread_local std::uint64_t outOfBoundsAccesses{0};
+
+    // Target of discarded out-of-bounds accesses
+    std::uint8_t m_discarded{0};
+
+    template<std::uint16_t size>
+    static constexpr std::uint16_t wrap(std::uint16_t address) {
+        return address;
+    }
+
+    template<std::uint16_t size>
+    static bool allows(std::uint16_t address) {
+        if (address < size) [[likely]]
+            return true;
+
+        /*
+         * Out of bounds index into an array (operator[]) usually
+         * segfaults, or for the .at() method it will throw an out_of_range
+         * exception. In the case of emulation, we will assume it's an error in
+         * the ROM and chose to continue execution rather than terminating.
+         */
+        ++outOfBoundsAccesses;
+        logMessage(LogLevel::Error, "Out-of-bounds memory access at {} for size {}", address, size);
+        return false;
+    }
+
+    template<std::uint16_t size>
+    std::uint8_t& access(std::array<std::uint8_t, size>& data, std::uint16_t address) {
+        if (allows<size>(address)) [[likely]]
+            return data[address];
+
+        m_discarded = 0;
+        return m_discarded;
+    }
+};
+
+// Addresses wrap around, as on real hardware with its 12 bit address bus
+struct MaskedBounds {
+    template<std::uint16_t size>
+    static constexpr std::uint16_t wrap(std::uint16_t address) {
+        static_assert(std::has_single_bit(size), "Masked memory must be a power of two in size");
+        return address & (size - 1);
+    }
+
+    template<std::uint16_t size>
+    static constexpr bool allows(std::uint16_t) {
+        return true;
+    }
+
+    template<std::uint16_t size>
+    static std::uint8_t& access(std::array<std::uint8_t, size>& data, std::uint16_t address) {
+        return data[wrap<size>(address)];
+    }
+};
+
+// No checks at all, only for ROMs verified to stay within bounds
+struct UncheckedBounds {
+    template<std::uint16_t size>
+    static constexpr std::uint16_t wrap(std::uint16_t address) {
+        return address;
+    }
+
+    template<std::uint16_t size>
+    static constexpr bool allows(std::uint16_t) {
+        return true;
+    }
+
+    template<std::uint16_t size>
+    static std::uint8_t& access(std::array<std::uint8_t, size>& data, std::uint16_t address) {
+        return data[address];
+    }
+};
+
+/*
+ * Emulated memory of size bytes. Every access goes through the Bounds policy,
+ * masked and unchecked accesses compile to a single load or store.
+ */
+template<std::uint16_t size, typename Bounds>
+class GuestMemory {
+    std::array<std::uint8_t, size> m_data{};
+
+    [[no_unique_address]] Bounds m_bounds{};
+
+    public:
+        std::uint8_t& operator[](std::uint16_t address) {
+            return m_bounds.template access<size>(m_data, address);
+        }
+
+        // The byte an access to address reaches, size or above if it is discarded
+        static constexpr std::uint16_t wrap(std::uint16_t address) {
+            return Bounds::template wrap<size>(address);
+        }
+
+        // Allow .begin() method from std::array to be used for our GuestMemory
+        auto begin() {
+            return m_data.begin();
+        }
+
+        std::span<std::uint8_t> getDataView() {
+            return m_data;
+        }
+
+        [[nodiscard]] std::span<const std::uint8_t> getDataView() const {
+            return m_data;
+        }
+
+        void clear() {
+            // Zero out array to clear data
+            m_data.fill(0);
+        }
+};
@@ -0,0 +1,163 @@
+#include <iostream>
+#include <string>
+#include "Logger.h"
+
+static const char* levelPrefix(LogLevel level) {
+    return level == LogLevel::Error ? "[ERROR] " : "[DEBUG] ";
+}
+
+Logger::Logger() : m_thread(&Logger::run, this) {}
+
+Logger::~Logger() {
+    m_running.store(false, std::memory_order_relaxed);
+    m_thread.join();
+
+    // Records queued after the thread's last pass
+    drain();
+    summariseRepeats(true);
+    std::cerr.flush();
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+LogBuffer& Logger::threadBuffer() {
+    // Gives the buffer back to the logger when the thread exits
+    struct Lease {
+        LogBuffer* buffer{nullptr};
+
+        ~Lease() {
+            if (buffer)
+                Logger::instance().releaseBuffer(buffer);
+        }
+    };
+
+    thread_local Lease lease;
+
+    if (!lease.buffer) {
+        const std::lock_guard lock(m_buffersMutex);
+
+        if (!m_freeBuffers.empty()) {
+            // Records the last owner left are still in order, ahead of the new owner's
+            lease.buffer = m_freeBuffers.back();
+            m_freeBuffers.pop_back();
+        } else {
+            lease.buffer = m_buffers.emplace_back(std::make_unique<LogBuffer>()).get();
+        }
+    }
+
+    return *lease.buffer;
+}
+
+void Logger::releaseBuffer(LogBuffer* buffer) {
+    const std::lock_guard lock(m_buffersMutex);
+    m_freeBuffers.push_back(buffer);
+}
+
+void Logger::pushText(LogLevel level, std::string message) {
+    const std::lock_guard lock(m_textsMutex);
+    m_texts.emplace_back(level, std::move(message));
+}
+
+void Logger::run() {
+    while (m_running.load(std::memory_order_relaxed)) {
+        // Flush once per batch rather than once per line
+        if (drain())
+            std::cerr.flush();
+
+        summariseRepeats(false);
+        std::this_thread::sleep_for(kPollInterval);
+    }
+}
+
+bool Logger::drain() {
+    // Buffers are never freed while the logger exists, so they can be drained
+    // after unlocking, without a thread registering a buffer waiting on the console
+    {
+        const std::lock_guard lock(m_buffersMutex);
+        m_draining.clear();
+
+        for (const std::unique_ptr<LogBuffer>& buffer : m_buffers)
+            m_draining.push_back(buffer.get());
+    }
+
+    bool wrote = false;
+
+    for (LogBuffer* buffer : m_draining) {
+        LogRecord record{};
+
+        while (buffer->pop(record)) {
+            write(record);
+            wrote = true;
+        }
+
+        m_dropped += buffer->takeDropped();
+    }
+
+    {
+        const std::lock_guard lock(m_textsMutex);
+        m_writingTexts.swap(m_texts);
+    }
+
+    for (const auto& [level, message] : m_writingTexts) {
+        std::cerr << levelPrefix(level) << message << '\n';
+        wrote = true;
+    }
+
+    m_writingTexts.clear();
+    return wrote;
+}
+
+void Logger::write(const LogRecord& record) {
+    const auto now = std::chrono::steady_clock::now();
+    RepeatState& repeats = m_repeats[record.format];
+
+    if (now - repeats.windowStart >= std::chrono::seconds{1}) {
+        if (repeats.suppressed != 0)
+            std::cerr << "[LOG] Suppressed " << repeats.suppressed << " repeats of: " << record.format << '\n';
+
+        repeats = RepeatState{now, 0, 0};
+    }
+
+    if (repeats.written == kMaxRepeatsPerSecond) {
+        ++repeats.suppressed;
+        return;
+    }
+
+    ++repeats.written;
+
+    // Substitute the arguments for the {} placeholders
+    std::string line = levelPrefix(record.level);
+    std::uint8_t argument{0};
+
+    for (const char* c = record.format; *c != '\0'; ++c) {
+        if (c[0] == '{' && c[1] == '}' && argument < record.argumentCount) {
+            line += std::to_string(record.arguments[argument++]);
+            ++c;
+        } else {
+            line += *c;
+        }
+    }
+
+    std::cerr << line << '\n';
+}
+
+void Logger::summariseRepeats(bool all) {
+    const auto now = std::chrono::steady_clock::now();
+
+    for (auto& [format, repeats] : m_repeats) {
+        if (repeats.suppressed == 0 || (!all && now - repeats.windowStart < std::chrono::seconds{1}))
+            continue;
+
+        std::cerr << "[LOG] Suppressed " << repeats.suppressed << " repeats of: " << format << '\n';
+        repeats.suppressed = 0;
+    }
+
+    if (m_dropped != 0 && (all || now - m_droppedReported >= std::chrono::seconds{1})) {
+        std::cerr << "[LOG] " << m_dropped << " messages dropped, log buffer full\n";
+        m_dropped = 0;
+        m_droppedReported = now;
+    }
+}
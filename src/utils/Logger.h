@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+
+enum class LogLevel : std::uint8_t {
+    Debug,
+    Error
+};
+
+/*
+ * A message waiting to be written: its format string, a string literal
+ * with a {} for each argument, and the integer arguments.
+ */
+struct LogRecord {
+    static constexpr std::uint8_t kMaxArguments = 3;
+
+    const char* format;
+    std::array<std::int64_t, kMaxArguments> arguments;
+    std::uint8_t argumentCount;
+    LogLevel level;
+};
+
+/*
+ * Lock-free queue of records from one thread (the producer) to the logging
+ * thread (the consumer). Records that don't fit are dropped and counted.
+ */
+class LogBuffer {
+    public:
+        static constexpr std::uint32_t kCapacity = 1024;
+
+    private:
+        std::array<LogRecord, kCapacity> m_records{};
+
+        // Indices only grow, the slot is the index modulo kCapacity.
+        // Separate cache lines, as each is written by a different thread.
+        alignas(64) std::atomic<std::uint32_t> m_head{0};
+        alignas(64) std::atomic<std::uint32_t> m_tail{0};
+        std::atomic<std::uint32_t> m_dropped{0};
+
+    public:
+        // Producer side
+        void push(const LogRecord& record) {
+            const std::uint32_t tail = m_tail.load(std::memory_order_relaxed);
+
+            if (tail - m_head.load(std::memory_order_acquire) == kCapacity) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            m_records[tail % kCapacity] = record;
+            m_tail.store(tail + 1, std::memory_order_release);
+        }
+
+        // Consumer side, false if empty
+        bool pop(LogRecord& record) {
+            const std::uint32_t head = m_head.load(std::memory_order_relaxed);
+
+            if (head == m_tail.load(std::memory_order_acquire))
+                return false;
+
+            record = m_records[head % kCapacity];
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Records dropped since the last call
+        std::uint32_t takeDropped() {
+            return m_dropped.exchange(0, std::memory_order_relaxed);
+        }
+};
+
+/*
+ * Asynchronous logger for diagnostics from the emulation hot path.
+ *
+ * logMessage() only copies a binary record into the calling thread's LogBuffer,
+ * formatting and console I/O happen on a background thread. Repeats of a
+ * message beyond kMaxRepeatsPerSecond are counted rather than written, so a
+ * ROM erroring every instruction doesn't flood the console.
+ *
+ * Records are written when the logger is destroyed at exit, don't log from
+ * static destructors.
+ */
+class Logger {
+    // Messages with the same format written per second, further repeats are summarised
+    static constexpr std::uint32_t kMaxRepeatsPerSecond = 10;
+
+    // How often the logging thread collects records
+    static constexpr auto kPollInterval = std::chrono::milliseconds{10};
+
+    // Rate limiting state of one message format (logging thread only)
+    struct RepeatState {
+        std::chrono::steady_clock::time_point windowStart;
+        std::uint32_t written{0};
+        std::uint32_t suppressed{0};
+    };
+
+    /*
+     * Buffers of every thread which has logged, owned here so records queued
+     * by a thread are still written after it exits. The buffer of a thread
+     * which exited is recycled by the next thread to log, rather than freed.
+     */
+    std::mutex m_buffersMutex;
+    std::vector<std::unique_ptr<LogBuffer>> m_buffers;
+    std::vector<LogBuffer*> m_freeBuffers;
+
+    // Copy of m_buffers drained without holding the mutex (logging thread only)
+    std::vector<LogBuffer*> m_draining;
+
+    // Messages queued by pushText(), swapped into m_writingTexts to be written
+    std::mutex m_textsMutex;
+    std::vector<std::pair<LogLevel, std::string>> m_texts;
+    std::vector<std::pair<LogLevel, std::string>> m_writingTexts;
+
+    std::unordered_map<const char*, RepeatState> m_repeats;
+
+    // Records dropped from full buffers since last reported (logging thread only)
+    std::uint64_t m_dropped{0};
+    std::chrono::steady_clock::time_point m_droppedReported;
+
+    std::atomic<bool> m_running{true};
+    std::thread m_thread;
+
+    Logger();
+
+    // Logging thread: collect and write records until destroyed
+    void run();
+
+    // Write every queued record, returns whether there were any
+    bool drain();
+
+    void write(const LogRecord& record);
+
+    // Report suppressed repeats and dropped records, once per second (or now if all)
+    void summariseRepeats(bool all);
+
+    LogBuffer& threadBuffer();
+
+    // Called when the thread owning buffer exits
+    void releaseBuffer(LogBuffer* buffer);
+
+    public:
+        ~Logger();
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
+        static Logger& instance();
+
+        // Create the calling thread's buffer now, so its first message doesn't allocate
+        void registerThread() {
+            threadBuffer();
+        }
+
+        void push(const LogRecord& record) {
+            threadBuffer().push(record);
+        }
+
+        // Queue a message already formatted, allocates, so only for cold paths
+        void pushText(LogLevel level, std::string message);
+};
+
+// Queue a message for the logging thread, format is a string literal with a {} per argument
+template<typename... Arguments>
+void logMessage(LogLevel level, const char* format, Arguments... arguments) {
+    static_assert(sizeof...(Arguments) <= LogRecord::kMaxArguments, "Too many log arguments");
+    static_assert((std::is_integral_v<Arguments> && ...), "Log arguments must be integers");
+
+    Logger::instance().push(LogRecord{
+        format, {static_cast<std::int64_t>(arguments)...},
+        static_cast<std::uint8_t>(sizeof...(Arguments)), level
+    });
+}
+
+/*
+ * Queue a message with text in it, such as an exception's, which records can't
+ * hold. It's formatted and allocated by the caller and isn't rate limited, so
+ * only use it for errors off the hot path.
+ */
+inline void logText(LogLevel level, std::string message) {
+    Logger::instance().pushText(level, std::move(message));
+}
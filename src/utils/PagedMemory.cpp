@@ -0,0 +1,82 @@
+#include <cstring>
+#include "PagedMemory.h"
+
+MemoryPagePool::MemoryPagePool() : m_zeroPage{intern(std::array<std::uint8_t, kMemoryPageSize>{})} {}
+
+MemoryPagePool& MemoryPagePool::instance() {
+    // Never destroyed, memories in static storage may outlive any other static
+    static MemoryPagePool* const pool = new MemoryPagePool;
+    return *pool;
+}
+
+MemoryPage* MemoryPagePool::allocateLocked() {
+    if (m_free.empty()) {
+        const std::unique_ptr<MemoryPage[]>& chunk = m_chunks.emplace_back(new MemoryPage[kChunkPages]);
+
+        // Every page fits the free list, releasing never allocates
+        m_free.reserve(m_chunks.size() * kChunkPages);
+
+        for (std::size_t page{0}; page < kChunkPages; ++page)
+            m_free.push_back(&chunk[page]);
+    }
+
+    MemoryPage* const page = m_free.back();
+    m_free.pop_back();
+
+    page->references.store(1, std::memory_order_relaxed);
+    page->interned.store(false, std::memory_order_relaxed);
+    page->owner.store(nullptr, std::memory_order_relaxed);
+    return page;
+}
+
+MemoryPage* MemoryPagePool::intern(std::span<const std::uint8_t, kMemoryPageSize> data) {
+    std::array<std::uint8_t, kMemoryPageSize> key;
+    std::ranges::copy(data, key.begin());
+
+    const std::lock_guard lock{m_mutex};
+    MemoryPage*& page = m_interned[key];
+
+    if (!page) {
+        // The pool's own reference keeps it shared
+        page = allocateLocked();
+        page->data = key;
+        page->interned.store(true, std::memory_order_relaxed);
+    }
+
+    retain(page);
+    return page;
+}
+
+void MemoryPagePool::evict(MemoryPage* page) {
+    const std::lock_guard lock{m_mutex};
+
+    // Pages are only interned, and their references taken again, with m_mutex held,
+    // so whoever finds the pool's the only reference left under it evicts the page
+    if (page == m_zeroPage || !page->interned.load(std::memory_order_relaxed)
+        || page->references.load(std::memory_order_acquire) != 1)
+        return;
+
+    m_interned.erase(page->data);
+    page->interned.store(false, std::memory_order_relaxed);
+    page->references.store(0, std::memory_order_relaxed);
+    m_free.push_back(page);
+}
+
+MemoryPage* MemoryPagePool::copy(MemoryPage* page) {
+    MemoryPage* copy = nullptr;
+
+    {
+        const std::lock_guard lock{m_mutex};
+        copy = allocateLocked();
+    }
+
+    std::memcpy(copy->data.data(), page->data.data(), kMemoryPageSize);
+    release(page);
+
+    return copy;
+}
+
+std::size_t MemoryPagePool::getPageCount() {
+    const std::lock_guard lock{m_mutex};
+    return m_chunks.size() * kChunkPages - m_free.size();
+}
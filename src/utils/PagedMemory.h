@@ -0,0 +1,259 @@
+#pragma once
+
+#include <map>
+#include <span>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "GuestMemory.h"
+
+// Bytes per page of PagedGuestMemory, the unit of copy-on-write
+inline constexpr std::uint16_t kMemoryPageSize = 256;
+
+// A page, shared by every memory holding a reference to it.
+// Cache line aligned, as the array it replaces was.
+struct alignas(64) MemoryPage {
+    std::array<std::uint8_t, kMemoryPageSize> data;
+    std::atomic<std::uint32_t> references;
+
+    // Whether the pool's intern map holds one of the references
+    std::atomic<bool> interned;
+
+    // The memory holding the only reference, which writes it in place.
+    // Cleared by every new reference, so an owner seeing itself has it alone.
+    std::atomic<const void*> owner;
+};
+
+/*
+ * Process-wide allocator of memory pages.
+ *
+ * Pages are carved out of chunks and recycled through a free list, so a
+ * copy-on-write only allocates while the pool is still growing.
+ *
+ * Interned pages are shared by content: every memory loading the same ROM
+ * gets the same ROM, font and zero pages. The pool keeps a reference to
+ * them, so they are never written in place and always copied on write.
+ * Once the pool's is the only reference left, the page is evicted and
+ * freed, so opening ROM after ROM doesn't keep the pages of each.
+ */
+class MemoryPagePool {
+    static constexpr std::size_t kChunkPages = 64;
+
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<MemoryPage[]>> m_chunks;
+    std::vector<MemoryPage*> m_free;
+    std::map<std::array<std::uint8_t, kMemoryPageSize>, MemoryPage*> m_interned;
+
+    // The interned page of zeros, every page of a new memory
+    MemoryPage* m_zeroPage;
+
+    MemoryPagePool();
+
+    // Page with a single reference, the caller's. m_mutex must be held.
+    MemoryPage* allocateLocked();
+
+    // Free an interned page if no memory holds it any more
+    void evict(MemoryPage* page);
+
+    public:
+        static MemoryPagePool& instance();
+
+        MemoryPagePool(const MemoryPagePool&) = delete;
+        MemoryPagePool& operator=(const MemoryPagePool&) = delete;
+
+        // A shared page holding data, with a new reference for the caller
+        MemoryPage* intern(std::span<const std::uint8_t, kMemoryPageSize> data);
+
+        // The shared page of zeros, with a new reference for the caller
+        MemoryPage* zeroPage() {
+            retain(m_zeroPage);
+            return m_zeroPage;
+        }
+
+        // A private copy of page, replacing the caller's reference to page
+        MemoryPage* copy(MemoryPage* page);
+
+        static void retain(MemoryPage* page) {
+            page->owner.store(nullptr, std::memory_order_relaxed);
+            page->references.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release(MemoryPage* page) {
+            const std::uint32_t references = page->references.fetch_sub(1, std::memory_order_acq_rel);
+
+            if (references == 1) {
+                const std::lock_guard lock{m_mutex};
+                m_free.push_back(page);
+            } else if (references == 2 && page->interned.load(std::memory_order_relaxed)) [[unlikely]] {
+                evict(page);
+            }
+        }
+
+        // Pages in use, each counted once however many memories share it
+        [[nodiscard]] std::size_t getPageCount();
+};
+
+// Unchecked reads of paged memory, for fetching instructions known to be in bounds
+class PagedMemoryView {
+    std::span<MemoryPage* const> m_pages;
+
+    public:
+        explicit PagedMemoryView(std::span<MemoryPage* const> pages) : m_pages{pages} {}
+
+        std::uint8_t operator[](std::uint16_t address) const {
+            return m_pages[address / kMemoryPageSize]->data[address % kMemoryPageSize];
+        }
+
+        // The big-endian word at address, with one page lookup unless it crosses pages
+        std::uint16_t word(std::uint16_t address) const {
+            const MemoryPage& page = *m_pages[address / kMemoryPageSize];
+            const std::uint16_t offset = address % kMemoryPageSize;
+
+            if (offset + 1 < kMemoryPageSize) [[likely]]
+                return static_cast<std::uint16_t>(page.data[offset] << 8 | page.data[offset + 1]);
+
+            return static_cast<std::uint16_t>(page.data[offset] << 8 | (*this)[address + 1]);
+        }
+};
+
+/*
+ * Emulated memory of size bytes, split into reference-counted pages.
+ *
+ * Copying a memory shares its pages, a page is only copied by the first
+ * write to it while shared. Instances of the same ROM keep sharing every
+ * page they haven't written, and a copy (e.g. Chip8::fork()) costs one
+ * reference per page whatever the memory holds.
+ *
+ * Accesses go through the Bounds policy as in GuestMemory. Reads return
+ * the byte, writes go through write() so shared pages can be copied.
+ *
+ * A page only this memory holds is marked with it as the owner, so writes
+ * to it skip the reference count. Sharing a page clears the mark with an
+ * atomic store, so any number of threads may copy from one memory (e.g.
+ * forks of one machine) as long as none writes to it meanwhile.
+ */
+template<std::uint16_t size, typename Bounds>
+class PagedGuestMemory {
+    public:
+        static constexpr std::size_t kPageCount = size / kMemoryPageSize;
+
+    private:
+        static_assert(size % kMemoryPageSize == 0, "Paged memory must be a whole number of pages");
+
+        std::array<MemoryPage*, kPageCount> m_pages{};
+
+        // Make a page this memory's own, copying it first if shared
+        MemoryPage* own(std::size_t page) {
+            if (m_pages[page]->owner.load(std::memory_order_relaxed) != this) [[unlikely]] {
+                if (m_pages[page]->references.load(std::memory_order_acquire) != 1)
+                    m_pages[page] = MemoryPagePool::instance().copy(m_pages[page]);
+
+                m_pages[page]->owner.store(this, std::memory_order_relaxed);
+            }
+
+            return m_pages[page];
+        }
+
+    public:
+        PagedGuestMemory() {
+            for (MemoryPage*& page : m_pages)
+                page = MemoryPagePool::instance().zeroPage();
+        }
+
+        PagedGuestMemory(const PagedGuestMemory& other) : m_pages{other.m_pages} {
+            for (MemoryPage* page : m_pages)
+                MemoryPagePool::retain(page);
+        }
+
+        PagedGuestMemory& operator=(const PagedGuestMemory& other) {
+            for (std::size_t page{0}; page < kPageCount; ++page)
+                share(other, page);
+
+            return *this;
+        }
+
+        ~PagedGuestMemory() {
+            for (MemoryPage* page : m_pages)
+                MemoryPagePool::instance().release(page);
+        }
+
+        std::uint8_t operator[](std::uint16_t address) const {
+            address = wrap(address);
+
+            if (!Bounds::template allows<size>(address)) [[unlikely]]
+                return 0;
+
+            return m_pages[address / kMemoryPageSize]->data[address % kMemoryPageSize];
+        }
+
+        void write(std::uint16_t address, std::uint8_t value) {
+            address = wrap(address);
+
+            if (!Bounds::template allows<size>(address)) [[unlikely]]
+                return;
+
+            // Shared with another memory or interned, write to a private copy
+            own(address / kMemoryPageSize)->data[address % kMemoryPageSize] = value;
+        }
+
+        // The byte an access to address reaches, size or above if it is discarded
+        static constexpr std::uint16_t wrap(std::uint16_t address) {
+            return Bounds::template wrap<size>(address);
+        }
+
+        [[nodiscard]] std::span<const std::uint8_t, kMemoryPageSize> getPage(std::size_t page) const {
+            return m_pages[page]->data;
+        }
+
+        // Whether a page of both memories is the same shared page, so holds the same bytes
+        [[nodiscard]] bool sharesPage(const PagedGuestMemory& other, std::size_t page) const {
+            return m_pages[page] == other.m_pages[page];
+        }
+
+        // Take a reference to other's page instead of this memory's own
+        void share(const PagedGuestMemory& other, std::size_t page) {
+            MemoryPage* const shared = other.m_pages[page];
+
+            if (m_pages[page] == shared)
+                return;
+
+            MemoryPagePool::retain(shared);
+            MemoryPagePool::instance().release(m_pages[page]);
+            m_pages[page] = shared;
+        }
+
+        // Overwrite a whole page, copying it first if shared
+        void writePage(std::size_t page, std::span<const std::uint8_t, kMemoryPageSize> data) {
+            std::ranges::copy(data, own(page)->data.begin());
+        }
+
+        // Fill every page from data, sharing the pages of any memory already holding the same bytes
+        void assign(std::span<const std::uint8_t, size> data) {
+            for (std::size_t page{0}; page < kPageCount; ++page) {
+                MemoryPage* const interned = MemoryPagePool::instance().intern(
+                    data.subspan(page * kMemoryPageSize).template first<kMemoryPageSize>()
+                );
+
+                MemoryPagePool::instance().release(m_pages[page]);
+                m_pages[page] = interned;
+            }
+        }
+
+        void copyTo(std::span<std::uint8_t, size> data) const {
+            for (std::size_t page{0}; page < kPageCount; ++page)
+                std::ranges::copy(m_pages[page]->data, data.begin() + page * kMemoryPageSize);
+        }
+
+        [[nodiscard]] PagedMemoryView getView() const {
+            return PagedMemoryView{m_pages};
+        }
+
+        void clear() {
+            *this = PagedGuestMemory{};
+        }
+};
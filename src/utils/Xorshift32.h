@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Marsaglia's xorshift32 pseudo-random number generator.
+ *
+ * Not suitable for anything but games: its 4 bytes of state fit beside the
+ * interpreter's registers, where std::mt19937 takes 5 KB, and three shifts
+ * per number are cheaper than a uniform_int_distribution.
+ * The same seed always gives the same sequence.
+ */
+class Xorshift32 {
+    // Never zero, which would give zero forever
+    std::uint32_t m_state;
+
+    // Replaces a seed of zero
+    static constexpr std::uint32_t kZeroSeed = 0x9E3779B9;
+
+    public:
+        explicit Xorshift32(std::uint32_t seed) {
+            setSeed(seed);
+        }
+
+        void setSeed(std::uint32_t seed) {
+            m_state = seed != 0 ? seed : kZeroSeed;
+        }
+
+        [[nodiscard]] std::uint32_t getState() const {
+            return m_state;
+        }
+
+        std::uint32_t next() {
+            m_state ^= m_state << 13;
+            m_state ^= m_state >> 17;
+            m_state ^= m_state << 5;
+            return m_state;
+        }
+
+        // The low bits of xorshift are its weakest, random bytes are taken from the top
+        std::uint8_t nextByte() {
+            return static_cast<std::uint8_t>(next() >> 24);
+        }
+};
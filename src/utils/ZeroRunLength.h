@@ -0,0 +1,200 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+/*
+ * Run-length compression of zero bytes, for data which is mostly zero
+ * (emulated memory, the framebuffer, deltas between states).
+ *
+ * The output is a sequence of control bytes:
+ * - 0x00-0x7F: the next (control + 1) bytes are copied as they are
+ * - 0x80-0xFF: (control - 0x7F) zero bytes
+ *
+ * 4 KB of zeros compress to 32 bytes. Single zeros stay in literal runs,
+ * which is cheaper than ending the run for them. Compressing the XOR of two
+ * similar buffers gives a small delta between them.
+ */
+
+// Longest run of either kind
+inline constexpr std::size_t kZeroRunMaxLength = 128;
+
+// Control bytes from here on encode zero runs
+inline constexpr std::uint8_t kZeroRunControl = 0x80;
+
+// Compared against to find runs
+inline constexpr std::array<std::uint8_t, kZeroRunMaxLength> kZeroRunZeros{};
+
+// Output size of the worst case, data without any zero runs
+constexpr std::size_t maxZeroRunCompressedSize(std::size_t size) {
+    return size + (size + kZeroRunMaxLength - 1) / kZeroRunMaxLength;
+}
+
+/*
+ * Compress input, or with delta the XOR of input and base, into output.
+ * The XOR is taken on the fly, so a delta costs no more than compressing.
+ */
+template<bool delta>
+std::size_t compressZeroRunsOf(
+    std::span<const std::uint8_t> input, std::span<const std::uint8_t> base, std::span<std::uint8_t> output
+) {
+    const auto byteAt = [&](std::size_t index) -> std::uint8_t {
+        return delta ? input[index] ^ base[index] : input[index];
+    };
+
+    std::size_t in{0};
+    std::size_t out{0};
+
+    while (in < input.size()) {
+        const std::size_t remaining = std::min(input.size() - in, kZeroRunMaxLength);
+
+        if (byteAt(in) == 0) {
+            // Mostly zero data is mostly full length runs, compared at once
+            const bool fullRun = delta
+                ? std::memcmp(&input[in], &base[in], remaining) == 0
+                : std::memcmp(&input[in], kZeroRunZeros.data(), remaining) == 0;
+
+            if (fullRun) {
+                output[out++] = static_cast<std::uint8_t>(kZeroRunControl + remaining - 1);
+                in += remaining;
+                continue;
+            }
+
+            std::size_t length{1};
+
+            // Otherwise skipped 8 bytes at a time
+            for (std::uint64_t word{0}; length + sizeof(word) <= remaining; length += sizeof(word)) {
+                std::memcpy(&word, &input[in + length], sizeof(word));
+
+                if constexpr (delta) {
+                    std::uint64_t baseWord{0};
+                    std::memcpy(&baseWord, &base[in + length], sizeof(baseWord));
+                    word ^= baseWord;
+                }
+
+                if (word != 0)
+                    break;
+            }
+
+            while (length < remaining && byteAt(in + length) == 0)
+                ++length;
+
+            output[out++] = static_cast<std::uint8_t>(kZeroRunControl + length - 1);
+            in += length;
+            continue;
+        }
+
+        // Literal run, until two zeros in a row
+        std::size_t length{1};
+
+        while (length < remaining) {
+            if (byteAt(in + length) == 0 && (length + 1 == remaining || byteAt(in + length + 1) == 0))
+                break;
+
+            ++length;
+        }
+
+        output[out++] = static_cast<std::uint8_t>(length - 1);
+
+        for (std::size_t byte{0}; byte < length; ++byte)
+            output[out++] = byteAt(in + byte);
+
+        in += length;
+    }
+
+    return out;
+}
+
+// Write length zero bytes compressed into output, as compressing them would.
+// Returns the compressed size.
+inline std::size_t writeZeroRuns(std::size_t length, std::span<std::uint8_t> output) {
+    std::size_t out{0};
+
+    for (; length > 0; length -= std::min(length, kZeroRunMaxLength))
+        output[out++] = static_cast<std::uint8_t>(kZeroRunControl + std::min(length, kZeroRunMaxLength) - 1);
+
+    return out;
+}
+
+// Compress input into output, which must hold maxZeroRunCompressedSize(input.size()) bytes.
+// Returns the compressed size.
+inline std::size_t compressZeroRuns(std::span<const std::uint8_t> input, std::span<std::uint8_t> output) {
+    return compressZeroRunsOf<false>(input, {}, output);
+}
+
+// Compress the XOR of input and base (the same size), to be applied to base with xorZeroRuns()
+inline std::size_t compressZeroRunDelta(
+    std::span<const std::uint8_t> input, std::span<const std::uint8_t> base, std::span<std::uint8_t> output
+) {
+    return compressZeroRunsOf<true>(input, base, output);
+}
+
+// Decompress input into output. Returns false unless input is well formed
+// and decompresses to exactly output.size() bytes.
+inline bool decompressZeroRuns(std::span<const std::uint8_t> input, std::span<std::uint8_t> output) {
+    std::size_t in{0};
+    std::size_t out{0};
+
+    while (in < input.size()) {
+        const std::uint8_t control = input[in++];
+
+        if (control >= kZeroRunControl) {
+            const std::size_t length = control - kZeroRunControl + 1;
+
+            if (length > output.size() - out)
+                return false;
+
+            std::ranges::fill(output.subspan(out, length), 0);
+            out += length;
+        } else {
+            const std::size_t length = control + 1;
+
+            if (length > output.size() - out || length > input.size() - in)
+                return false;
+
+            std::ranges::copy(input.subspan(in, length), output.subspan(out).begin());
+            in += length;
+            out += length;
+        }
+    }
+
+    return out == output.size();
+}
+
+// XOR the data compressed in input into output, e.g. to apply a delta.
+// Returns false unless input is well formed and exactly output.size() bytes long.
+inline bool xorZeroRuns(std::span<const std::uint8_t> input, std::span<std::uint8_t> output) {
+    std::size_t in{0};
+    std::size_t out{0};
+
+    while (in < input.size()) {
+        const std::uint8_t control = input[in++];
+
+        if (control >= kZeroRunControl) {
+            // XOR with zero leaves the bytes as they are
+            const std::size_t length = control - kZeroRunControl + 1;
+
+            if (length > output.size() - out)
+                return false;
+
+            out += length;
+        } else {
+            const std::size_t length = control + 1;
+
+            if (length > output.size() - out || length > input.size() - in)
+                return false;
+
+            for (std::size_t byte{0}; byte < length; ++byte)
+                output[out + byte] ^= input[in + byte];
+
+            in += length;
+            out += length;
+        }
+    }
+
+    return out == output.size();
+}
@@ -1,5 +1,6 @@
-#include <chrono>
-#include "SoundTimer.h"
+#include <string>
+#include <stdexcept>
+#include "AudioDevice.h"
 
 // Configuration to produce beep sound
 static constexpr SDL_AudioFormat kFormat = AUDIO_S16SYS;
@@ -31,7 +32,7 @@ static void audioCallback(void* userdata, std::uint8_t* stream, int len) {
 }
 
 // https://wiki.libsdl.org/SDL2/SDL_AudioSpec
-SoundTimer::SoundTimer() {
+AudioDevice::AudioDevice() {
     SDL_zero(m_desired);
 
     // Silence and size values are calculated by SDL
@@ -55,31 +56,15 @@ SoundTimer::SoundTimer() {
         );
 }
 
-SoundTimer::~SoundTimer() {
+AudioDevice::~AudioDevice() {
     SDL_CloseAudioDevice(m_audioDevice);
 }
 
-void SoundTimer::tickTimer() {
-    // Beep when timer is non-zero
-    if (m_timer > 0) {
-        // Beep! (unpause)
-        if (!m_isBeeping) {
-            SDL_PauseAudioDevice(m_audioDevice, kAudioPlay);
-            m_isBeeping = true;
-        }
+void AudioDevice::setBeeping(bool beeping) {
+    if (beeping == m_isBeeping)
+        return;
 
-        // Decrement timer
-        --m_timer;
-    // Pause if speaker is currently beeping
-    } else if (m_isBeeping) {
-        SDL_PauseAudioDevice(m_audioDevice, kAudioPause);
-        m_isBeeping = false;
-    }
-}
-
-void SoundTimer::reset() {
-    // Reset state
-    m_timer = 0;
-    m_isBeeping = false;
+    // Beep! (unpause) or pause if speaker is currently beeping
+    SDL_PauseAudioDevice(m_audioDevice, beeping ? kAudioPlay : kAudioPause);
+    m_isBeeping = beeping;
 }
-
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <SDL.h>
+
+// SDL audio output for the sound timer's beep
+class AudioDevice {
+    static constexpr std::uint8_t kAudioPlay = 0;
+    static constexpr std::uint8_t kAudioPause = 1;
+
+    SDL_AudioSpec m_desired{}, m_obtained{};
+
+    // Initialised in constructor
+    // https://wiki.libsdl.org/SDL2/SDL_OpenAudioDevice
+    SDL_AudioDeviceID m_audioDevice;
+
+    bool m_isBeeping = false;
+
+    public:
+        AudioDevice();
+        ~AudioDevice();
+
+        // The device is owned exclusively by this object
+        AudioDevice(const AudioDevice&) = delete;
+        AudioDevice& operator=(const AudioDevice&) = delete;
+
+        void setBeeping(bool beeping);
+};
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cstring>
+#include <algorithm>
 #include <imgui.h>
 #include <imgui_impl_sdl2.h>
 #include <imgui_impl_sdlrenderer2.h>
@@ -7,6 +8,7 @@
 #include <imgui_internal.h>
 #include <nfd_sdl2.h>
 #include "MainWindow.h"
+#include "../utils/AllocationCounter.h"
 
 // ImGUI flags to make windows unmovable
 constexpr int kLockedWindowFlags =
@@ -122,15 +124,14 @@ void MainWindow::render() {
     }
 }
 
-void MainWindow::clearDisplay() {
-    // Zero out framebuffer to completely clear it
-    std::ranges::fill(m_frameBuffer, 0);
+void MainWindow::updateFrameBuffer(std::span<const std::uint8_t> frameBuffer) {
+    // Copy the emulated framebuffer into the surface's pixels
+    std::ranges::copy(frameBuffer, m_frameBuffer.begin());
 
     // Update frame
     m_pixelsModified = true;
 }
 
-
 NFD::UniquePath MainWindow::openFileBrowser() {
     NFD::UniquePath outPath;
     nfdfilteritem_t fileTypeFilter[1] = {
@@ -254,6 +255,13 @@ void MainWindow::drawUI(Chip8DebugData debugInfo) {
     );
     static MemoryEditor memoryViewer;
 
+    // Route edits through the interpreter rather than writing memory directly
+    memoryViewer.UserData = &debugInfo.writeMemory;
+    memoryViewer.WriteFn = [](ImU8*, size_t offset, ImU8 data, void* userData) {
+        auto& writeMemory = *static_cast<std::function<void(std::uint16_t, std::uint8_t)>*>(userData);
+        writeMemory(static_cast<std::uint16_t>(offset), data);
+    };
+
     std::span<std::uint8_t> memory = debugInfo.memory;
     memoryViewer.DrawContents(
         memory.data(), memory.size()
@@ -313,6 +321,10 @@ void MainWindow::drawUI(Chip8DebugData debugInfo) {
         ImGui::Text("Index: %d", debugInfo.index);
         ImGui::Text("PC: %d", debugInfo.PC);
 
+        // Heap allocations of the last frame, in HOTCHIP_COUNT_ALLOCATIONS builds
+        if (kAllocationCounting)
+            ImGui::Text("Allocations: %llu", static_cast<unsigned long long>(debugInfo.frameAllocations));
+
         ImGui::EndTable();
     }
 
@@ -330,9 +342,21 @@ void MainWindow::drawUI(Chip8DebugData debugInfo) {
         ImGui::TableSetupColumn("Instructions");
         ImGui::TableHeadersRow();
 
-        // Add instructions to history toolbar in reverse order, so newest are at the top
-        for (std::uint16_t i{m_instructionHistory.size()}; i-- > 0;)
-            ImGui::Text("%s", m_instructionHistory[i].c_str());
+        // Add instructions to history toolbar in reverse order, so newest are at the top.
+        // The clipper skips rows outside the panel, which are never formatted.
+        const std::uint16_t historySize = m_instructionHistory.size();
+        ImGuiListClipper clipper;
+        clipper.Begin(historySize);
+
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                const InstructionTrace& trace = m_instructionHistory[historySize - 1 - row];
+
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::Text("%s", formatInstructionTrace(trace).c_str());
+            }
+        }
 
         ImGui::EndTable();
     }
@@ -358,70 +382,12 @@ void MainWindow::drawUI(Chip8DebugData debugInfo) {
     SDL_RenderPresent(m_renderer);
 }
 
-// Start a position x, XOR x and the 7 following bits with rowData.
-// If the next 7 bits are in the following byte, continue flipping bits
-// in the second byte until the sprite byte is drawn.
-bool MainWindow::drawRow(int x_index, int y_index, std::uint8_t rowData) {
-    // If position values exceed screen limits, wrap around.
-    x_index %= kScreenWidth;
-    y_index %= kScreenHeight;
-
-    // Return true if any set bit becomes unset
-    bool bitUnset = false;
-
-    // Framebuffer has been modified, pixels await being drawn
-    m_pixelsModified = true;
-
-    // Y position is multiplied by the pitch (bytes per row)
-    // Then we add the floor division of index / 8 to find the pixel's
-    // corresponding byte (8 pixels per byte)
-    std::uint8_t pos = (kScreenPitch * y_index) + x_index / 8;
-
-    // Determine bit index within byte
-    std::uint8_t bitPos = x_index % 8;
-
-    // Create XOR mask for first byte (unused bits are unset)
-    std::uint8_t firstXOR = rowData >> bitPos;
-    std::uint8_t& row = m_frameBuffer[pos];
-
-    // AND the current row with the mask.
-    // If two bits match, a set bit is flipped,T
-    // making the AND operation nonzero.
-    if ((row & firstXOR) != 0) {
-        bitUnset = true;
-    }
-
-    // XOR the first byte to flip pixels
-    row ^= firstXOR;
-
-    // The starting bit wasn't at the beginning of a byte,
-    // we must continue flipping bits in the next byte
-    // to complete the drawing of the sprite byte.
-    if (bitPos != 0) {
-        // Set up new mask
-        std::uint8_t secondXOR = rowData << (8 - bitPos);
-
-        // Move to the next byte
-        ++pos;
-        std::uint8_t& nextRow = m_frameBuffer[pos];
-
-        if ((nextRow & secondXOR) != 0) {
-            bitUnset = true;
-        }
-
-        // XOR the second byte to flip pixels
-        nextRow ^= secondXOR;
-    }
-
-    return bitUnset;
-}
-
 std::string_view MainWindow::getROM() {
     return m_desiredROMPath;
 }
 
-void MainWindow::pushInstructionHistory(const std::string& instruction) {
-    m_instructionHistory.push(instruction);
+void MainWindow::pushInstructionTrace(const InstructionTrace& trace) {
+    m_instructionHistory.push(trace);
 }
 
 MainWindow::~MainWindow() {
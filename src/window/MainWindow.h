@@ -4,6 +4,7 @@
 #include <SDL.h>
 #include <nfd.hpp>
 #include "../interpreter/Chip8DebugData.h"
+#include "../interpreter/InstructionTrace.h"
 
 class MainWindow {
     // Window resolution constants
@@ -15,7 +16,6 @@ class MainWindow {
 
     // Divide pixel count by 8 for byte amount. (8 pixels per byte)
     static constexpr int kPackedPixelCount = kPixelCount / 8;
-    static constexpr int kScreenPitch = kScreenWidth / 8;
 
     // The amount of instructions to be saved in the history toolbar.
     // Power of 2 is used for performant modulo operation.
@@ -34,8 +34,8 @@ class MainWindow {
     // Once m_desiredROMPath updates, Chip8 loads the ROM at that path.
     std::string m_desiredROMPath{};
 
-    // Instruction history for debug UI
-    RingBuffer<std::string, kInstructionHistorySize> m_instructionHistory{};
+    // Instruction history for debug UI, formatted only for the rows on screen
+    RingBuffer<InstructionTrace, kInstructionHistorySize> m_instructionHistory{};
 
     // Only render pixels to the screen if the framebuffer has updated
     bool m_pixelsModified = false;
@@ -44,10 +44,9 @@ class MainWindow {
         MainWindow(std::string_view ROMPath);
         ~MainWindow();
         void render();
-        void clearDisplay();
         void drawUI(Chip8DebugData debugInfo);
-        void pushInstructionHistory(const std::string& instruction);
-        bool drawRow(int x_index, int y_index, std::uint8_t rowData);
+        void pushInstructionTrace(const InstructionTrace& trace);
+        void updateFrameBuffer(std::span<const std::uint8_t> frameBuffer);
         std::string_view getROM();
         static NFD::UniquePath openFileBrowser();
 };
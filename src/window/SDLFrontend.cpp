@@ -0,0 +1,413 @@
+#include <format>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <imgui_impl_sdl2.h>
+#include "SDLFrontend.h"
+
+SDLFrontend::SDLFrontend(MainWindow& window)
+	: m_window{window}
+	, m_saveStates{std::string{window.getROM()}}
+{
+    #if defined(_WIN64)
+    	// Initialise high resolution timer on Windows
+		m_winTimerHandle = CreateWaitableTimerExW(nullptr, nullptr,
+			CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+			TIMER_ALL_ACCESS
+		);
+    #endif
+}
+
+void SDLFrontend::presentFrame(std::span<const std::uint8_t> frameBuffer) {
+	m_window.updateFrameBuffer(frameBuffer);
+}
+
+void SDLFrontend::setBeeping(bool beeping) {
+	m_audioDevice.setBeeping(beeping);
+}
+
+void SDLFrontend::pushInstructionTrace(const InstructionTrace& trace) {
+	m_window.pushInstructionTrace(trace);
+}
+
+void SDLFrontend::setRunAheadFrames(std::uint32_t frames) {
+	m_runAhead.setFrames(frames);
+}
+
+void SDLFrontend::recordMovie(std::string path) {
+	m_moviePath = std::move(path);
+}
+
+void SDLFrontend::playMovie(const std::string& path) {
+	m_movie = readMovieFile(path);
+}
+
+void SDLFrontend::playNetplay(
+	std::uint8_t player, std::uint16_t port, const std::string& peerHost, std::uint16_t peerPort,
+	std::uint32_t inputDelay
+) {
+	m_netplayTransport.emplace(port, peerHost, peerPort);
+	m_netplayPlayer = player;
+	m_netplayInputDelay = inputDelay;
+}
+
+void SDLFrontend::setKeyState(Chip8& interpreter, std::uint8_t key, bool pressed) {
+	// Keys are sent to the other player, and pressed on their frame
+	if (m_netplay) {
+		m_netplay->setKeyState(key, pressed);
+		return;
+	}
+
+	// The movie plays the keypad until it ends
+	if (isPlayingMovie())
+		return;
+
+	if (m_movieRecorder)
+		m_movieRecorder->setKeyState(interpreter, key, pressed);
+	else
+		interpreter.setKeyState(key, pressed);
+}
+
+void SDLFrontend::finishMovie() {
+	if (m_movieRecorder) {
+		try {
+			writeMovieFile(m_moviePath, m_movieRecorder->getMovie());
+		} catch (const std::exception& e) {
+			logText(LogLevel::Error, std::format(
+				"Failed to write the movie of {} frames: {}", m_movieRecorder->getMovie().frameCount, e.what()
+			));
+		}
+	}
+
+	m_movieRecorder.reset();
+	m_moviePlayer.reset();
+	m_movie.reset();
+}
+
+bool SDLFrontend::connectNetplay(Chip8& interpreter) {
+	m_netplay.emplace(interpreter, *m_netplayTransport, m_netplayPlayer, m_netplayInputDelay);
+	logMessage(LogLevel::Debug, "Waiting for player {} to connect", 2 - m_netplayPlayer);
+
+	try {
+		while (!m_netplay->connect()) {
+			while (SDL_PollEvent(&m_event)) {
+				ImGui_ImplSDL2_ProcessEvent(&m_event);
+
+				if (m_event.type == SDL_QUIT) {
+					m_windowClosed = true;
+					return false;
+				}
+			}
+
+			m_window.render();
+			m_window.drawUI(interpreter.getDebugData());
+			std::this_thread::sleep_for(kFrameDuration);
+		}
+	} catch (const std::runtime_error&) {
+		logMessage(LogLevel::Error, "Player {} is running a different ROM, playing alone", 2 - m_netplayPlayer);
+		m_netplay.reset();
+	}
+
+	return true;
+}
+
+void SDLFrontend::stepNetplay() {
+	m_netplay->step();
+
+	if (m_netplay->isDisconnected())
+		logMessage(LogLevel::Error, "Player {} disconnected at frame {}", 2 - m_netplayPlayer, m_netplay->getFrame());
+	else if (m_netplay->isDesynced())
+		logMessage(LogLevel::Error, "Desynced from player {} at frame {}", 2 - m_netplayPlayer, m_netplay->getFrame());
+	else
+		return;
+
+	// Play on alone
+	m_netplay.reset();
+}
+
+void SDLFrontend::start(Chip8& interpreter) {
+	#if defined(_WIN64)
+		// Request Windows to allow this program to use higher precision sleep timing.
+		timeBeginPeriod(1);
+	#endif
+
+	// Movies start from the state the interpreter is in now
+	if (!m_moviePath.empty())
+		m_movieRecorder.emplace(interpreter);
+
+	if (m_movie)
+		m_moviePlayer.emplace(*m_movie, interpreter);
+
+	if (m_netplayTransport && !connectNetplay(interpreter))
+		return;
+
+	// Run emulator until window closes
+	while (!m_windowClosed) {
+		executionLoop(interpreter);
+
+		// Movies and netplay only cover the first ROM
+		finishMovie();
+		m_netplay.reset();
+		m_netplayTransport.reset();
+
+		/*
+		 * If the last emulation ended but the window didn't close,
+		 * we know the emulation ended because the user
+		 * requested a new ROM to be loaded.
+		*/
+		if (!m_windowClosed) {
+			// Reset emulator state and load the ROM requested by the UI
+			interpreter.openROM(m_window.getROM());
+			m_saveStates.setFilePrefix(std::string{m_window.getROM()});
+			m_rewindBuffer.clear();
+		}
+	}
+}
+
+void SDLFrontend::executionLoop(Chip8& interpreter) {
+	// Fetch/decode/execute loop
+	while (!m_windowClosed) {
+		// * frame begins here *
+		const auto frameStart = std::chrono::steady_clock::now();
+
+		// Check if user has loaded a new ROM
+		if (interpreter.getROMPath() != m_window.getROM()) {
+			return;
+		}
+
+		if (interpreter.isFinished()) {
+			// Sleep until the user closes the window
+			SDL_WaitEvent(&m_event);
+
+			if (m_event.type == SDL_QUIT) {
+				m_windowClosed = true;
+				return;
+			}
+		} else {
+			// Get user inputs to update keyboard state at frame start
+			while (SDL_PollEvent(&m_event)) {
+				// Pass event to ImGUI
+				ImGui_ImplSDL2_ProcessEvent(&m_event);
+
+				// Scancode of key (zero if event is not a keypress)
+				SDL_Scancode& scanCode = m_event.key.keysym.scancode;
+
+				// Terminate execution on window close event
+				if (m_event.type == SDL_QUIT) {
+					m_windowClosed = true;
+					return;
+				}
+
+				// Rewind while Backspace is held, except in netplay where the other player can't,
+				// or while a movie plays, which would carry on from the wrong state
+				if ((m_event.type == SDL_KEYDOWN || m_event.type == SDL_KEYUP)
+					&& scanCode == SDL_SCANCODE_BACKSPACE) {
+					m_rewinding = m_event.type == SDL_KEYDOWN && !m_netplay && !isPlayingMovie();
+					continue;
+				}
+
+				// Save state hotkeys aren't passed on to the keypad
+				if (m_event.type == SDL_KEYDOWN && handleSaveStateKey(interpreter, m_event.key))
+					continue;
+
+				// Update key state to pressed
+				if (m_event.type == SDL_KEYDOWN) {
+					setKeyState(interpreter, scanCodeToPos(scanCode), true);
+
+				// Update key state to not pressed
+				} else if (m_event.type == SDL_KEYUP) {
+					setKeyState(interpreter, scanCodeToPos(scanCode), false);
+				}
+			}
+		}
+
+		if (m_netplay) {
+			// Runs the frame, and any rolled back
+			stepNetplay();
+		} else if (m_rewinding) {
+			// Step back a frame, staying on the oldest once reached
+			if (m_rewindBuffer.rewind(interpreter)) {
+				m_window.updateFrameBuffer(interpreter.getFrameBuffer());
+
+				if (m_movieRecorder)
+					m_movieRecorder->keyframe(interpreter);
+			}
+		} else {
+			if (m_moviePlayer)
+				m_moviePlayer->beginFrame(interpreter);
+
+			// Execute one frame's worth of instructions and tick timers
+			const std::span<const std::uint8_t> frameBuffer = m_runAhead.step(interpreter);
+
+			// Replace the frame presented by the interpreter with the one run ahead
+			if (m_runAhead.getFrames() != 0)
+				m_window.updateFrameBuffer(frameBuffer);
+
+			// Record the frame to rewind to (doesn't allocate)
+			m_rewindBuffer.push(interpreter);
+
+			if (m_movieRecorder)
+				m_movieRecorder->endFrame(interpreter);
+		}
+
+		// Render frame (no change if no draw/clear calls made)
+		m_window.render();
+
+		// Render ImGUI UI
+		m_window.drawUI(interpreter.getDebugData());
+
+		/*
+		 * Busy waiting logic is derived from Dolphin Emulator:
+		 * (permissible under GPL-2.0-or-later)
+		 * https://github.com/dolphin-emu/dolphin/blob/master/Source/Core/Common/Timer.cpp
+		 *
+		 * Windows implementation is informed by Blat Blatnik's research on high-accuracy sleep:
+		 * https://blog.bearcats.nl/perfect-sleep-function/
+		 */
+
+		 /*
+		 * 1 millisecond of spin time seems like a good balance between
+		 * accuracy and performance on both Windows and Linux.
+		 */
+		constexpr auto spinDuration = std::chrono::milliseconds{1};
+
+		// The expected end time of the frame
+		const auto frameEnd = frameStart + kFrameDuration;
+
+		// Actual end time of the frame
+		const auto frameComplete = std::chrono::steady_clock::now();
+
+		// If the frame completed with time to spare, sleep until the next frame
+		if (frameComplete < frameEnd) {
+			#if defined(_WIN64)
+				// SetWaitableTimerEx takes time in "100 nanosecond intervals". (Credit: Dolphin)
+				using winTimeFormat = std::chrono::duration<LONGLONG, std::ratio<100, std::nano::den>::type>;
+
+				/*
+				 * From Blat Blatnik's blog:
+				 *
+				 * "Also, [CreateWaitableTimerEx] has a quirk that if you request a sleep
+				 * period longer than the system timer period, the precision of the timer plummets."
+				 *
+				 * We limit the sleep to 95% of the time period to avoid this quirk.
+				 */
+				constexpr auto kMaxTicks =
+					duration_cast<winTimeFormat>(spinDuration) * 95 / 100;
+
+				/*
+				 * Loop using high precision sleep until end of frame is reached,
+				 * to avoid oversleep and achieve high accuracy.
+				 */
+				while (true) {
+					const auto timeNow = std::chrono::steady_clock::now();
+					const auto sleepDuration = frameEnd - timeNow - spinDuration;
+
+					// Limit maximum sleep duration to kMaxTicks (95% of 1 millisecond)
+					const auto ticks = std::min(
+						duration_cast<winTimeFormat>(sleepDuration), kMaxTicks
+					).count();
+
+					if (ticks <= 0)
+						// Sleep time has finished, spin the rest
+						break;
+
+					// Negate ticks to make Windows use relative time
+					const LARGE_INTEGER due_time{.QuadPart = -ticks};
+					SetWaitableTimerEx(
+						m_winTimerHandle, &timerDue, 0, nullptr,
+						nullptr, nullptr, 0
+					);
+
+					// Wait for timer. Use INFINITE to disable timeout.
+					WaitForSingleObject(m_winTimerHandle, INFINITE);
+				}
+			#else
+				// sleep_until on Linux provides high accuracy
+				const auto sleepPoint = frameEnd - spinDuration;
+
+				std::this_thread::sleep_until(sleepPoint);
+			#endif
+
+			// Report oversleeps for debugging
+			if (kDebugEnabled) {
+				const auto timeNow = std::chrono::steady_clock::now();
+
+				if (timeNow > frameEnd) {
+					// The amount of microseconds overslept by
+					const auto oversleepDuration =
+						std::chrono::duration_cast<std::chrono::microseconds>(
+							timeNow - frameEnd
+						).count();
+
+					logMessage(LogLevel::Debug, "Overslept! {} microseconds late.", oversleepDuration);
+				}
+			}
+
+			// Spin for the remaining time
+			while (std::chrono::steady_clock::now() < frameEnd) {
+				#if defined(_WIN32)
+					YieldProcessor();
+				#else
+					std::this_thread::yield();
+				#endif
+			}
+		} else if (kDebugEnabled) {
+			// The amount of milliseconds the frame was late by
+			const auto frameLag =
+				std::chrono::duration_cast<std::chrono::milliseconds>(
+					frameComplete - frameEnd
+				).count();
+
+			logMessage(LogLevel::Debug, "Slow frame! {} milliseconds late.", frameLag);
+		}
+	}
+}
+
+bool SDLFrontend::handleSaveStateKey(Chip8& interpreter, const SDL_KeyboardEvent& key) {
+	if (key.keysym.scancode < SDL_SCANCODE_F1 || key.keysym.scancode > SDL_SCANCODE_F4)
+		return false;
+
+	// Ignore key repeat, a held key saves or loads once
+	if (key.repeat)
+		return true;
+
+	const std::size_t slot = key.keysym.scancode - SDL_SCANCODE_F1;
+
+	if (key.keysym.mod & KMOD_SHIFT) {
+		m_saveStates.save(slot, interpreter);
+		return true;
+	}
+
+	// A loaded state would desync the other player
+	if (m_netplay) {
+		logMessage(LogLevel::Error, "Save states can't be loaded in netplay");
+		return true;
+	}
+
+	// The rest of the movie would play from a state it wasn't recorded from
+	if (isPlayingMovie()) {
+		logMessage(LogLevel::Error, "Save states can't be loaded while a movie plays");
+		return true;
+	}
+
+	try {
+		if (!m_saveStates.load(slot, interpreter))
+			logMessage(LogLevel::Error, "Save state slot {} is empty", slot + 1);
+		else if (m_movieRecorder)
+			// A loaded state can't be reached by replaying input
+			m_movieRecorder->keyframe(interpreter);
+	} catch (const std::runtime_error& e) {
+		logText(LogLevel::Error, std::format("Failed to load save state slot {}: {}", slot + 1, e.what()));
+	}
+
+	return true;
+}
+
+SDLFrontend::~SDLFrontend() {
+	#if defined(_WIN32)
+		CloseHandle(m_winTimerHandle);
+
+		// Restore timer resolution
+		timeBeginPeriod(1);
+	#endif
+}
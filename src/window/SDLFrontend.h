@@ -0,0 +1,161 @@
+#pragma once
+
+#include <SDL.h>
+#include <string>
+#include <optional>
+#include "MainWindow.h"
+#include "AudioDevice.h"
+#include "../interpreter/Chip8.h"
+#include "../interpreter/RewindBuffer.h"
+#include "../interpreter/RunAhead.h"
+#include "../interpreter/InputMovie.h"
+#include "../interpreter/SaveStateSlots.h"
+#include "../interpreter/netplay/UdpTransport.h"
+#include "../interpreter/netplay/RollbackSession.h"
+
+// For Windows platform-specific timing
+#if defined(_WIN64)
+	#include <Windows.h>
+	#include <timeapi.h>
+#endif
+
+/*
+ * Desktop frontend for the emulation core.
+ *
+ * Owns the real-time loop: polls SDL input, steps the interpreter
+ * one frame at a time and paces execution to 60fps.
+ */
+class SDLFrontend final : public Chip8Frontend {
+    // Assume 60fps constant frame timing for now.
+    static constexpr auto kFrameDuration = std::chrono::duration<double>(1.0 / 60.0);
+
+    // Handle to waitable timer object for Windows
+    #if defined(_WIN64)
+        HANDLE m_winTimerHandle = nullptr;
+    #endif
+
+    MainWindow& m_window;
+    AudioDevice m_audioDevice;
+
+    // Save state slots of the loaded ROM, F1-F4 load and Shift+F1-F4 save
+    SaveStateSlots m_saveStates;
+
+    // The last 60 seconds of frames, rewound while Backspace is held
+    RewindBuffer m_rewindBuffer;
+    bool m_rewinding = false;
+
+    // Shows frames ahead of the emulated one, off unless set
+    RunAhead m_runAhead;
+
+    // Movie recorded from the start of the first ROM, written to m_moviePath when it closes
+    std::optional<MovieRecorder> m_movieRecorder;
+    std::string m_moviePath;
+
+    // Movie played on the first ROM, replacing keypad input, rewind and save state loads until it ends
+    std::optional<Movie> m_movie;
+    std::optional<MoviePlayer> m_moviePlayer;
+
+    // Netplay with another player on the first ROM, replacing rewind and save state loads
+    std::optional<UdpTransport> m_netplayTransport;
+    std::optional<RollbackSession> m_netplay;
+    std::uint8_t m_netplayPlayer{0};
+    std::uint32_t m_netplayInputDelay{0};
+
+    // Whether the user has closed the window
+    bool m_windowClosed = false;
+
+    // For handling user input events
+    SDL_Event m_event{};
+
+    static std::uint8_t scanCodeToPos(SDL_Scancode scanCode) {
+        std::uint8_t pos{0};
+
+        /*
+         * All 16 buttons used for the Chip-8 keypad.
+         * Order of enum maps to array index.
+         *
+         * Scancodes are used over key names for
+         * consistency across keyboards layouts.
+         */
+        switch(scanCode) {
+            case SDL_SCANCODE_1: pos = 0x1; break;
+            case SDL_SCANCODE_2: pos = 0x2; break;
+            case SDL_SCANCODE_3: pos = 0x3; break;
+            case SDL_SCANCODE_4: pos = 0xC; break;
+            case SDL_SCANCODE_Q: pos = 0x4; break;
+            case SDL_SCANCODE_W: pos = 0x5; break;
+            case SDL_SCANCODE_E: pos = 0x6; break;
+            case SDL_SCANCODE_R: pos = 0xD; break;
+            case SDL_SCANCODE_A: pos = 0x7; break;
+            case SDL_SCANCODE_S: pos = 0x8; break;
+            case SDL_SCANCODE_D: pos = 0x9; break;
+            case SDL_SCANCODE_F: pos = 0xE; break;
+            case SDL_SCANCODE_Z: pos = 0xA; break;
+            case SDL_SCANCODE_X: pos = 0x0; break;
+            case SDL_SCANCODE_C: pos = 0xB; break;
+            case SDL_SCANCODE_V: pos = 0xF; break;
+
+            // Unused key
+            default: break;
+        }
+
+        return pos;
+    }
+
+    // Whether a movie is playing and hasn't ended
+    [[nodiscard]] bool isPlayingMovie() const {
+        return m_moviePlayer && !m_moviePlayer->isFinished();
+    }
+
+    // Save or load a state if the key is F1-F4, returns whether it was
+    bool handleSaveStateKey(Chip8& interpreter, const SDL_KeyboardEvent& key);
+
+    // Pass a keypad event on to the interpreter, through the movie recorder if recording
+    void setKeyState(Chip8& interpreter, std::uint8_t key, bool pressed);
+
+    // Write the recorded movie and stop recording and playing
+    void finishMovie();
+
+    // Wait for the other player, rendering and polling for the window to close.
+    // Returns false if it closed.
+    bool connectNetplay(Chip8& interpreter);
+
+    // Run the next netplay frame, ending netplay if the other player left or desynced
+    void stepNetplay();
+
+    /*
+     * Main execution loop of the emulator.
+     *
+     * The state of the window (closed or running)
+     * determines whether the emulation is still running.
+     */
+    void executionLoop(Chip8& interpreter);
+
+    public:
+        explicit SDLFrontend(MainWindow& window);
+        ~SDLFrontend() override;
+
+        // Run the interpreter in real time until the window closes
+        void start(Chip8& interpreter);
+
+        // Show the frame this many frames ahead, to hide input lag (see RunAhead)
+        void setRunAheadFrames(std::uint32_t frames);
+
+        // Record the session of the first ROM, from when start() is called, to a movie file
+        void recordMovie(std::string path);
+
+        // Play a movie on the first ROM from when start() is called.
+        // Throws std::runtime_error if the file isn't a valid movie.
+        void playMovie(const std::string& path);
+
+        // Play the first ROM with another player over UDP (see RollbackSession) from when start() is called.
+        // Throws std::runtime_error if the port can't be bound or the peer resolved.
+        void playNetplay(
+            std::uint8_t player, std::uint16_t port, const std::string& peerHost, std::uint16_t peerPort,
+            std::uint32_t inputDelay
+        );
+
+        void presentFrame(std::span<const std::uint8_t> frameBuffer) override;
+        void setBeeping(bool beeping) override;
+        void pushInstructionTrace(const InstructionTrace& trace) override;
+};
@@ -0,0 +1,241 @@
+#include <random>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include "../src/interpreter/Chip8.h"
+#include "../src/interpreter/SaveState.h"
+#include "../src/interpreter/InputMovie.h"
+#include "../src/interpreter/RewindBuffer.h"
+#include "../src/utils/ZeroRunLength.h"
+
+/*
+ * Tests of the formats states are kept in: save states, ZeroRunLength.h
+ * compression, the rewind buffer and movies. Run by ctest, exits with the
+ * amount of failed checks.
+ *
+ * Usage: hotchip-format-tests <ROM>
+ */
+
+static int failures = 0;
+
+static void check(bool passed, std::string_view what) {
+    if (!passed) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+// Whether decode throws std::runtime_error for data
+template<typename Decode>
+static bool rejects(Decode decode, std::span<const std::uint8_t> data) {
+    try {
+        (void) decode(data);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+
+    return false;
+}
+
+static std::vector<std::uint8_t> stateOf(const Chip8& chip8) {
+    SaveState state;
+    chip8.saveState(state);
+    return encodeSaveState(state);
+}
+
+// Run frames with random keypad presses, the same for the same seed
+static void play(Chip8& chip8, std::uint32_t frames, std::mt19937& random) {
+    for (std::uint32_t frame{0}; frame < frames; ++frame) {
+        chip8.setKeyState(static_cast<std::uint8_t>(random() % 16), random() % 2 == 0);
+        chip8.step();
+    }
+}
+
+static void testZeroRuns() {
+    std::mt19937 random{1};
+
+    // Runs of zeros and literals of every length, crossing the longest run
+    for (std::size_t size : {0, 1, 127, 128, 129, 300, 4096}) {
+        std::vector<std::uint8_t> data(size);
+        std::vector<std::uint8_t> base(size);
+
+        for (std::size_t byte{0}; byte < size; ++byte) {
+            data[byte] = random() % 3 == 0 ? static_cast<std::uint8_t>(random()) : 0;
+            base[byte] = random() % 8 == 0 ? static_cast<std::uint8_t>(random()) : data[byte];
+        }
+
+        std::vector<std::uint8_t> compressed(maxZeroRunCompressedSize(size));
+        std::vector<std::uint8_t> decompressed(size);
+        compressed.resize(compressZeroRuns(data, compressed));
+
+        check(decompressZeroRuns(compressed, decompressed) && decompressed == data, "zero runs round trip");
+
+        compressed.resize(maxZeroRunCompressedSize(size));
+        compressed.resize(compressZeroRunDelta(data, base, compressed));
+        decompressed = base;
+
+        check(xorZeroRuns(compressed, decompressed) && decompressed == data, "zero run delta round trip");
+
+        if (size > 0) {
+            check(!decompressZeroRuns(std::span{compressed}.first(compressed.size() - 1), decompressed),
+                "truncated zero runs rejected");
+        }
+    }
+
+    std::vector<std::uint8_t> zeros(4096);
+    std::vector<std::uint8_t> compressed(maxZeroRunCompressedSize(zeros.size()));
+    check(compressZeroRuns(zeros, compressed) == writeZeroRuns(zeros.size(), compressed), "zero runs written as compressed");
+    check(compressZeroRuns(zeros, compressed) == 32, "4 KB of zeros compress to 32 bytes");
+
+    // A literal run longer than the data left
+    const std::array<std::uint8_t, 2> overrun{0x7F, 0x01};
+    std::array<std::uint8_t, 128> output{};
+    check(!decompressZeroRuns(overrun, output), "literal run past the input rejected");
+}
+
+static void testSaveStates(const std::string& ROMPath) {
+    Chip8 chip8{ROMPath};
+    std::mt19937 random{2};
+    play(chip8, 300, random);
+
+    const std::vector<std::uint8_t> encoded = stateOf(chip8);
+    const SaveState decoded = decodeSaveState(encoded);
+    check(encodeSaveState(decoded) == encoded, "save state round trip");
+
+    // Loading the state and running on matches running on without it
+    Chip8 loaded{ROMPath};
+    loaded.loadState(decoded);
+    std::mt19937 continued = random;
+    play(chip8, 300, random);
+    play(loaded, 300, continued);
+    check(stateOf(loaded) == stateOf(chip8), "loaded save state runs the same");
+
+    for (std::size_t size{0}; size < encoded.size(); ++size)
+        check(rejects(decodeSaveState, std::span{encoded}.first(size)), "truncated save state rejected");
+
+    std::vector<std::uint8_t> corrupt = encoded;
+    corrupt[0] ^= 1;
+    check(rejects(decodeSaveState, corrupt), "save state magic checked");
+
+    corrupt = encoded;
+    corrupt[4] ^= 1;
+    check(rejects(decodeSaveState, corrupt), "save state version checked");
+
+    corrupt = encoded;
+    corrupt.push_back(0);
+    check(rejects(decodeSaveState, corrupt), "save state with trailing bytes rejected");
+
+    // A stack pointer past the stack
+    SaveState invalid = decoded;
+    invalid.stackSize = 17;
+    check(rejects(decodeSaveState, encodeSaveState(invalid)), "save state out of range rejected");
+}
+
+static void testRewind(const std::string& ROMPath) {
+    Chip8 chip8{ROMPath};
+    const auto buffer = std::make_unique<RewindBuffer>();
+    std::mt19937 random{3};
+
+    // The state of every frame recorded, to compare rewinding against
+    std::vector<std::vector<std::uint8_t>> states;
+
+    for (int round{0}; round < 50; ++round) {
+        for (std::uint32_t frame = random() % 200; frame > 0; --frame) {
+            play(chip8, 1, random);
+            buffer->push(chip8);
+            states.push_back(stateOf(chip8));
+        }
+
+        states.erase(states.begin(), states.end() - static_cast<std::ptrdiff_t>(buffer->getFrameCount()));
+
+        for (std::uint32_t frame = random() % 100; frame > 0 && buffer->rewind(chip8); --frame)
+            states.pop_back();
+
+        check(stateOf(chip8) == states.back(), "rewound to the state recorded");
+    }
+
+    check(buffer->getFrameCount() <= RewindBuffer::kMaxFrames, "rewind buffer bounded");
+
+    while (buffer->rewind(chip8))
+        states.pop_back();
+
+    check(states.size() == 1 && stateOf(chip8) == states.front(), "rewound to the oldest frame");
+}
+
+static void testMovies(const std::string& ROMPath) {
+    Chip8 chip8{ROMPath};
+    chip8.setRandomSeed(4);
+    MovieRecorder recorder{chip8};
+    std::mt19937 random{4};
+
+    // Past several keyframes, with a state replaced midway as loading a save state does
+    SaveState saved;
+
+    for (std::uint32_t frame{0}; frame < 2000; ++frame) {
+        if (frame == 700)
+            chip8.saveState(saved);
+
+        if (frame == 1300) {
+            chip8.loadState(saved);
+            recorder.keyframe(chip8);
+        }
+
+        recorder.setKeyState(chip8, static_cast<std::uint8_t>(random() % 16), random() % 2 == 0);
+        chip8.step();
+        recorder.endFrame(chip8);
+    }
+
+    const std::vector<std::uint8_t> encoded = encodeMovie(recorder.getMovie());
+    const Movie movie = decodeMovie(encoded);
+    check(encodeMovie(movie) == encoded, "movie round trip");
+
+    Chip8 played{ROMPath};
+    MoviePlayer player{movie, played};
+
+    while (player.step(played)) {}
+
+    check(stateOf(played) == stateOf(chip8), "movie replays the recorded session");
+
+    Chip8 seeked{ROMPath};
+    MoviePlayer seeker{movie, seeked};
+    seeker.seek(seeked, 1500);
+
+    while (seeker.step(seeked)) {}
+
+    check(stateOf(seeked) == stateOf(chip8), "seeked movie replays the recorded session");
+
+    for (std::size_t size{0}; size < encoded.size(); size += 1 + size / 64)
+        check(rejects(decodeMovie, std::span{encoded}.first(size)), "truncated movie rejected");
+
+    std::vector<std::uint8_t> corrupt = encoded;
+    corrupt[4] ^= 1;
+    check(rejects(decodeMovie, corrupt), "movie version checked");
+
+    corrupt = encoded;
+    corrupt.push_back(0);
+    check(rejects(decodeMovie, corrupt), "movie with trailing bytes rejected");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: hotchip-format-tests <ROM>" << std::endl;
+        return 1;
+    }
+
+    try {
+        testZeroRuns();
+        testSaveStates(argv[1]);
+        testRewind(argv[1]);
+        testMovies(argv[1]);
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (failures == 0)
+        std::cout << "All checks passed" << std::endl;
+
+    return failures;
+}